@@ -59,6 +59,9 @@ bool AppDelegate::applicationDidFinishLaunching() {
     // set FPS. the default value is 1.0/60 if you don't call this
     director->setAnimationInterval(1.0 / 60);
 
+    // nothing in the game reads the deprecated matrix stack, skip loading it for every node
+    director->setLegacyMatrixStackEnabled(false);
+
     // create a scene. it's an autorelease object
     //auto scene = LoadingScene::createScene();
     auto scene = MainMenuScene::createScene();
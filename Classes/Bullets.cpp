@@ -31,68 +31,255 @@
 #include "ParticleManager.h"
 #include "Sprite3DEffect.h"
 
-bool Bullet::init()
+void Bullet::setVector(Vec2 vec)
 {
-    _Model = Sprite::create("bullets.png", Rect(5,8,24,32));
-    //_Model = ParticleSystemQuad::create("missileFlare.plist");
-    if(_Model)
+    _vector = vec;
+}
+
+Vec2 Bullet::getVector()
+{
+    return _vector;
+}
+void Bullet::reset()
+{
+    setRotation(0);
+}
+
+namespace {
+    V3F_C4B_T2F_Quad centeredQuad(Sprite* sprite, float scale)
     {
-        addChild(_Model);
-        _radius=10;
-        _type = kEnemyBullet;
-        _owner = kEnemy;
-        _damage = 10;
-        
-        auto part_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonFlare.png");
-        ValueMap vm=ParticleManager::getInstance()->GetPlistData("missileFlare");
-        ParticleSystemQuad *p = ParticleSystemQuad::create(vm);
-        //p->setDisplayFrame(part_frame);
-        p->setTextureWithRect(part_frame->getTexture(), part_frame->getRect());
-        //p->setEndColor(Color4F(1,0,0,1));
-        //p->setStartColor(Color4F(1,0,0,1));
-        p->setPositionType(tPositionType::GROUPED);
-        p->setScale(2.5);
-        p->setTotalParticles(2);
-        _Model->addChild(p,-1);
-        p->setPosition(Vec2(_Model->getContentSize()/2));
-        setScale(1.5);
-        //static_cast<Sprite*>(_Model)->setFlippedY(true);
-        return true;
+        V3F_C4B_T2F_Quad quad = sprite->getQuad();
+        Vec2 center = Vec2(sprite->getContentSize()/2);
+        V3F_C4B_T2F* corners[4] = {&quad.tl, &quad.bl, &quad.tr, &quad.br};
+        for(auto corner : corners)
+        {
+            corner->vertices.x = (corner->vertices.x-center.x)*scale;
+            corner->vertices.y = (corner->vertices.y-center.y)*scale;
+        }
+        return quad;
+    }
+
+    template<typename T> void swapPop(std::vector<T>& v, int index)
+    {
+        v[index] = v.back();
+        v.pop_back();
     }
-    return false;
 }
-bool PlayerBullet::init()
+
+const int BulletSystem::MaxQuadsPerCommand = Renderer::VBO_SIZE/4-1;
+
+BulletSystem::BulletSystem()
+: _renderLag(0)
+, _bulletTexture(nullptr)
+, _flareTexture(nullptr)
 {
-    _Model = Sprite::create("bullets.png", Rect(54, 57, 36, 67));
-    if(_Model)
+}
+
+BulletSystem::~BulletSystem()
+{
+    CC_SAFE_RELEASE(_bulletTexture);
+    CC_SAFE_RELEASE(_flareTexture);
+}
+
+bool BulletSystem::init()
+{
+    //the bullets are only simulated, draw() is never called
+    if(GameController::isSimulationOnly())
+        return true;
+    auto player = Sprite::create("bullets.png", Rect(54, 57, 36, 67));
+    auto enemy = Sprite::create("bullets.png", Rect(5,8,24,32));
+    auto flare = Sprite::createWithSpriteFrameName("toonFlare.png");
+    if(player && enemy && flare)
     {
-        addChild(_Model);
-        _radius=10;
-        _type = kPlayerBullet;
-        _owner = kPlayer;
-        _damage = 2;
+        _looks[kLookPlayer] = centeredQuad(player, 1);
+        _looks[kLookEnemy] = centeredQuad(enemy, 1.5);
+        // replaces the missileFlare particle each enemy bullet used to carry
+        _looks[kLookFlare] = centeredQuad(flare, 0.5);
+        Color4B flareColor(175,116,71,255);
+        _looks[kLookFlare].tl.colors = _looks[kLookFlare].bl.colors = flareColor;
+        _looks[kLookFlare].tr.colors = _looks[kLookFlare].br.colors = flareColor;
+        _bulletTexture = player->getTexture();
+        _bulletTexture->retain();
+        _bulletBlend = player->getBlendFunc();
+        _flareTexture = flare->getTexture();
+        _flareTexture->retain();
+        setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP));
         return true;
     }
     return false;
 }
 
-void Bullet::setVector(Vec2 vec)
+int BulletSystem::spawn(int t, const Vec2& pos, const Vec2& vec)
 {
-    _vector = vec;
+    int handle;
+    if(!_freeHandles.empty())
+    {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    }
+    else
+    {
+        handle = (int)_indexOfHandle.size();
+        _indexOfHandle.push_back(-1);
+    }
+    _indexOfHandle[handle] = (int)size();
+    _handleOfIndex.push_back(handle);
+    posX.push_back(pos.x);
+    posY.push_back(pos.y);
+    velX.push_back(vec.x);
+    velY.push_back(vec.y);
+    radius.push_back(10);
+    type.push_back(t);
+    if(t == kPlayerBullet)
+    {
+        owner.push_back(kPlayer);
+        damage.push_back(2);
+    }
+    else
+    {
+        owner.push_back(kEnemy);
+        damage.push_back(10);
+    }
+    _cos.push_back(1);
+    _sin.push_back(0);
+    return handle;
 }
 
-Vec2 Bullet::getVector()
+void BulletSystem::setBulletRotation(int handle, float rotation)
 {
-    return _vector;
+    int index = _indexOfHandle[handle];
+    if(index >= 0)
+    {
+        // same convention as Node::setRotation, positive degrees turn clockwise
+        float rad = -CC_DEGREES_TO_RADIANS(rotation);
+        _cos[index] = cosf(rad);
+        _sin[index] = sinf(rad);
+    }
 }
-void Bullet::reset()
+
+void BulletSystem::remove(int handle)
 {
-    setRotation(0);
+    int index = _indexOfHandle[handle];
+    if(index >= 0)
+    {
+        removeAt(index);
+    }
+}
+
+void BulletSystem::removeAt(int index)
+{
+    int handle = _handleOfIndex[index];
+    _indexOfHandle[_handleOfIndex.back()] = index;
+    _indexOfHandle[handle] = -1;
+    _freeHandles.push_back(handle);
+    swapPop(_handleOfIndex, index);
+    swapPop(posX, index);
+    swapPop(posY, index);
+    swapPop(velX, index);
+    swapPop(velY, index);
+    swapPop(radius, index);
+    swapPop(damage, index);
+    swapPop(type, index);
+    swapPop(owner, index);
+    swapPop(_cos, index);
+    swapPop(_sin, index);
+}
+
+void BulletSystem::clear()
+{
+    posX.clear();
+    posY.clear();
+    velX.clear();
+    velY.clear();
+    radius.clear();
+    damage.clear();
+    type.clear();
+    owner.clear();
+    _cos.clear();
+    _sin.clear();
+    _handleOfIndex.clear();
+    _indexOfHandle.clear();
+    _freeHandles.clear();
+}
+
+void BulletSystem::integrate(float dt)
+{
+    // flat float arrays without aliasing between them, so this loop vectorizes
+    float* px = posX.data();
+    float* py = posY.data();
+    const float* vx = velX.data();
+    const float* vy = velY.data();
+    const ssize_t count = size();
+    for(ssize_t i = 0; i < count; i++)
+    {
+        px[i] += vx[i]*dt;
+        py[i] += vy[i]*dt;
+    }
+}
+
+void BulletSystem::pushLook(int index, int look, std::vector<V3F_C4B_T2F_Quad>& quads)
+{
+    quads.push_back(_looks[look]);
+    auto& quad = quads.back();
+    const float c = _cos[index];
+    const float s = _sin[index];
+    const float x0 = posX[index] - velX[index]*_renderLag;
+    const float y0 = posY[index] - velY[index]*_renderLag;
+    V3F_C4B_T2F* corners[4] = {&quad.tl, &quad.bl, &quad.tr, &quad.br};
+    for(auto corner : corners)
+    {
+        float x = corner->vertices.x;
+        float y = corner->vertices.y;
+        corner->vertices.x = x0 + c*x - s*y;
+        corner->vertices.y = y0 + s*x + c*y;
+    }
+}
+
+void BulletSystem::submit(Renderer *renderer, const Mat4 &transform, std::vector<V3F_C4B_T2F_Quad>& quads, std::vector<QuadCommand>& commands, Texture2D* texture, const BlendFunc& blend)
+{
+    // the renderer can only take VBO_SIZE/4 quads per command, so big volleys are split
+    ssize_t count = quads.size();
+    ssize_t needed = (count+MaxQuadsPerCommand-1)/MaxQuadsPerCommand;
+    if((ssize_t)commands.size() < needed)
+    {
+        commands.resize(needed);
+    }
+    for(ssize_t c = 0; c < needed; c++)
+    {
+        ssize_t first = c*MaxQuadsPerCommand;
+        commands[c].init(_globalZOrder, texture->getName(), getGLProgramState(), blend, quads.data()+first, std::min((ssize_t)MaxQuadsPerCommand, count-first), transform);
+        renderer->addCommand(&commands[c]);
+    }
+}
+
+void BulletSystem::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    CC_PROFILER_START("BulletSystem - draw");
+    _quads.clear();
+    _flareQuads.clear();
+    const ssize_t count = size();
+    for(int i = 0; i < count; i++)
+    {
+        if(type[i] == kEnemyBullet)
+        {
+            pushLook(i, kLookFlare, _flareQuads);
+            pushLook(i, kLookEnemy, _quads);
+        }
+        else
+        {
+            pushLook(i, kLookPlayer, _quads);
+        }
+    }
+    // flares go first so they stay behind the bullets
+    submit(renderer, transform, _flareQuads, _flareCommands, _flareTexture, BlendFunc{GL_ONE, GL_ONE});
+    submit(renderer, transform, _quads, _commands, _bulletTexture, _bulletBlend);
+    CC_PROFILER_STOP("BulletSystem - draw");
 }
 
 bool Missile::init()
 {
-    _Model = EffectSprite3D::createFromObjFileAndTexture("daodanv001.c3b", "daodan_32.png");
+    GameController::adopt(this);
+    _Model = GameEntity::createModel("daodanv001.c3b", "daodan_32.png");
     if(_Model)
     {
 		_accel = 15;
@@ -110,33 +297,29 @@ bool Missile::init()
         //_Model->setRotation3D(Vec3(0,0,180));
         _damage = 20;
 		_target = nullptr;
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.01, Color3B(0,0,0));
+        GameEntity::UseOutlineEffect(_Model, 0.01, Color3B(0,0,0));
         _left = (CCRANDOM_MINUS1_1()>0);
         if(_left)
             _yRotSpeed *= -1;
         
         
         // missile effects
+        if(GameController::isSimulationOnly())
+            return true;
 
-        auto part2_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonSmoke.png");
-        ValueMap vm2=ParticleManager::getInstance()->GetPlistData("emission");
-        auto part2 = ParticleSystemQuad::create(vm2);
-        //part2->setDisplayFrame(part2_frame);
-        part2->setTextureWithRect(part2_frame->getTexture(), part2_frame->getRect());
+        auto part2 = ParticleManager::getInstance()->createParticle("emission");
         addChild(part2,1);
         part2->setPosition(0,-34);
         part2->setPositionType(tPositionType::GROUPED);
+        part2->setBatched(true);
         //part2->setScale(2.5);
         
         
-        auto part1_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonFlare.png");
-        ValueMap vm1=ParticleManager::getInstance()->GetPlistData("missileFlare");
-        auto part1 = ParticleSystemQuad::create(vm1);
-        //part1->setDisplayFrame(part1_frame);
-        part1->setTextureWithRect(part1_frame->getTexture(), part1_frame->getRect());
+        auto part1 = ParticleManager::getInstance()->createParticle("missileFlare");
         addChild(part1,2);
         part1->setPosition(0,-30);
         part1->setPositionType(tPositionType::GROUPED);
+        part1->setBatched(true);
         part1->setScale(2.5);
         return true;
     }
@@ -33,8 +33,6 @@
 class Bullet : public GameEntity
 {
 public:
-    CREATE_FUNC(Bullet);
-    bool init();
     void setVector(Vec2 vec);
     Vec2 getVector();
     virtual void reset();
@@ -44,11 +42,58 @@ protected:
     Vec2 _vector;
 };
 
-class PlayerBullet : public Bullet
+//plain player and enemy bullets, kept as structure-of-arrays instead of one Node each
+//and drawn with one batched QuadCommand per texture
+class BulletSystem : public Node
 {
 public:
-    CREATE_FUNC(PlayerBullet);
+    CREATE_FUNC(BulletSystem);
+    BulletSystem();
+    virtual ~BulletSystem();
     bool init();
+    //returns a handle that stays valid until the bullet is removed
+    int spawn(int type, const Vec2& pos, const Vec2& vec);
+    void setBulletRotation(int handle, float rotation);
+    void remove(int handle);
+    void removeAt(int index); //swaps the last bullet into index, safe while walking backwards
+    void clear();
+    void integrate(float dt);
+    //bullets are drawn this many seconds behind their simulated position, see GameController::advance
+    void setRenderLag(float seconds){ _renderLag = seconds; };
+    ssize_t size() const { return posX.size(); };
+    virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+
+    // per bullet data, indexed by the dense bullet index
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> velX;
+    std::vector<float> velY;
+    std::vector<float> radius;
+    std::vector<float> damage;
+    std::vector<int> type;
+    std::vector<int> owner;
+
+    static const int MaxQuadsPerCommand;
+protected:
+    void pushLook(int index, int look, std::vector<V3F_C4B_T2F_Quad>& quads);
+    void submit(Renderer *renderer, const Mat4 &transform, std::vector<V3F_C4B_T2F_Quad>& quads, std::vector<QuadCommand>& commands, Texture2D* texture, const BlendFunc& blend);
+
+    std::vector<float> _cos; //rotation is set once at spawn, so keep it as cos/sin
+    std::vector<float> _sin;
+    std::vector<int> _handleOfIndex;
+    std::vector<int> _indexOfHandle;
+    std::vector<int> _freeHandles;
+    float _renderLag;
+
+    enum { kLookPlayer, kLookEnemy, kLookFlare, kLookCount };
+    V3F_C4B_T2F_Quad _looks[kLookCount]; //template quads centered on the origin
+    Texture2D* _bulletTexture;
+    BlendFunc _bulletBlend;
+    Texture2D* _flareTexture;
+    std::vector<V3F_C4B_T2F_Quad> _quads;
+    std::vector<V3F_C4B_T2F_Quad> _flareQuads;
+    std::vector<QuadCommand> _commands;
+    std::vector<QuadCommand> _flareCommands;
 };
 
 class Missile : public Bullet
@@ -25,8 +25,8 @@
 #include "Effects.h"
 
 Node* EffectManager::_effectLayer = nullptr;
-Vector<SmallExplosion*> EffectManager::_smallExplPool;
-Vector<BigExplosion*> EffectManager::_bigExplPool;
+ObjectPool<SmallExplosion> EffectManager::_smallExplPool;
+ObjectPool<BigExplosion> EffectManager::_bigExplPool;
 
 void EffectManager::createExplosion(Vec2 pos)
 {
@@ -35,18 +35,7 @@ void EffectManager::createExplosion(Vec2 pos)
         return;
     }
     
-    SmallExplosion* explosion = nullptr;
-    
-    if (!_smallExplPool.empty())
-    {
-        explosion = _smallExplPool.back();
-        _smallExplPool.popBack();
-    }
-    else
-    {
-        explosion = SmallExplosion::create();
-        explosion->retain();
-    }
+    SmallExplosion* explosion = _smallExplPool.acquire();
     
     explosion->createExplosion(_effectLayer, pos);
 
@@ -59,18 +48,7 @@ void EffectManager::createBigExplosion(Vec2 pos)
         return;
     }
     
-    BigExplosion* explosion = nullptr;
-    
-    if (!_bigExplPool.empty())
-    {
-        explosion = _bigExplPool.back();
-        _bigExplPool.popBack();
-    }
-    else
-    {
-        explosion = BigExplosion::create();
-        explosion->retain();
-    }
+    BigExplosion* explosion = _bigExplPool.acquire();
     
     explosion->createExplosion(_effectLayer, pos);
     
@@ -27,6 +27,7 @@
 
 #include "cocos2d.h"
 #include "Explosion.h"
+#include "ObjectPool.h"
 USING_NS_CC;
 USING_NS_CC_MATH;
 
@@ -36,8 +37,8 @@ public:
     static void createExplosion(Vec2 pos);
     static void createBigExplosion(Vec2 pos);
     static void setLayer(Node* layer);
-    static Vector<SmallExplosion*> _smallExplPool;
-    static Vector<BigExplosion*> _bigExplPool;
+    static ObjectPool<SmallExplosion> _smallExplPool;
+    static ObjectPool<BigExplosion> _bigExplPool;
 protected:
     static Node* _effectLayer;
 
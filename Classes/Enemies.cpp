@@ -27,6 +27,7 @@
 #include "Bullets.h"
 #include "consts.h"
 #include "SimpleAudioEngine.h"
+#include "SoundManager.h"
 #include "Effects.h"
 #include "HelloWorldScene.h"
 #include "GameLayer.h"
@@ -34,16 +35,17 @@
 
 bool Fodder::init()
 {
+    GameController::adopt(this);
     _score = 10;
 	_alive = true;
-    _Model = EffectSprite3D::createFromObjFileAndTexture("dijiyuanv001.obj", "dijiyuanv001.png");
+    _Model = GameEntity::createModel("dijiyuanv001.obj", "dijiyuanv001.png");
 //    _Model = EffectSprite3D::createFromObjFileAndTexture("diji1_v002.c3b", "diji02_v002_128.png");
     if(_Model)
     {
         _Model->setScale(6);
         addChild(_Model);
         _Model->setRotation3D(Vec3(90,0,0));
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.02, Color3B(0,0,0));
+        GameEntity::UseOutlineEffect(_Model, 0.02, Color3B(0,0,0));
         _type = kEnemyFodder;
         _HP = 10;
         _radius = 30;
@@ -88,7 +90,7 @@ void Fodder::shoot(float dt)
         float angle = (getPosition()-_target->getPosition()).getAngle();
         auto bullet =BulletController::spawnBullet(kEnemyBullet, getPosition(), Vec2(cosf(angle)*-500, sinf(angle)*-500));
         //auto bullet =BulletController::spawnBullet(kEnemyBullet, getPosition(), Vec2(0,-500));
-        bullet->setRotation(-CC_RADIANS_TO_DEGREES(angle)-90);
+        BulletController::setRotation(bullet, -CC_RADIANS_TO_DEGREES(angle)-90);
         //log("aaaaaaa");
     }
     else{
@@ -99,15 +101,16 @@ void Fodder::shoot(float dt)
 
 bool FodderLeader::init()
 {
+    GameController::adopt(this);
     _score = 20;
 	_alive = true;
-    _Model = EffectSprite3D::createFromObjFileAndTexture("dijiyuanv001.c3b", "dijiyuanv001.png");
+    _Model = GameEntity::createModel("dijiyuanv001.c3b", "dijiyuanv001.png");
     if(_Model)
     {
         _Model->setScale(8);
         addChild(_Model);
         //_Model->setRotation3D(Vec3(90,0,0));
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.02, Color3B(255,0,0));
+        GameEntity::UseOutlineEffect(_Model, 0.02, Color3B(255,0,0));
         _type = kEnemyFodderL;
         _HP = 20;
         _radius = 35;
@@ -124,17 +127,18 @@ void FodderLeader::reset()
 
 bool BigDude::init()
 {
+    GameController::adopt(this);
     _score = 20;
 	_alive = true;
 	_turnRate = 50;
-    _Model = EffectSprite3D::createFromObjFileAndTexture("diji1_v002.c3b", "diji02_v002_128.png");
+    _Model = GameEntity::createModel("diji1_v002.c3b", "diji02_v002_128.png");
     if(_Model)
     {
         _Model->setScale(8);
         addChild(_Model);
         //_Model->setRotation3D(Vec3(90,0,0));
         //static_cast<Sprite3D*>(_Model)->setOutline(0.2, Color3B::BLACK);
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.02, Color3B::BLACK);
+        GameEntity::UseOutlineEffect(_Model, 0.02, Color3B::BLACK);
         _type = kEnemyBigDude;
         _HP = 30;
         _radius = 40;
@@ -178,10 +182,10 @@ void BigDude::shoot(float dt)
     offset2.y += sinf(angle-offsetRad)*-50;
     //this->showMuzzle();
     auto bullet =BulletController::spawnBullet(kEnemyBullet, offset1, Vec2(cosf(angle)*-500, sinf(angle)*-500));
-    bullet->setRotation(-CC_RADIANS_TO_DEGREES(angle)-90);
+    BulletController::setRotation(bullet, -CC_RADIANS_TO_DEGREES(angle)-90);
     bullet =BulletController::spawnBullet(kEnemyBullet, offset2, Vec2(cosf(angle)*-500, sinf(angle)*-500));
-    bullet->setRotation(-CC_RADIANS_TO_DEGREES(angle)-90);
-        CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("boom.mp3");
+    BulletController::setRotation(bullet, -CC_RADIANS_TO_DEGREES(angle)-90);
+        SoundManager::playEffect("boom.mp3");
 }
 
 void BigDude::update(float dt, Node* player)
@@ -229,7 +233,7 @@ void BigDude::dismissMuzzle(float dt)
 
 void BigDude::die()
 {
-    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("boom2.mp3");
+    SoundManager::playEffect("boom2.mp3");
     this->_alive = false;
     EnemyController::enemies.eraseObject(this);
     EnemyController::showCaseEnemies.pushBack(this);
@@ -257,59 +261,47 @@ void BigDude::die()
 
 void BigDude::fall()
 {
-    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("explodeEffect.mp3");
+    SoundManager::playEffect("explodeEffect.mp3");
     EffectManager::createBigExplosion(getPosition());
-    auto helloworld = (HelloWorld*)Director::getInstance()->getRunningScene()->getChildByTag(100);
-    int score = helloworld->getScore();
-    helloworld->setScore(score+=_score);
-    std::stringstream ss;
-    std::string str;
-    ss<<score;
-    ss>>str;
-    const char *p = str.c_str();
-    helloworld->getScoreLabel()->setString(p);
+    HelloWorld::addScore(_score);
     _alive = false;
-    auto scale = ScaleTo::create(0.1, 1.2);
-    auto scaleBack = ScaleTo::create(0.1, 1);
-    auto label = helloworld->getScoreLabel();
-    label->runAction(Sequence::create(scale, scaleBack,NULL));
     this->removeFromParentAndCleanup(false);
-    EnemyController::_bigDudePool.pushBack(this);
     EnemyController::showCaseEnemies.eraseObject(this);
-    reset();
+    EnemyController::_bigDudePool.recycle(this);
 }
 
 bool Boss::init()
 {
+    GameController::adopt(this);
     _score = 666;
 	_alive = true;
-    _Model = EffectSprite3D::createFromObjFileAndTexture("boss.c3b", "boss.png");
+    _Model = GameEntity::createModel("boss.c3b", "boss.png");
     //auto cannon2 = Sprite3D::create("bossCannon.obj", "boos.png");
     if(_Model)
     {
         _Model->setScale(28);
         addChild(_Model);
        // _Model->setRotation3D(Vec3(90,0,0));
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.02, Color3B::BLACK);
+        GameEntity::UseOutlineEffect(_Model, 0.02, Color3B::BLACK);
         _type = kEnemyBoss;
         _HP = 5000;
         _radius = 150;
-        auto cannon1 = EffectSprite3D::createFromObjFileAndTexture("bossCannon.c3b", "boss.png");
+        auto cannon1 = GameEntity::createModel("bossCannon.c3b", "boss.png");
         _Cannon1 = Node::create();
         addChild(_Cannon1);
         _Cannon1->addChild(cannon1);
         cannon1->setScale(28);
         //cannon1->setRotation3D(Vec3(90,0,0));
         _Cannon1->setPosition3D(Vec3(40,-100, 10));
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(cannon1), 0.02, Color3B(0,0,0));
-        auto cannon2 = EffectSprite3D::createFromObjFileAndTexture("bossCannon.c3b", "boss.png");
+        GameEntity::UseOutlineEffect(cannon1, 0.02, Color3B(0,0,0));
+        auto cannon2 = GameEntity::createModel("bossCannon.c3b", "boss.png");
         _Cannon2 = Node::create();
         addChild(_Cannon2);
         _Cannon2->addChild(cannon2);
         cannon2->setScale(28);
         //cannon2->setRotation3D(Vec3(90,0,0));
         _Cannon2->setPosition3D(Vec3(-40,-100, 10));
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(cannon2), 0.02, Color3B(0,0,0));
+        GameEntity::UseOutlineEffect(cannon2, 0.02, Color3B(0,0,0));
         //addChild(_Cannon2);
         //_Cannon2->setPosition(-20,-200);
         
@@ -433,7 +425,7 @@ void Boss::startShooting(float dt)
 
 void Boss::createRandomExplosion()
 {
-    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("explodeEffect.mp3");
+    SoundManager::playEffect("explodeEffect.mp3");
     EffectManager::createBigExplosion(getPosition()+Vec2(CCRANDOM_MINUS1_1()*200, CCRANDOM_MINUS1_1()*200));
 }
 
@@ -446,22 +438,11 @@ void Boss::dying()
 
 void Boss::dead()
 {
-    auto helloworld = (HelloWorld*)Director::getInstance()->getRunningScene()->getChildByTag(100);
-    int score = helloworld->getScore();
-    helloworld->setScore(score+=_score);
-    std::stringstream ss;
-    std::string str;
-    ss<<score;
-    ss>>str;
-    const char *p = str.c_str();
-    helloworld->getScoreLabel()->setString(p);
-    auto scale = ScaleTo::create(0.1, 1.2);
-    auto scaleBack = ScaleTo::create(0.1, 1);
-    auto label =helloworld->getScoreLabel();
-    label->runAction(Sequence::create(scale, scaleBack,NULL));
+    HelloWorld::addScore(_score);
     EnemyController::showCaseEnemies.eraseObject(this);
     removeFromParent();
-    CocosDenshion::SimpleAudioEngine::getInstance()->stopBackgroundMusic();
+    if(!GameController::isSimulationOnly())
+        CocosDenshion::SimpleAudioEngine::getInstance()->stopBackgroundMusic();
     NotificationCenter::getInstance()->postNotification("ShowGameOver",NULL);
     scheduleOnce(schedule_selector(Boss::_endGame), 1.5);
 }
@@ -557,12 +538,13 @@ void Boss::shoot(float dt)
     }
     auto bullet =BulletController::spawnBullet(kEnemyBullet, _getCannon1Position(), _getCannon1Vector());
     
-    showMuzzle();
+    if(!GameController::isSimulationOnly())
+        showMuzzle();
     
-    bullet->setRotation(_Cannon1->getRotation()+180);
+    BulletController::setRotation(bullet, _Cannon1->getRotation()+180);
     bullet =BulletController::spawnBullet(kEnemyBullet, _getCannon2Position(), _getCannon2Vector());
-    bullet->setRotation(_Cannon2->getRotation()+180);
-    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("boom.mp3");
+    BulletController::setRotation(bullet, _Cannon2->getRotation()+180);
+    SoundManager::playEffect("boom.mp3");
     schedule(schedule_selector(Boss::startShooting),1, 0, 3);
 }
 void Boss::update(float dt, Node* player)
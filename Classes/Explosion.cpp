@@ -30,22 +30,16 @@ USING_NS_CC;
 
 bool SmallExplosion::init(){
     
-    auto part1_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonSmoke.png");
-    ValueMap vm1=ParticleManager::getInstance()->GetPlistData("toonSmoke");
-    part1 = ParticleSystemQuad::create(vm1);
-    //part1->setDisplayFrame(part1_frame);
-    part1->setTextureWithRect(part1_frame->getTexture(), part1_frame->getRect());
+    part1 = ParticleManager::getInstance()->createParticle("toonSmoke");
     this->addChild(part1);
-    auto part2_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonFlare.png");
-    ValueMap vm2=ParticleManager::getInstance()->GetPlistData("flare");
-    part2 = ParticleSystemQuad::create(vm2);
-    //part2->setDisplayFrame(part2_frame);
-    part2->setTextureWithRect(part2_frame->getTexture(), part2_frame->getRect());
+    part2 = ParticleManager::getInstance()->createParticle("flare");
     this->addChild(part2);
     part1->setTotalParticles(10);
     part1->setEmissionRate(9999999999);
+    part1->setBatched(true);
     part2->setTotalParticles(3);
     part2->setEmissionRate(9999999999);
+    part2->setBatched(true);
     part1->setRotation3D(Vec3(30,0,0));
     part2->setRotation3D(Vec3(30,0,0));
     return true;
@@ -67,34 +61,25 @@ void SmallExplosion::createExplosion(Node* _effectLayer, Vec2 pos){
 
 void SmallExplosion::recycle(float dt){
     this->removeFromParentAndCleanup(false);
-    EffectManager::_smallExplPool.pushBack(this);
+    EffectManager::_smallExplPool.recycle(this);
 }
 
 bool BigExplosion::init(){
-    auto part1_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonSmoke.png");
-    ValueMap vm1=ParticleManager::getInstance()->GetPlistData("toonSmoke");
-    part1 = ParticleSystemQuad::create(vm1);
-    //part1->setDisplayFrame(part1_frame);
-    part1->setTextureWithRect(part1_frame->getTexture(), part1_frame->getRect());
+    part1 = ParticleManager::getInstance()->createParticle("toonSmoke");
     this->addChild(part1);
-    auto part2_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonGlow.png");
-    ValueMap vm2=ParticleManager::getInstance()->GetPlistData("glow");
-    part2 = ParticleSystemQuad::create(vm2);
-    //part2->setDisplayFrame(part2_frame);
-    part2->setTextureWithRect(part2_frame->getTexture(), part2_frame->getRect());
+    part2 = ParticleManager::getInstance()->createParticle("glow");
     this->addChild(part2);
-    auto part3_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("toonFlare2.png");
-    ValueMap vm3=ParticleManager::getInstance()->GetPlistData("debris");
-    part3 = ParticleSystemQuad::create(vm3);
-    //part3->setDisplayFrame(part3_frame);
-    part3->setTextureWithRect(part3_frame->getTexture(), part3_frame->getRect());
+    part3 = ParticleManager::getInstance()->createParticle("debris");
     this->addChild(part3);
     part1->setTotalParticles(10);
     part1->setEmissionRate(9999999999);
+    part1->setBatched(true);
     part2->setTotalParticles(3);
     part2->setEmissionRate(9999999999);
+    part2->setBatched(true);
     part3->setTotalParticles(20);
     part3->setEmissionRate(9999999999);
+    part3->setBatched(true);
     part3->setScale(1.5);
     part1->setRotation3D(Vec3(30,0,0));
     part2->setRotation3D(Vec3(30,0,0));
@@ -115,7 +100,7 @@ void BigExplosion::createExplosion(Node *_effectLayer, Vec2 pos){
 
 void BigExplosion::recycle(float dt){
     this->removeFromParentAndCleanup(false);
-    EffectManager::_bigExplPool.pushBack(this);
+    EffectManager::_bigExplPool.recycle(this);
 }
 
 bool BulletExplosion::init(){
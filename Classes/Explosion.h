@@ -27,6 +27,8 @@
 
 #include "cocos2d.h"
 
+class ParticleEmitter;
+
 class SmallExplosion : public cocos2d::Node{
     
 public:
@@ -36,8 +38,8 @@ public:
     
 private:
     void recycle(float dt);
-    cocos2d::ParticleSystemQuad* part1;
-    cocos2d::ParticleSystemQuad* part2;
+    ParticleEmitter* part1;
+    ParticleEmitter* part2;
 
 };
 
@@ -47,9 +49,9 @@ public:
     CREATE_FUNC(BigExplosion);
     bool init();
     void createExplosion(Node* _effectLayer,cocos2d::Vec2 pos);
-    cocos2d::ParticleSystemQuad* part1;
-    cocos2d::ParticleSystemQuad* part2;
-    cocos2d::ParticleSystemQuad* part3;
+    ParticleEmitter* part1;
+    ParticleEmitter* part2;
+    ParticleEmitter* part3;
 private:
     void recycle(float dt);
 
@@ -28,104 +28,69 @@
 #include "consts.h"
 #include "AirCraft.h"
 #include "Effects.h"
-#include "SimpleAudioEngine.h"
+#include "SoundManager.h"
 #include "Enemies.h"
 #include "Player.h"
 #include "HelloWorldScene.h"
+#include "GameLayer.h"
+#include "WaveScheduler.h"
 Node* BulletController::_bulletLayer = nullptr;
+BulletSystem* BulletController::_bulletSystem = nullptr;
 bool BulletController::_inited = false;
-Vector<Bullet*> BulletController::bullets;
-Vector<Missile*> BulletController::_missilePool;
+Vector<Missile*> BulletController::missiles;
+ObjectPool<Missile> BulletController::_missilePool([](Missile* m){ m->reset(); });
 
 
 void BulletController::reset(){
     _inited = false;
     _bulletLayer = nullptr;
-    bullets.clear();
+    _bulletSystem = nullptr;
+    missiles.clear();
 }
 bool BulletController::init(Node *bulletLayer){
     if(bulletLayer)
     {
         reset();
         _bulletLayer = bulletLayer;
+        _bulletSystem = BulletSystem::create();
+        _bulletLayer->addChild(_bulletSystem,1);
         _inited = false;
         return true;
     }
     return false;
 }
-Bullet* BulletController::spawnBullet(int type, Vec2 pos, Vec2 vec)
+int BulletController::spawnBullet(int type, Vec2 pos, Vec2 vec)
 {
-    Bullet *bullet = nullptr;
-    switch(type)
-    {
-        case kPlayerBullet:
-            bullet = PlayerBullet::create();
-            //bullet->retain();
-            //bullet->setType(kPlayerBullet);
-            break;
-        case kPlayerMissiles:
-            if(!_missilePool.empty())
-            {
-                // if the pool is not empty, we don't need to create, just return that, and reset its data
-                bullet = _missilePool.back();
-                //bullet->retain();
-                _missilePool.popBack();
-                
-                //bullet->reset();
-            }
-            else
-            {
-                bullet = Missile::create();
-                bullet->retain();
-            }
-            //bullet->setType
-            break;
-        case kEnemyBullet:
-            bullet = Bullet::create();
-            bullet->setType(kEnemyBullet);
-            break;
-    }
-    if(bullet)
-    {
-        bullets.pushBack(bullet);
-        _bulletLayer->addChild(bullet,1);
-        //bullet->release();
-        bullet->setPosition(pos);
-        bullet->setVector(vec);
-        return bullet;
-    }
-    return nullptr;
+    CC_ASSERT(_bulletSystem);
+    return _bulletSystem->spawn(type, pos, vec);
 }
-void BulletController::erase(Bullet* b)
+void BulletController::setRotation(int bullet, float rotation)
 {
-    if(b->getType() == kPlayerMissiles)
-    {
-        _missilePool.pushBack(static_cast<Missile*>(b));
-        bullets.eraseObject(b);
-        b->removeFromParentAndCleanup(false);
-        b->reset();
-    }
-    else
-    {
-        b->removeFromParentAndCleanup(true);
-        bullets.eraseObject(b);
-    }
+    _bulletSystem->setBulletRotation(bullet, rotation);
 }
-void BulletController::erase(int i)
+void BulletController::erase(int bullet)
 {
-    auto b = bullets.at(i);
-    if(b->getType() == kPlayerMissiles)
-    {
-        _missilePool.pushBack(static_cast<Missile*>(b));
-        bullets.erase(i);
-        b->removeFromParentAndCleanup(false);
-        b->reset();
-    }
-    else
+    _bulletSystem->remove(bullet);
+}
+Missile* BulletController::spawnMissile(Vec2 pos, Vec2 vec)
+{
+    // if the pool is not empty, we don't need to create, just return that
+    Missile *missile = _missilePool.acquire();
+    if(missile)
     {
-        bullets.erase(i);
-        b->removeFromParentAndCleanup(true);
+        missiles.pushBack(missile);
+        _bulletLayer->addChild(missile,1);
+        missile->setPosition(pos);
+        missile->setVector(vec);
+        return missile;
     }
+    return nullptr;
+}
+void BulletController::erase(Missile* m)
+{
+    m->removeFromParentAndCleanup(false);
+    missiles.eraseObject(m);
+    _missilePool.recycle(m);
 }
 
 
@@ -133,10 +98,10 @@ Node* EnemyController::_enemyLayer = nullptr;
 bool EnemyController::_inited = false;
 Vector<AirCraft*> EnemyController::enemies;
 Vector<AirCraft*> EnemyController::showCaseEnemies;
-Vector<Fodder*> EnemyController::_fodderPool;
-Vector<FodderLeader*> EnemyController::_fodderLPool;
-Vector<BigDude*> EnemyController::_bigDudePool;
-Vector<Boss*> EnemyController::_bossPool;
+ObjectPool<Fodder> EnemyController::_fodderPool([](Fodder* e){ e->reset(); });
+ObjectPool<FodderLeader> EnemyController::_fodderLPool([](FodderLeader* e){ e->reset(); });
+ObjectPool<BigDude> EnemyController::_bigDudePool([](BigDude* e){ e->reset(); });
+ObjectPool<Boss> EnemyController::_bossPool([](Boss* e){ e->reset(); });
 
 const float EnemyController::EnemyMoveDist = -400;
 
@@ -159,52 +124,16 @@ AirCraft* EnemyController::createOrGet(int type)
     switch(type)
     {
         case kEnemyFodder:
-            if(!_fodderPool.empty())
-            {
-                enemy = _fodderPool.back();
-                _fodderPool.popBack();
-            }
-            else
-            {
-                enemy = Fodder::create();
-                enemy->retain();
-            }
+            enemy = _fodderPool.acquire();
             break;
         case kEnemyFodderL:
-            if(!_fodderLPool.empty())
-            {
-                enemy = _fodderLPool.back();
-                _fodderLPool.popBack();
-            }
-            else
-            {
-                enemy = FodderLeader::create();
-                enemy->retain();
-            }
+            enemy = _fodderLPool.acquire();
             break;
         case kEnemyBigDude:
-            if(!_bigDudePool.empty())
-            {
-                enemy = _bigDudePool.back();
-                _bigDudePool.popBack();
-            }
-            else
-            {
-                enemy = BigDude::create();
-                enemy->retain();
-            }
+            enemy = _bigDudePool.acquire();
             break;
         case kEnemyBoss:
-            if(!_bossPool.empty())
-            {
-                enemy = _bossPool.back();
-                _bossPool.popBack();
-            }
-            else
-            {
-                enemy = Boss::create();
-                enemy->retain();
-            }
+            enemy = _bossPool.acquire();
             break;
     }
     return enemy;
@@ -237,96 +166,303 @@ AirCraft* EnemyController::showCaseEnemy(int type)
 void EnemyController::erase(int i)
 {
     auto e = enemies.at(i);
-    int type = e->getType();
-    switch(type)
+    e->removeFromParentAndCleanup(false);
+    enemies.erase(i);
+    switch(e->getType())
     {
         case kEnemyFodder:
-            _fodderPool.pushBack(static_cast<Fodder*>(e));
+            _fodderPool.recycle(static_cast<Fodder*>(e));
             break;
         case kEnemyFodderL:
-            _fodderLPool.pushBack(static_cast<FodderLeader*>(e));
+            _fodderLPool.recycle(static_cast<FodderLeader*>(e));
             break;
         case kEnemyBigDude:
-            _bigDudePool.pushBack(static_cast<BigDude*>(e));
+            _bigDudePool.recycle(static_cast<BigDude*>(e));
             break;
         case kEnemyBoss:
-            _bossPool.pushBack(static_cast<Boss*>(e));
+            _bossPool.recycle(static_cast<Boss*>(e));
             break;
     }
-    enemies.erase(i);
-    e->removeFromParentAndCleanup(false);
-    e->reset();
 }
 
 
+const float CollisionGrid::CellSize = 120;
+int CollisionGrid::_cols = 0;
+int CollisionGrid::_rows = 0;
+std::vector<int> CollisionGrid::_cellStart;
+std::vector<int> CollisionGrid::_cellEntries;
+std::vector<int> CollisionGrid::_cellCursor;
+std::vector<AirCraft*> CollisionGrid::_enemies;
+std::vector<Vec2> CollisionGrid::_positions;
+std::vector<float> CollisionGrid::_radii;
+
+void CollisionGrid::cellRange(float min, float max, float origin, int count, int &first, int &last)
+{
+    // anything outside the bound rect is clamped into the border cells,
+    // overlapping intervals stay overlapping after clamping
+    first = std::min(std::max((int)floorf((min-origin)/CellSize), 0), count-1);
+    last = std::min(std::max((int)floorf((max-origin)/CellSize), 0), count-1);
+}
+
+void CollisionGrid::build(const Vector<AirCraft*>& enemies)
+{
+    if(!_cols)
+    {
+        _cols = (int)ceilf(ENEMY_BOUND_RECT.size.width/CellSize);
+        _rows = (int)ceilf(ENEMY_BOUND_RECT.size.height/CellSize);
+        _cellStart.resize(_cols*_rows+1);
+        _cellCursor.resize(_cols*_rows);
+    }
+    const float ox = ENEMY_BOUND_RECT.origin.x;
+    const float oy = ENEMY_BOUND_RECT.origin.y;
+    ssize_t count = enemies.size();
+    _enemies.resize(count);
+    _positions.resize(count);
+    _radii.resize(count);
+    std::fill(_cellStart.begin(), _cellStart.end(), 0);
+
+    // first pass counts the entries per cell, second pass scatters the enemy indices
+    int x0, x1, y0, y1;
+    for(ssize_t i = 0; i < count; i++)
+    {
+        auto e = enemies.at(i);
+        _enemies[i] = e;
+        _positions[i] = e->getPosition();
+        _radii[i] = e->getRadius();
+        cellRange(_positions[i].x-_radii[i], _positions[i].x+_radii[i], ox, _cols, x0, x1);
+        cellRange(_positions[i].y-_radii[i], _positions[i].y+_radii[i], oy, _rows, y0, y1);
+        for(int y = y0; y <= y1; y++)
+            for(int x = x0; x <= x1; x++)
+                _cellStart[y*_cols+x+1]++;
+    }
+    for(int c = 0; c < _cols*_rows; c++)
+    {
+        _cellStart[c+1] += _cellStart[c];
+        _cellCursor[c] = _cellStart[c];
+    }
+    _cellEntries.resize(_cellStart[_cols*_rows]);
+    for(ssize_t i = 0; i < count; i++)
+    {
+        cellRange(_positions[i].x-_radii[i], _positions[i].x+_radii[i], ox, _cols, x0, x1);
+        cellRange(_positions[i].y-_radii[i], _positions[i].y+_radii[i], oy, _rows, y0, y1);
+        for(int y = y0; y <= y1; y++)
+            for(int x = x0; x <= x1; x++)
+                _cellEntries[_cellCursor[y*_cols+x]++] = (int)i;
+    }
+}
+
+AirCraft* CollisionGrid::hitTest(const Vec2& pos, float radius)
+{
+    int x0, x1, y0, y1;
+    cellRange(pos.x-radius, pos.x+radius, ENEMY_BOUND_RECT.origin.x, _cols, x0, x1);
+    cellRange(pos.y-radius, pos.y+radius, ENEMY_BOUND_RECT.origin.y, _rows, y0, y1);
+    // the old brute force loop walked the enemies backwards, so the highest index wins
+    int best = -1;
+    for(int y = y0; y <= y1; y++)
+    {
+        for(int x = x0; x <= x1; x++)
+        {
+            int cell = y*_cols+x;
+            for(int k = _cellStart[cell]; k < _cellStart[cell+1]; k++)
+            {
+                int j = _cellEntries[k];
+                if(j <= best || !_enemies[j]->alive())
+                    continue;
+                float dx = pos.x - _positions[j].x;
+                float dy = pos.y - _positions[j].y;
+                float r = radius + _radii[j];
+                if(dx*dx+dy*dy < r*r)
+                    best = j;
+            }
+        }
+    }
+    return best < 0 ? nullptr : _enemies[best];
+}
+
+const float GameController::FixedStep = 1.0f/60;
+const int GameController::MaxStepsPerFrame = 5;
+bool GameController::_simulationOnly = false;
+Scheduler* GameController::_scheduler = nullptr;
+ActionManager* GameController::_actionManager = nullptr;
+float GameController::_accumulator = 0;
+Vector<Node*> GameController::_lerpNodes;
+std::vector<Vec2> GameController::_lerpFrom;
+std::vector<Vec2> GameController::_lerpTo;
+std::vector<Vec2> GameController::_lerpShown;
+
+Scheduler* GameController::getScheduler()
+{
+    if(!_scheduler)
+    {
+        _scheduler = new (std::nothrow) Scheduler();
+        _actionManager = new (std::nothrow) ActionManager();
+        _scheduler->scheduleUpdate(_actionManager, Scheduler::PRIORITY_SYSTEM, false);
+    }
+    return _scheduler;
+}
+ActionManager* GameController::getActionManager()
+{
+    getScheduler();
+    return _actionManager;
+}
+void GameController::adopt(Node* node)
+{
+    node->setScheduler(getScheduler());
+    node->setActionManager(getActionManager());
+}
+void GameController::reset()
+{
+    _accumulator = 0;
+    _lerpNodes.clear();
+    _lerpFrom.clear();
+    _lerpTo.clear();
+    _lerpShown.clear();
+}
+
+void GameController::restoreInterpolated()
+{
+    for(ssize_t i = 0; i < _lerpNodes.size(); i++)
+    {
+        auto node = _lerpNodes.at(i);
+        if(node->getPosition() == _lerpShown[i])
+            node->setPosition(_lerpTo[i]);
+    }
+}
+
+int GameController::advance(float dt, Player* player)
+{
+    // put back the simulated positions before anything reads them
+    restoreInterpolated();
+    _accumulator += dt;
+    int steps = _accumulator/FixedStep;
+    if(steps > MaxStepsPerFrame)
+    {
+        steps = MaxStepsPerFrame;
+        _accumulator = steps*FixedStep;
+    }
+    for(int s = 0; s < steps; s++)
+    {
+        if(GameLayer::isDie)
+        {
+            _lerpNodes.clear();
+            break;
+        }
+        if(s == steps-1)
+        {
+            _lerpNodes.clear();
+            _lerpFrom.clear();
+            for(auto e : EnemyController::enemies)
+                _lerpNodes.pushBack(e);
+            for(auto e : EnemyController::showCaseEnemies)
+                _lerpNodes.pushBack(e);
+            for(auto m : BulletController::missiles)
+                _lerpNodes.pushBack(m);
+            for(auto n : _lerpNodes)
+                _lerpFrom.push_back(n->getPosition());
+        }
+        step(player);
+        _accumulator -= FixedStep;
+        if(s == steps-1)
+        {
+            _lerpTo.clear();
+            for(auto n : _lerpNodes)
+                _lerpTo.push_back(n->getPosition());
+        }
+    }
+    // draw everything between the last two steps
+    float alpha = _accumulator/FixedStep;
+    _lerpShown.resize(_lerpNodes.size());
+    for(ssize_t i = 0; i < _lerpNodes.size(); i++)
+    {
+        _lerpShown[i] = _lerpFrom[i].lerp(_lerpTo[i], alpha);
+        _lerpNodes.at(i)->setPosition(_lerpShown[i]);
+    }
+    if(BulletController::getBulletSystem())
+        BulletController::getBulletSystem()->setRenderLag((1-alpha)*FixedStep);
+    return steps;
+}
+
+void GameController::step(Player* player)
+{
+    CC_PROFILER_START("GameController - step");
+    WaveScheduler::update(FixedStep, player);
+    update(FixedStep, player);
+    getScheduler()->update(FixedStep);
+    CC_PROFILER_STOP("GameController - step");
+}
+
+void GameController::simulate(float seconds, Player* player)
+{
+    int steps = seconds/FixedStep;
+    for(int s = 0; s < steps && !GameLayer::isDie; s++)
+    {
+        step(player);
+    }
+}
+
 void GameController::update(float dt, Player* player)
 {
     Vec2 temp;
-    Bullet* b;
-    auto list =BulletController::bullets;
     float enemyMoveDist =EnemyController::EnemyMoveDist*dt;
-    for(int i = BulletController::bullets.size()-1; i >= 0; i-- )
+    CC_PROFILER_START("GameController - collision");
+    CollisionGrid::build(EnemyController::enemies);
+    auto bullets = BulletController::getBulletSystem();
+    for(int i = (int)bullets->size()-1; i >= 0; i-- )
     {
-        b =BulletController::bullets.at(i);
-        temp =b->getPosition();
-        if(BOUND_RECT.containsPoint(temp))
+        temp = Vec2(bullets->posX[i], bullets->posY[i]);
+        if(!BOUND_RECT.containsPoint(temp))
+        {
+            bullets->removeAt(i);
+        }
+        else if(bullets->owner[i] == kPlayer)
         {
-            if(b->getOwner() == kPlayer)
+            auto e = CollisionGrid::hitTest(temp, bullets->radius[i]);
+            if(e)
             {
-                //********* Enemy Loop **********
-                for(int j = EnemyController::enemies.size()-1; j >= 0; j--)
-                {
-                    auto e = EnemyController::enemies.at(j);
-                    if(b->getPosition().getDistance(e->getPosition()) <(b->getRadius() + e->getRadius()))
-                    {
-                        //collision happened
-                        bool dead =  e->hurt(b->getDamage());
-                        if(!dead)
-                        {
-                            switch(b->getType())
-                            {
-                                case kPlayerMissiles:
-                                    EffectManager::createExplosion(b->getPosition());
-                                
-                                    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("boom2.mp3");
-                                    break;
-                                default:
-                                    CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.mp3");
-                                    break;
-                            }
-                        }
-                        BulletController::erase(i);
-                    }
-                    
-                }
-                //*********** Enemy Loop ***************
-                if(b->getType() == kPlayerMissiles)
+                //collision happened
+                bool dead =  e->hurt(bullets->damage[i]);
+                if(!dead)
                 {
-                    b->update(dt);
-                }
-                else{
-                    b->setPosition(temp+(b->getVector()*dt));
+                    SoundManager::playEffect("hit.mp3");
                 }
+                bullets->removeAt(i);
             }
-            // loop all enemy bullets against player
-            else if(b->getPosition().getDistance(player->getPosition()) < b->getRadius()+player->getRadius())
-            {
-                player->hurt(b->getDamage());
-                BulletController::erase(i);
-                EffectManager::createExplosion(player->getPosition());
-                break;
-            }
-            else // nothing happens to the bullet, move along..
-            {
-                
-                b->setPosition(temp+(b->getVector()*dt));
-            }
         }
-        else
+        // loop all enemy bullets against player
+        else if(temp.getDistance(player->getPosition()) < bullets->radius[i]+player->getRadius())
+        {
+            player->hurt(bullets->damage[i]);
+            bullets->removeAt(i);
+            EffectManager::createExplosion(player->getPosition());
+            break;
+        }
+    }
+    // nothing happened to the rest of the bullets, move them along..
+    bullets->integrate(dt);
+    for(int i = BulletController::missiles.size()-1; i >= 0; i-- )
+    {
+        auto m = BulletController::missiles.at(i);
+        temp = m->getPosition();
+        if(!BOUND_RECT.containsPoint(temp))
+        {
+            BulletController::erase(m);
+            continue;
+        }
+        auto e = CollisionGrid::hitTest(temp, m->getRadius());
+        if(e)
         {
-            BulletController::erase(i);
+            bool dead =  e->hurt(m->getDamage());
+            if(!dead)
+            {
+                EffectManager::createExplosion(temp);
+                SoundManager::playEffect("boom2.mp3");
+            }
+            BulletController::erase(m);
+            continue;
         }
+        m->update(dt);
     }
+    CC_PROFILER_STOP("GameController - collision");
     // Enemies update
     for(int k = EnemyController::enemies.size()-1; k>=0; k--)
     {
@@ -26,8 +26,10 @@
 #define __Moon3d__BulletController__
 
 #include "cocos2d.h"
+#include "ObjectPool.h"
 USING_NS_CC;
 class Bullet;
+class BulletSystem;
 class AirCraft;
 class Missile;
 class Fodder;
@@ -40,18 +42,23 @@ class BulletController
 public:
     static void reset();
     static bool init(Node *bulletLayer);
-    static Bullet* spawnBullet(int type, Vec2 pos, Vec2 vec);
+    //plain bullets live in the BulletSystem, the returned value is a handle into it
+    static int spawnBullet(int type, Vec2 pos, Vec2 vec);
+    static void setRotation(int bullet, float rotation);
+    static void erase(int bullet);
+    static Missile* spawnMissile(Vec2 pos, Vec2 vec);
     //static void update(float dt);
-    static Vector<Bullet*> bullets;
-    static void erase(Bullet* b); //returns the bullet to the pool
-    static void erase(int i);
+    static Vector<Missile*> missiles;
+    static void erase(Missile* m); //returns the missile to the pool
+    static BulletSystem* getBulletSystem(){return _bulletSystem;};
     
-    static Vector<Missile*> _missilePool;
+    static ObjectPool<Missile> _missilePool;
 
 protected:
         //static BulletController *s_instance;
     static bool _inited;
     static Node *_bulletLayer;
+    static BulletSystem *_bulletSystem;
 };
 
 class EnemyController
@@ -71,10 +78,10 @@ public:
     
     
     //all kinds of enemies container
-    static Vector<Fodder*> _fodderPool;
-    static Vector<FodderLeader*> _fodderLPool;
-    static Vector<BigDude*> _bigDudePool;
-    static Vector<Boss*> _bossPool;
+    static ObjectPool<Fodder> _fodderPool;
+    static ObjectPool<FodderLeader> _fodderLPool;
+    static ObjectPool<BigDude> _bigDudePool;
+    static ObjectPool<Boss> _bossPool;
     
 protected:
     static bool _inited;
@@ -82,10 +89,61 @@ protected:
     
 };
 
+//uniform grid over ENEMY_BOUND_RECT used as the bullet/enemy broadphase,
+//rebuilt from EnemyController::enemies once per tick
+class CollisionGrid
+{
+public:
+    static void build(const Vector<AirCraft*>& enemies);
+    //returns the enemy with the highest index in the enemies Vector that overlaps the circle, or nullptr
+    static AirCraft* hitTest(const Vec2& pos, float radius);
+    static const float CellSize;
+
+protected:
+    static void cellRange(float min, float max, float origin, int count, int &first, int &last);
+    static int _cols;
+    static int _rows;
+    static std::vector<int> _cellStart; //offsets into _cellEntries, one per cell plus an end marker
+    static std::vector<int> _cellEntries; //enemy indices bucketed by cell
+    static std::vector<int> _cellCursor;
+    static std::vector<AirCraft*> _enemies;
+    static std::vector<Vec2> _positions;
+    static std::vector<float> _radii;
+};
+
+//gameplay runs in fixed steps on its own Scheduler and ActionManager, the render loop only
+//feeds time into an accumulator and draws enemies and missiles interpolated between the last two steps
 class GameController
 {
 public:
+    static const float FixedStep;
+    static const int MaxStepsPerFrame; //time beyond this is dropped, so slow devices slow down instead of spiralling
+    static void reset();
+    //moves a node's timers and actions onto the simulation clock, call it before scheduling anything
+    static void adopt(Node* node);
+    static Scheduler* getScheduler();
+    static ActionManager* getActionManager();
+    //called once per rendered frame, returns the number of steps run
+    static int advance(float dt, Player* player);
+    //a single step, it does not need the Director loop so it can be driven headless
+    static void step(Player* player);
+    static void simulate(float seconds, Player* player);
     static void update(float dt, Player* player);
+    //entities created in a simulation only run get no models, particles or muzzle flashes and play no music,
+    //so the game can be stepped without a GLView, see --simulate in proj.headless
+    static void setSimulationOnly(bool simulationOnly){_simulationOnly = simulationOnly;};
+    static bool isSimulationOnly(){return _simulationOnly;};
+
+protected:
+    static void restoreInterpolated();
+    static bool _simulationOnly;
+    static Scheduler* _scheduler;
+    static ActionManager* _actionManager;
+    static float _accumulator;
+    static Vector<Node*> _lerpNodes;
+    static std::vector<Vec2> _lerpFrom; //position before the last step
+    static std::vector<Vec2> _lerpTo; //position after the last step
+    static std::vector<Vec2> _lerpShown; //what was drawn, only restored if nobody moved the node since
 };
 
 #endif /* defined(__Moon3d__BulletController__) */
@@ -24,6 +24,7 @@
 
 #include "GameEntity.h"
 #include "Sprite3DEffect.h"
+#include "GameControllers.h"
 
 USING_NS_CC_MATH;
 
@@ -49,11 +50,19 @@ void GameEntity::forward(float dist, float angle)
     forward(dist);
 }
 
-void GameEntity::UseOutlineEffect(Sprite3D* sprite, float width, Color3B color)
+Node* GameEntity::createModel(const std::string& model, const std::string& texture)
 {
-    if(nullptr == sprite)
+    if(GameController::isSimulationOnly())
+        return Node::create();
+    return EffectSprite3D::createFromObjFileAndTexture(model, texture);
+}
+
+void GameEntity::UseOutlineEffect(Node* model, float width, Color3B color)
+{
+    if(nullptr == model)
         CCLOGERROR("Can not apply outline effect to a null Sprite3D");
-    EffectSprite3D* _effectSprite3D = dynamic_cast<EffectSprite3D*>(sprite);
+    //the empty models of a simulation only run have nothing to outline
+    EffectSprite3D* _effectSprite3D = dynamic_cast<EffectSprite3D*>(model);
     if(_effectSprite3D)
     {
         Effect3DOutline* effect(nullptr);
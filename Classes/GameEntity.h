@@ -42,7 +42,9 @@ public:
     void forward(float dist);
     void forward(float dist, float angle);
 public:
-    static void UseOutlineEffect(Sprite3D* sprite, float width, Color3B color);
+    //the 3d model, or an empty node in a simulation only run
+    static Node* createModel(const std::string& model, const std::string& texture);
+    static void UseOutlineEffect(Node* model, float width, Color3B color);
 protected:
     Node *_Model;
     float _radius;
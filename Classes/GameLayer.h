@@ -37,6 +37,7 @@ public:
     void update(float dt);
     CREATE_FUNC(GameLayer);
     static bool isDie;
+    Player* getPlayer(){return _player;};
     //virtual void onEnter();
 protected:
     float xScroll;
@@ -46,15 +47,14 @@ protected:
     Player *_player;
     MotionStreak *_streak;
     ParticleSystemQuad *_emissionPart;
+    Node *_enemyLayer; //visited in parallel, see Node::setParallelVisit
+    Node *_effectLayer; //same for the explosions
     void schedulePlayer();
     //QuadTree *_collisionTree;
     
 
 
     //QuadTree *container;
-    void gameMaster(float dt);
-    float _elapsed; //testing purpose, this was set to near boss timer
-    bool _bossOut;
     
 private:
     void removeBulletAndEnmeys(float dt);
@@ -145,20 +145,19 @@ void GameOverLayer::menu_backtomenu()
     Director::getInstance()->replaceScene(MainMenuScene::createScene());
     for(int i=EnemyController::enemies.size()-1;i>=0;i--)
     {
-        EnemyController::enemies.at(i)->removeFromParentAndCleanup(true);
+        EnemyController::erase(i);
     }
-    EnemyController::enemies.clear();
     for(int i=EnemyController::showCaseEnemies.size()-1;i>=0;i--)
     {
         EnemyController::showCaseEnemies.at(i)->removeFromParentAndCleanup(true);
         //EnemyController::showCaseEnemies.erase(i);
     }
     EnemyController::showCaseEnemies.clear();
-    for(int i=BulletController::bullets.size()-1;i>=0;i--)
+    for(int i=BulletController::missiles.size()-1;i>=0;i--)
     {
-        BulletController::bullets.erase(i);
+        BulletController::erase(BulletController::missiles.at(i));
     }
-    BulletController::bullets.clear();
+    BulletController::getBulletSystem()->clear();
 }
 
 void GameOverLayer::menu_playagain_Callback(Ref* sender)
@@ -183,10 +182,11 @@ void GameOverLayer::menu_playagain()
         //EnemyController::erase(i);
         EnemyController::showCaseEnemies.at(i)->removeFromParentAndCleanup(false);
     }
-    for(int i=BulletController::bullets.size()-1;i>=0;i--)
+    for(int i=BulletController::missiles.size()-1;i>=0;i--)
     {
-        BulletController::erase(i);
+        BulletController::erase(BulletController::missiles.at(i));
     }
+    BulletController::getBulletSystem()->clear();
     Director::getInstance()->replaceScene(HelloWorld::createScene());
 }
 
@@ -30,8 +30,12 @@
 
 USING_NS_CC;
 
+int HelloWorld::pendingScore = 0;
+bool HelloWorld::pendingPulse = false;
+
 HelloWorld::~HelloWorld()
 {
+    CC_SAFE_RELEASE(scorePulse);
     //NotificationCenter::getInstance()->destroyInstance();
 }
 
@@ -61,6 +65,7 @@ HelloWorld::HelloWorld()
 :score(0)
 , hpView(nullptr)
 , scoreLabel(nullptr)
+, scorePulse(nullptr)
 {
 }
 
@@ -110,11 +115,18 @@ bool HelloWorld::init()
     this->addChild(rightTopUI);
     
     //the menuitem to show score
-    scoreLabel = LabelAtlas::create("0", "score_right_top.png", 23, 28, '0');
+    scoreLabel = ScoreLabel::create("score_right_top.png", 23, 28);
     scoreLabel->setAnchorPoint(Vec2(1,0.5));
     scoreLabel->setPosition(visibleSize.width-40,visibleSize.height-45);
     this->addChild(scoreLabel);
 
+    //one pulse action, restarted instead of allocating a new one per kill
+    scorePulse = Sequence::create(ScaleTo::create(0.1, 1.2), ScaleTo::create(0.1, 1), NULL);
+    scorePulse->retain();
+    pendingScore = 0;
+    pendingPulse = false;
+    scheduleUpdate();
+
     this->schedule(schedule_selector(HelloWorld::increaseScore), (float)1/10);
     //this->addChild(scoreLabel);
 
@@ -125,15 +137,36 @@ bool HelloWorld::init()
     return true;
 }
 
+void HelloWorld::addScore(int points, bool pulse)
+{
+    pendingScore += points;
+    pendingPulse = pendingPulse || pulse;
+}
+
+void HelloWorld::flushScore()
+{
+    if(!pendingScore)
+        return;
+    score += pendingScore;
+    pendingScore = 0;
+    scoreLabel->setNumber(score);
+    if(pendingPulse)
+    {
+        pendingPulse = false;
+        scoreLabel->stopAction(scorePulse);
+        scoreLabel->setScale(1);
+        scoreLabel->runAction(scorePulse);
+    }
+}
+
+void HelloWorld::update(float dt)
+{
+    flushScore();
+}
+
 void HelloWorld::increaseScore(float dt)
 {
-    this->score++;
-    std::stringstream ss;
-    std::string str;
-    ss<<score;
-    ss>>str;
-    const char *p = str.c_str();
-    scoreLabel->setString(p);
+    addScore(1, false);
 }
 
 void HelloWorld::ShowGameOver(Ref* pObj)
@@ -141,6 +174,7 @@ void HelloWorld::ShowGameOver(Ref* pObj)
     //unschedule(schedule_selector(HelloWorld::increaseScore));
 //    BulletController::reset();
 //    EnemyController::reset();
+    flushScore();
     auto gameoverlayer=GameOverLayer::create(score);
     addChild(gameoverlayer,10);
 }
@@ -26,6 +26,7 @@
 #define __HELLOWORLD_SCENE_H__
 
 #include "cocos2d.h"
+#include "ScoreLabel.h"
 #
 class HelloWorld : public cocos2d::Layer
 {
@@ -41,6 +42,11 @@ public:
     
     // implement the "static create()" method manually
     CREATE_FUNC(HelloWorld);
+    //kills only queue their points, the label is updated once per frame
+    static void addScore(int points, bool pulse = true);
+    //points not on the label yet, with no HelloWorld to flush them, like in a simulation only run, this is the whole score
+    static int getPendingScore(){return pendingScore;};
+    void update(float dt);
 protected:
     HelloWorld();
     ~HelloWorld();
@@ -49,7 +55,11 @@ protected:
 private:
     CC_SYNTHESIZE(cocos2d::ProgressTimer*, hpView, HPView);
     CC_SYNTHESIZE(int, score, Score)
-    CC_SYNTHESIZE(cocos2d::LabelAtlas*, scoreLabel, ScoreLabel);
+    CC_SYNTHESIZE(ScoreLabel*, scoreLabel, ScoreLabel);
+    cocos2d::Action* scorePulse;
+    static int pendingScore;
+    static bool pendingPulse;
+    void flushScore();
     void increaseScore(float dt);
     void ShowGameOver(Ref* pObj);
     
@@ -31,6 +31,8 @@
 #include "ParticleManager.h"
 #include "consts.h"
 #include "Sprite3DEffect.h"
+#include "Effects.h"
+#include <chrono>
 
 int LoadingScene::updatecount=0;
 int LoadingScene::m_curPreload_fodder_count=0;
@@ -38,10 +40,40 @@ int LoadingScene::m_curPreload_fodderL_count=0;
 int LoadingScene::m_curPreload_BigDude_count=0;
 int LoadingScene::m_curPreload_Missile_count=0;
 int LoadingScene::m_curPreload_Boss_count=0;
+int LoadingScene::m_curPreload_Explosion_count=0;
 
 int LoadingScene::audioloaded = false;
 int LoadingScene::particleloaded = false;
 
+static const char* s_preloadPics[TOTAL_PIC_NUM] =
+{
+    "boss.png",
+    "coco.png",
+    "groundLevel.jpg",
+    "bullets.png",
+    "daodan_32.png",
+    "diji02_v002_128.png",
+    "dijiyuanv001.png",
+    "playerv002_256.png",
+    "streak.png",
+    "gameover_score_num_0.png",
+    "num_0.png",
+    "score_right_top.png",
+    "gameover.png"
+};
+
+//everything the pools create, parsed off the main thread so prewarming them only hits the Sprite3DCache
+static const char* s_preloadModels[TOTAL_MODEL_NUM][2] =
+{
+    {"dijiyuanv001.obj", "dijiyuanv001.png"},
+    {"dijiyuanv001.c3b", "dijiyuanv001.png"},
+    {"diji1_v002.c3b", "diji02_v002_128.png"},
+    {"boss.c3b", "boss.png"},
+    {"bossCannon.c3b", "boss.png"},
+    {"daodanv001.c3b", "daodan_32.png"},
+    {"playerv002.c3b", "playerv002_256.png"}
+};
+
 LoadingScene::~LoadingScene()
 {
 }
@@ -132,6 +164,7 @@ void LoadingScene::LoadingResource()
     
     //Loading Picture
     LoadingPic();
+    LoadingModels();
 }
 
 void LoadingScene::LoadingMusic()
@@ -153,22 +186,42 @@ void LoadingScene::LoadingMusic()
 void LoadingScene::LoadingPic()
 {
 	auto TexureCache=Director::getInstance()->getTextureCache();
-    TexureCache->addImageAsync("boss.png",CC_CALLBACK_1(LoadingScene::LoadingCallback,this));
-    TexureCache->addImageAsync("coco.png",CC_CALLBACK_1(LoadingScene::LoadingCallback,this));
-    TexureCache->addImageAsync("groundLevel.jpg", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-	TexureCache->addImageAsync("bullets.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-	TexureCache->addImageAsync("daodan_32.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-	TexureCache->addImageAsync("diji02_v002_128.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-	TexureCache->addImageAsync("dijiyuanv001.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-	TexureCache->addImageAsync("playerv002_256.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-    TexureCache->addImageAsync("streak.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-    
-    TexureCache->addImageAsync("gameover_score_num_0.png",CC_CALLBACK_1(LoadingScene::LoadingCallback,this));
-    TexureCache->addImageAsync("num_0.png",CC_CALLBACK_1(LoadingScene::LoadingCallback,this));
-    TexureCache->addImageAsync("score_right_top.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
-    
-    TexureCache->addImageAsync("gameover.png", CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
+    for(auto pic : s_preloadPics)
+    {
+        TexureCache->addImageAsync(pic, CC_CALLBACK_1(LoadingScene::LoadingCallback, this));
+    }
+}
 
+void LoadingScene::LoadingModels()
+{
+    for(auto model : s_preloadModels)
+    {
+        Sprite3D::createAsync(model[0], model[1], [this](Sprite3D* sprite){
+            modelsLoaded++;
+            LoadingCallback(sprite);
+        });
+    }
+}
+
+void LoadingScene::preloadAll()
+{
+    if(!particleloaded)
+    LoadingParticle();
+    if(!audioloaded)
+    LoadingMusic();
+    auto TexureCache=Director::getInstance()->getTextureCache();
+    for(auto pic : s_preloadPics)
+    {
+        TexureCache->addImage(pic);
+    }
+    SpriteFrameCache::getInstance()->addSpriteFramesWithFile("gameover.plist","gameover.png");
+    while(PreloadNext());
+}
+
+bool LoadingScene::isLoaded() const
+{
+    //explosions are the last pool PreloadNext fills
+    return currentNum == totalNum && m_curPreload_Explosion_count >= PRELOAD_EXPLOSION_COUNT;
 }
 
 void LoadingScene::LoadingCallback(Ref* pObj)
@@ -178,7 +231,7 @@ void LoadingScene::LoadingCallback(Ref* pObj)
 	int percent=(int)(((float)currentNum / totalNum) * 100);
     sprintf(tmp, "%d%%", percent);
     m_pPercent->setString(tmp);
-    m_pProgress->runAction(MoveBy::create(0.01f, Vec2(420/TOTAL_PIC_NUM,0)));
+    m_pProgress->runAction(MoveBy::create(0.01f, Vec2(420.0f/totalNum,0)));
 //    m_pSlider->setValue(percent);
     
 
@@ -210,6 +263,24 @@ void LoadingScene::update(float dt)
     ++updatecount;
     log("updateCount:%d........",updatecount);
     
+    //until the models are cached each prewarm would parse one on the main thread
+    if (modelsLoaded < TOTAL_MODEL_NUM)
+        return;
+    
+    //cache hits are cheap, so prewarm as many as fit in half a frame
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        if (!PreloadNext())
+        {
+            unscheduleUpdate();
+            break;
+        }
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(8));
+}
+
+bool LoadingScene::PreloadNext()
+{
     if (m_curPreload_fodder_count<PRELOAD_FODDER_COUNT) {
         LoadingEnemy(kEnemyFodder);
         m_curPreload_fodder_count++;
@@ -234,10 +305,16 @@ void LoadingScene::update(float dt)
         LoadingEnemy(kEnemyBoss);
         m_curPreload_Boss_count++;
     }
+    else if (m_curPreload_Explosion_count<PRELOAD_EXPLOSION_COUNT)
+    {
+        LoadingExplosion();
+        m_curPreload_Explosion_count++;
+    }
     else
     {
-        unscheduleUpdate();
+        return false;
     }
+    return true;
 }
 
 void LoadingScene::LoadingEnemy(int type)
@@ -245,31 +322,16 @@ void LoadingScene::LoadingEnemy(int type)
     switch(type)
     {
         case kEnemyFodder:
-        {
-            auto enemy_fodder = Fodder::create();
-            enemy_fodder->retain();
-            EnemyController::_fodderPool.pushBack(enemy_fodder);
-        }
+            EnemyController::_fodderPool.prewarm(1);
             break;
         case kEnemyFodderL:
-        {
-            auto enemy_fodderL= FodderLeader::create();
-            enemy_fodderL->retain();
-            EnemyController::_fodderLPool.pushBack(enemy_fodderL);
-        }
+            EnemyController::_fodderLPool.prewarm(1);
             break;
         case kEnemyBigDude:
-        {
-            auto enmey_bigdude= BigDude::create();
-            enmey_bigdude->retain();
-            EnemyController::_bigDudePool.pushBack(enmey_bigdude);
-        }
+            EnemyController::_bigDudePool.prewarm(1);
+            break;
         case kEnemyBoss:
-        {
-            auto enemy_boss =Boss::create();
-            enemy_boss->retain();
-            EnemyController::_bossPool.pushBack(enemy_boss);
-        }
+            EnemyController::_bossPool.prewarm(1);
             break;
         default:
             break;
@@ -280,28 +342,31 @@ void LoadingScene::LoadingBullet(int type)
 {
     switch (type) {
         case kPlayerMissiles:
-            {
-            auto bullet = Missile::create();
-            bullet->retain();
-            BulletController::_missilePool.pushBack(bullet);
-            }
+            BulletController::_missilePool.prewarm(1);
             break;
         default:
             break;
     }
 }
 
+void LoadingScene::LoadingExplosion()
+{
+    EffectManager::_smallExplPool.prewarm(1);
+    EffectManager::_bigExplPool.prewarm(1);
+}
+
 void LoadingScene::LoadingParticle()
 {
     particleloaded = true;
+    //descriptors resolve their sprite frames up front
+    SpriteFrameCache::getInstance()->addSpriteFramesWithFile("Particle.plist","Particle.png");
     auto particle=ParticleManager::getInstance();
-    particle->AddPlistData("missileFlare.plist","missileFlare");
-    particle->AddPlistData("emission.plist", "emission");
-    particle->AddPlistData("missileFlare.plist","missileFlare");
-    particle->AddPlistData("toonSmoke.plist", "toonSmoke");
-    particle->AddPlistData("flare.plist", "flare");
-    particle->AddPlistData("glow.plist", "glow");
-    particle->AddPlistData("debris.plist", "debris");
-    particle->AddPlistData("emissionPart.plist", "emissionPart");
-    particle->AddPlistData("engine.plist", "engine");
+    particle->AddPlistData("missileFlare.plist","missileFlare", "toonFlare.png");
+    particle->AddPlistData("emission.plist", "emission", "toonSmoke.png");
+    particle->AddPlistData("toonSmoke.plist", "toonSmoke", "toonSmoke.png");
+    particle->AddPlistData("flare.plist", "flare", "toonFlare.png");
+    particle->AddPlistData("glow.plist", "glow", "toonGlow.png");
+    particle->AddPlistData("debris.plist", "debris", "toonFlare2.png");
+    particle->AddPlistData("emissionPart.plist", "emissionPart", "engine.jpg");
+    particle->AddPlistData("engine.plist", "engine", "engine2.jpg");
 }
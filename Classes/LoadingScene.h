@@ -32,19 +32,22 @@ USING_NS_CC;
 using namespace CocosDenshion;
 
 #define TOTAL_PIC_NUM 13
+#define TOTAL_MODEL_NUM 7
 
 #define PRELOAD_FODDER_COUNT 18
 #define PRELOAD_FODDERL_COUNT 3
 #define PRELOAD_BIGDUDE_COUBR 5
 #define PRELOAD_MISSILE_COUNT 5
 #define PRElOAD_BOSS_COUNT    1
+#define PRELOAD_EXPLOSION_COUNT 10
 
 class LoadingScene : public Layer
 {
 public:
     
     LoadingScene():currentNum(0),
-    totalNum(TOTAL_PIC_NUM){};
+    totalNum(TOTAL_PIC_NUM+TOTAL_MODEL_NUM),
+    modelsLoaded(0){};
     
     ~LoadingScene();
     
@@ -53,6 +56,10 @@ public:
     virtual bool init();
     
     void update(float dt);
+    //everything the loading screen does, but synchronously and without a scene, used by the headless benchmark
+    static void preloadAll();
+    //true once every texture and model has called back and the pools are prewarmed, the headless benchmark waits for it
+    bool isLoaded() const;
     static int audioloaded;
     CREATE_FUNC(LoadingScene);
     
@@ -60,11 +67,15 @@ private:
     void InitBk();
     void InitCoco();
     void LoadingResource();
-    void LoadingMusic();
+    static void LoadingMusic();
     void LoadingPic();
-    void LoadingEnemy(int type);
-    void LoadingBullet(int type);
-    void LoadingParticle();
+    void LoadingModels();
+    //prewarms the next pooled object, false once all pools are full
+    static bool PreloadNext();
+    static void LoadingEnemy(int type);
+    static void LoadingBullet(int type);
+    static void LoadingExplosion();
+    static void LoadingParticle();
     
     void LoadingCallback(Ref* pObj);
     void GotoNextScene();
@@ -75,6 +86,7 @@ private:
     static bool isReg;
     int currentNum;
     int totalNum;
+    int modelsLoaded;
     
     Sprite* m_pProgress;
     Label* m_pPercent;
@@ -84,6 +96,7 @@ private:
     static int m_curPreload_BigDude_count;
     static int m_curPreload_Missile_count;
     static int m_curPreload_Boss_count;
+    static int m_curPreload_Explosion_count;
     
     static int updatecount;
 
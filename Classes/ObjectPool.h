@@ -0,0 +1,153 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __Moon3d__ObjectPool__
+#define __Moon3d__ObjectPool__
+
+#include "cocos2d.h"
+#include <functional>
+#include <limits>
+
+class ObjectPoolBase
+{
+public:
+    //objects created by every pool since launch, this must stop growing once the pools are warm
+    static unsigned int getTotalCreated(){return totalCreated();};
+protected:
+    static unsigned int& totalCreated()
+    {
+        static unsigned int s_created = 0;
+        return s_created;
+    }
+};
+
+//keeps one reference to every object it has created, acquire/recycle only move
+//pointers between the caller and the free list so a warm pool never touches the heap
+template<class T>
+class ObjectPool : public ObjectPoolBase
+{
+public:
+    typedef std::function<void(T*)> ResetHook;
+
+    explicit ObjectPool(const ResetHook& resetHook = nullptr)
+    : _resetHook(resetHook)
+    , _maxFree(std::numeric_limits<size_t>::max())
+    , _inUse(0)
+    , _highWater(0)
+    , _created(0)
+    {
+    }
+    ~ObjectPool()
+    {
+        clear();
+    }
+
+    //returns a free object, or creates one when the pool is empty
+    T* acquire()
+    {
+        T* obj = nullptr;
+        if(!_free.empty())
+        {
+            obj = _free.back();
+            _free.pop_back();
+        }
+        else
+        {
+            obj = create();
+            if(!obj)
+                return nullptr;
+        }
+        _inUse++;
+        _highWater = std::max(_highWater, _inUse);
+        return obj;
+    }
+    //hands an object back, the reset hook runs before it goes on the free list
+    void recycle(T* obj)
+    {
+        CCASSERT(_inUse > 0, "recycling more objects than were acquired");
+        _inUse--;
+        if(_resetHook)
+            _resetHook(obj);
+        if(_free.size() < _maxFree)
+            _free.push_back(obj);
+        else
+            obj->release();
+    }
+    //creates count more objects up front
+    void prewarm(size_t count)
+    {
+        _free.reserve(_free.size()+count);
+        for(size_t i = 0; i < count; i++)
+        {
+            T* obj = create();
+            if(obj)
+                _free.push_back(obj);
+        }
+    }
+    //shrink policy: recycled objects above this are released instead of kept
+    void setMaxFree(size_t count)
+    {
+        _maxFree = count;
+        shrinkTo(count);
+    }
+    void shrinkTo(size_t count)
+    {
+        while(_free.size() > count)
+        {
+            _free.back()->release();
+            _free.pop_back();
+        }
+    }
+    void clear()
+    {
+        shrinkTo(0);
+    }
+
+    size_t getFreeCount() const {return _free.size();};
+    size_t getInUseCount() const {return _inUse;};
+    size_t getHighWaterMark() const {return _highWater;};
+    unsigned int getCreatedCount() const {return _created;};
+
+protected:
+    T* create()
+    {
+        T* obj = T::create();
+        if(obj)
+        {
+            obj->retain();
+            _created++;
+            totalCreated()++;
+        }
+        return obj;
+    }
+
+    std::vector<T*> _free;
+    ResetHook _resetHook;
+    size_t _maxFree;
+    size_t _inUse;
+    size_t _highWater;
+    unsigned int _created;
+};
+
+#endif /* defined(__Moon3d__ObjectPool__) */
@@ -23,23 +23,288 @@
  ****************************************************************************/
 
 #include "ParticleManager.h"
+#include "base/base64.h"
+#include "base/ZipUtils.h"
 
 ParticleManager* ParticleManager::m_pInstance=NULL;
 ParticleManager::CGarbo ParticleManager::m_garbo;
 ParticleManager::ParticleManager()
 {
-    m_plistMap.clear();
+    m_descriptorMap.clear();
 }
 
-void ParticleManager::AddPlistData(std::string strPlist,std::string strName)
+static const Value& valueFor(const ValueMap& map, const char* key)
 {
+    auto it = map.find(key);
+    return it == map.end() ? Value::Null : it->second;
+}
+
+static Texture2D* loadPlistTexture(const ValueMap& plistData)
+{
+    std::string textureName = valueFor(plistData, "textureFileName").asString();
+    Texture2D* tex = nullptr;
+    if(!textureName.empty())
+    {
+        bool notify = FileUtils::getInstance()->isPopupNotify();
+        FileUtils::getInstance()->setPopupNotify(false);
+        tex = Director::getInstance()->getTextureCache()->addImage(textureName);
+        FileUtils::getInstance()->setPopupNotify(notify);
+    }
+    if(tex)
+        return tex;
+    
+    //the texture is embedded base64-gzipped, decode it once instead of once per instance
+    std::string textureData = valueFor(plistData, "textureImageData").asString();
+    if(textureData.empty())
+        return nullptr;
+    unsigned char* buffer = nullptr;
+    unsigned char* deflated = nullptr;
+    int decodeLen = base64Decode((unsigned char*)textureData.c_str(), (unsigned int)textureData.size(), &buffer);
+    ssize_t deflatedLen = buffer ? ZipUtils::inflateMemory(buffer, decodeLen, &deflated) : 0;
+    if(deflated)
+    {
+        auto image = new (std::nothrow) Image();
+        if(image->initWithImageData(deflated, deflatedLen))
+            tex = Director::getInstance()->getTextureCache()->addImage(image, textureName);
+        image->release();
+    }
+    free(buffer);
+    free(deflated);
+    return tex;
+}
+
+bool ParticleManager::compile(const ValueMap& plistData, const std::string& strFrame, ParticleDescriptor& desc)
+{
+    //same keys and quirks as ParticleSystem::initWithDictionary
+    bool designer2 = !valueFor(plistData, "configName").asString().empty();
+    
+    desc.totalParticles = valueFor(plistData, "maxParticles").asInt();
+    desc.duration = valueFor(plistData, "duration").asFloat();
+    desc.angle = valueFor(plistData, "angle").asFloat();
+    desc.angleVar = valueFor(plistData, "angleVariance").asFloat();
+    desc.blendFunc.src = valueFor(plistData, "blendFuncSource").asInt();
+    desc.blendFunc.dst = valueFor(plistData, "blendFuncDestination").asInt();
+    
+    desc.startColor = Color4F(valueFor(plistData, "startColorRed").asFloat(),
+                              valueFor(plistData, "startColorGreen").asFloat(),
+                              valueFor(plistData, "startColorBlue").asFloat(),
+                              valueFor(plistData, "startColorAlpha").asFloat());
+    desc.startColorVar = Color4F(valueFor(plistData, "startColorVarianceRed").asFloat(),
+                                 valueFor(plistData, "startColorVarianceGreen").asFloat(),
+                                 valueFor(plistData, "startColorVarianceBlue").asFloat(),
+                                 valueFor(plistData, "startColorVarianceAlpha").asFloat());
+    desc.endColor = Color4F(valueFor(plistData, "finishColorRed").asFloat(),
+                            valueFor(plistData, "finishColorGreen").asFloat(),
+                            valueFor(plistData, "finishColorBlue").asFloat(),
+                            valueFor(plistData, "finishColorAlpha").asFloat());
+    desc.endColorVar = Color4F(valueFor(plistData, "finishColorVarianceRed").asFloat(),
+                               valueFor(plistData, "finishColorVarianceGreen").asFloat(),
+                               valueFor(plistData, "finishColorVarianceBlue").asFloat(),
+                               valueFor(plistData, "finishColorVarianceAlpha").asFloat());
+    
+    desc.startSize = valueFor(plistData, "startParticleSize").asFloat();
+    desc.startSizeVar = valueFor(plistData, "startParticleSizeVariance").asFloat();
+    desc.endSize = valueFor(plistData, "finishParticleSize").asFloat();
+    desc.endSizeVar = valueFor(plistData, "finishParticleSizeVariance").asFloat();
+    
+    desc.sourcePosition = Vec2(valueFor(plistData, "sourcePositionx").asFloat(), valueFor(plistData, "sourcePositiony").asFloat());
+    desc.posVar = Vec2(valueFor(plistData, "sourcePositionVariancex").asFloat(), valueFor(plistData, "sourcePositionVariancey").asFloat());
+    
+    desc.startSpin = valueFor(plistData, "rotationStart").asFloat();
+    desc.startSpinVar = valueFor(plistData, "rotationStartVariance").asFloat();
+    desc.endSpin = valueFor(plistData, "rotationEnd").asFloat();
+    desc.endSpinVar = valueFor(plistData, "rotationEndVariance").asFloat();
+    
+    desc.emitterMode = (ParticleSystem::Mode)valueFor(plistData, "emitterType").asInt();
+    desc.modeA.gravity = Vec2(valueFor(plistData, "gravityx").asFloat(), valueFor(plistData, "gravityy").asFloat());
+    desc.modeA.speed = valueFor(plistData, "speed").asFloat();
+    desc.modeA.speedVar = valueFor(plistData, "speedVariance").asFloat();
+    desc.modeA.radialAccel = valueFor(plistData, "radialAcceleration").asFloat();
+    desc.modeA.radialAccelVar = valueFor(plistData, "radialAccelVariance").asFloat();
+    desc.modeA.tangentialAccel = valueFor(plistData, "tangentialAcceleration").asFloat();
+    desc.modeA.tangentialAccelVar = valueFor(plistData, "tangentialAccelVariance").asFloat();
+    desc.modeA.rotationIsDir = valueFor(plistData, "rotationIsDir").asBool();
+    //particle designer 2.0 files get their radius values truncated by the engine, keep doing that
+    desc.modeB.startRadius = designer2 ? valueFor(plistData, "maxRadius").asInt() : valueFor(plistData, "maxRadius").asFloat();
+    desc.modeB.startRadiusVar = valueFor(plistData, "maxRadiusVariance").asFloat();
+    desc.modeB.endRadius = designer2 ? valueFor(plistData, "minRadius").asInt() : valueFor(plistData, "minRadius").asFloat();
+    desc.modeB.endRadiusVar = valueFor(plistData, "minRadiusVariance").asFloat();
+    desc.modeB.rotatePerSecond = designer2 ? valueFor(plistData, "rotatePerSecond").asInt() : valueFor(plistData, "rotatePerSecond").asFloat();
+    desc.modeB.rotatePerSecondVar = valueFor(plistData, "rotatePerSecondVariance").asFloat();
+    
+    desc.life = valueFor(plistData, "particleLifespan").asFloat();
+    desc.lifeVar = valueFor(plistData, "particleLifespanVariance").asFloat();
+    desc.emissionRate = desc.totalParticles / desc.life;
+    
+    auto yFlipped = plistData.find("yCoordFlipped");
+    desc.yCoordFlipped = yFlipped == plistData.end() ? 1 : yFlipped->second.asInt();
+    
+    desc.texture = nullptr;
+    if(!strFrame.empty())
+    {
+        auto frame = SpriteFrameCache::getInstance()->getSpriteFrameByName(strFrame);
+        CCASSERT(frame, "particle sprite frame not loaded");
+        if(frame)
+        {
+            desc.texture = frame->getTexture();
+            desc.textureRect = frame->getRect();
+        }
+    }
+    else
+    {
+        desc.texture = loadPlistTexture(plistData);
+        if(desc.texture)
+            desc.textureRect = Rect(0, 0, desc.texture->getContentSize().width, desc.texture->getContentSize().height);
+    }
+    //held for as long as the descriptor, so purging unused textures can't pull it from under us
+    CC_SAFE_RETAIN(desc.texture);
+    
+    return desc.totalParticles > 0 && (desc.emitterMode == ParticleSystem::Mode::GRAVITY || desc.emitterMode == ParticleSystem::Mode::RADIUS);
+}
+
+void ParticleManager::AddPlistData(const std::string& strPlist, const std::string& strName, const std::string& strFrame)
+{
+    if(m_descriptorMap.find(strName) != m_descriptorMap.end())
+        return;
     auto plistData=FileUtils::getInstance()->getValueMapFromFile(strPlist);
-    std::map<std::string, ValueMap>::iterator it = m_plistMap.begin();
-    m_plistMap.insert(it,std::pair<std::string, ValueMap>(strName,plistData));
+    ParticleDescriptor desc;
+    if(compile(plistData, strFrame, desc))
+        m_descriptorMap.insert(std::make_pair(strName, desc));
+    else
+        CCLOG("ParticleManager: %s is not a valid particle plist", strPlist.c_str());
+}
+
+const ParticleDescriptor& ParticleManager::GetPlistData(const std::string& strName) const
+{
+    auto it = m_descriptorMap.find(strName);
+    CCASSERT(it != m_descriptorMap.end(), "particle plist not loaded");
+    return it->second;
+}
+
+ParticleEmitter* ParticleManager::createParticle(const std::string& strName) const
+{
+    return ParticleEmitter::create(GetPlistData(strName));
+}
+
+ParticleEmitter* ParticleEmitter::create(const ParticleDescriptor& desc)
+{
+    auto ret = new (std::nothrow) ParticleEmitter();
+    if(ret && ret->initWithDescriptor(desc))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+bool ParticleEmitter::initWithDescriptor(const ParticleDescriptor& desc)
+{
+    if(!initWithTotalParticles(desc.totalParticles))
+        return false;
+    _duration = desc.duration;
+    _emissionRate = desc.emissionRate;
+    _emitterMode = desc.emitterMode;
+    _blendFunc = desc.blendFunc;
+    _startColor = desc.startColor;
+    _startColorVar = desc.startColorVar;
+    _endColor = desc.endColor;
+    _endColorVar = desc.endColorVar;
+    _startSize = desc.startSize;
+    _startSizeVar = desc.startSizeVar;
+    _endSize = desc.endSize;
+    _endSizeVar = desc.endSizeVar;
+    setPosition(desc.sourcePosition);
+    _posVar = desc.posVar;
+    _startSpin = desc.startSpin;
+    _startSpinVar = desc.startSpinVar;
+    _endSpin = desc.endSpin;
+    _endSpinVar = desc.endSpinVar;
+    _angle = desc.angle;
+    _angleVar = desc.angleVar;
+    _life = desc.life;
+    _lifeVar = desc.lifeVar;
+    _yCoordFlipped = desc.yCoordFlipped;
+    
+    modeA.gravity = desc.modeA.gravity;
+    modeA.speed = desc.modeA.speed;
+    modeA.speedVar = desc.modeA.speedVar;
+    modeA.radialAccel = desc.modeA.radialAccel;
+    modeA.radialAccelVar = desc.modeA.radialAccelVar;
+    modeA.tangentialAccel = desc.modeA.tangentialAccel;
+    modeA.tangentialAccelVar = desc.modeA.tangentialAccelVar;
+    modeA.rotationIsDir = desc.modeA.rotationIsDir;
+    modeB.startRadius = desc.modeB.startRadius;
+    modeB.startRadiusVar = desc.modeB.startRadiusVar;
+    modeB.endRadius = desc.modeB.endRadius;
+    modeB.endRadiusVar = desc.modeB.endRadiusVar;
+    modeB.rotatePerSecond = desc.modeB.rotatePerSecond;
+    modeB.rotatePerSecondVar = desc.modeB.rotatePerSecondVar;
+    
+    _opacityModifyRGB = false;
+    if(desc.texture)
+        setTextureWithRect(desc.texture, desc.textureRect);
+    return true;
+}
+
+void ParticleEmitter::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    if(_particleIdx == 0 || !_texture)
+        return;
+    _quadCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc, _quads, _particleIdx, transform);
+    if(_batched && ParticleBatch::isBatching())
+        ParticleBatch::defer(this);
+    else
+        renderer->addCommand(&_quadCommand);
+}
+
+int ParticleBatch::s_running = 0;
+Vector<ParticleEmitter*> ParticleBatch::s_deferred;
+
+void ParticleBatch::defer(ParticleEmitter* emitter)
+{
+    if(Renderer::isRecording())
+    {
+        //from a parallel visit, queued in visit order when the recording is merged
+        Director::getInstance()->getRenderer()->runInVisitOrder([emitter](){ s_deferred.pushBack(emitter); });
+        return;
+    }
+    s_deferred.pushBack(emitter);
+}
+
+void ParticleBatch::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    if(s_deferred.empty())
+        return;
+    //alpha blended smoke has to keep its visit order, it goes first and merges wherever neighbours share a material.
+    //additive flares add up to the same picture in any order, so they follow grouped by material
+    for(auto emitter : s_deferred)
+    {
+        const auto& blend = emitter->getBlendFunc();
+        if(blend.dst == GL_ONE && (blend.src == GL_ONE || blend.src == GL_SRC_ALPHA))
+            _additive.push_back(emitter);
+        else
+            renderer->addCommand(&emitter->_quadCommand);
+    }
+    //stable, so emitters sharing a material keep their visit order
+    std::stable_sort(_additive.begin(), _additive.end(), [](ParticleEmitter* a, ParticleEmitter* b){
+        return a->_quadCommand.getMaterialID() < b->_quadCommand.getMaterialID();
+    });
+    for(auto emitter : _additive)
+        renderer->addCommand(&emitter->_quadCommand);
+    _additive.clear();
+    s_deferred.clear();
+}
+
+void ParticleBatch::onEnter()
+{
+    Node::onEnter();
+    s_running++;
 }
 
-ValueMap ParticleManager::GetPlistData(std::string strplist)
+void ParticleBatch::onExit()
 {
-    auto plistData=m_plistMap.find(strplist)->second;
-    return plistData;
+    if(--s_running == 0)
+        s_deferred.clear();
+    Node::onExit();
 }
@@ -29,6 +29,102 @@
 
 USING_NS_CC;
 
+//everything ParticleSystem::initWithDictionary reads out of a plist, parsed once when the plist is added
+struct ParticleDescriptor
+{
+    int totalParticles;
+    float duration;
+    float emissionRate;
+    ParticleSystem::Mode emitterMode;
+    BlendFunc blendFunc;
+    Color4F startColor;
+    Color4F startColorVar;
+    Color4F endColor;
+    Color4F endColorVar;
+    float startSize;
+    float startSizeVar;
+    float endSize;
+    float endSizeVar;
+    Vec2 sourcePosition;
+    Vec2 posVar;
+    float startSpin;
+    float startSpinVar;
+    float endSpin;
+    float endSpinVar;
+    float angle;
+    float angleVar;
+    float life;
+    float lifeVar;
+    int yCoordFlipped;
+    
+    //Mode::GRAVITY
+    struct {
+        Vec2 gravity;
+        float speed;
+        float speedVar;
+        float radialAccel;
+        float radialAccelVar;
+        float tangentialAccel;
+        float tangentialAccelVar;
+        bool rotationIsDir;
+    } modeA;
+    
+    //Mode::RADIUS
+    struct {
+        float startRadius;
+        float startRadiusVar;
+        float endRadius;
+        float endRadiusVar;
+        float rotatePerSecond;
+        float rotatePerSecondVar;
+    } modeB;
+    
+    //resolved once, either from a sprite frame or from the texture embedded in the plist
+    Texture2D* texture;
+    Rect textureRect;
+};
+
+//a ParticleSystemQuad that is set up from a descriptor by plain member copies instead of parsing a ValueMap
+class ParticleEmitter : public ParticleSystemQuad
+{
+public:
+    static ParticleEmitter* create(const ParticleDescriptor& desc);
+    bool initWithDescriptor(const ParticleDescriptor& desc);
+    virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+    //batched emitters hand their command to the running ParticleBatch instead of the renderer
+    CC_SYNTHESIZE(bool, _batched, Batched);
+    
+protected:
+    friend class ParticleBatch;
+    ParticleEmitter():_batched(false){};
+};
+
+//the renderer already merges consecutive quad commands with the same texture, shader and blend func
+//into one draw call, but explosions and missiles interleave smoke (alpha) and flares (additive) so
+//nothing merges. batched emitters hand their command to the next batch in visit order instead, which
+//submits the alpha blended ones in visit order and then the additive ones grouped by material. all the
+//particle frames are in Particle.png, so that is one draw call for the smoke and one for the flares.
+//this puts every flare above all the smoke of the same batch, smoke of a later explosion no longer
+//covers an earlier flare. every emitter keeps its own transform so FREE particles and 3d rotation still work.
+//a batch draws the emitters visited since the previous one, so add one right above each group of
+//batched emitters, at the z order they should be drawn at
+class ParticleBatch : public Node
+{
+public:
+    CREATE_FUNC(ParticleBatch);
+    //emitters are only batched while a batch is running
+    static bool isBatching(){return s_running > 0;};
+    static void defer(ParticleEmitter* emitter);
+    virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    
+protected:
+    static int s_running;
+    static Vector<ParticleEmitter*> s_deferred;
+    std::vector<ParticleEmitter*> _additive;
+};
+
 class ParticleManager
 {
 public:
@@ -60,13 +156,18 @@ private:
     
     static CGarbo m_garbo;
     
+    static bool compile(const ValueMap& plistData, const std::string& strFrame, ParticleDescriptor& desc);
+    
 public:
     
-    std::map<std::string, ValueMap> m_plistMap;
+    std::map<std::string, ParticleDescriptor> m_descriptorMap;
+    
+    //strFrame names the sprite frame the effect is drawn with, empty means the plist's own texture
+    void AddPlistData(const std::string& strPlist, const std::string& strName, const std::string& strFrame = "");
     
-    void AddPlistData(std::string strPlist,std::string strName);
+    const ParticleDescriptor& GetPlistData(const std::string& strName) const;
     
-    ValueMap GetPlistData(std::string strplist);
+    ParticleEmitter* createParticle(const std::string& strName) const;
 };
 
 #endif /* defined(__Moon3d__ParticleManager__) */
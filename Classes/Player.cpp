@@ -42,7 +42,8 @@ const float Player::rollReturnThreshold = 1.02;
 
 bool Player::init()
 {
-    _Model = EffectSprite3D::createFromObjFileAndTexture("playerv002.c3b", "playerv002_256.png");
+    GameController::adopt(this);
+    _Model = GameEntity::createModel("playerv002.c3b", "playerv002_256.png");
     if(_Model)
     {
 		targetAngle = 0;
@@ -55,6 +56,7 @@ bool Player::init()
         _radius = 40;
         _HP = 100;
         _alive = true;
+        _invincible = false;
         
         auto listener = EventListenerTouchOneByOne::create();
         listener->setSwallowTouches(true);
@@ -65,20 +67,20 @@ bool Player::init()
         
         _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
         //scheduleUpdate();
-        GameEntity::UseOutlineEffect(static_cast<Sprite3D*>(_Model), 0.02, Color3B(0,0,0));
+        GameEntity::UseOutlineEffect(_Model, 0.02, Color3B(0,0,0));
         
         schedule(schedule_selector(Player::shootMissile), 1.5, -1, 0);
         schedule(schedule_selector(Player::shoot), 0.075, -1, 0);
         
         // engine trail
-        auto part_frame=SpriteFrameCache::getInstance()->getSpriteFrameByName("engine2.jpg");
-        ValueMap vm=ParticleManager::getInstance()->GetPlistData("engine");
-        auto part = ParticleSystemQuad::create(vm);
-        part->setTextureWithRect(part_frame->getTexture(), part_frame->getRect());
-        addChild(part);
-        part->setPosition(0,-30);
-        part->setScale(0.6);
-        //part->setRotation(90);
+        if(!GameController::isSimulationOnly())
+        {
+            auto part = ParticleManager::getInstance()->createParticle("engine");
+            addChild(part);
+            part->setPosition(0,-30);
+            part->setScale(0.6);
+            //part->setRotation(90);
+        }
         
         //controller support ios and android
 #if(CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
@@ -258,9 +260,9 @@ void Player::setPosition(Vec2 pos)
 }
 void Player::shootMissile(float dt)
 {
-    auto left = BulletController::spawnBullet(kPlayerMissiles, getPosition()+Vec2(-50,-20), Vec2(-200,-200));
+    auto left = BulletController::spawnMissile(getPosition()+Vec2(-50,-20), Vec2(-200,-200));
     left->setRotation(-45);
-    auto right = BulletController::spawnBullet(kPlayerMissiles, getPosition()+Vec2(50,-20), Vec2(200,-200));
+    auto right = BulletController::spawnMissile(getPosition()+Vec2(50,-20), Vec2(200,-200));
     right->setRotation(45);
 }
 
@@ -275,22 +277,28 @@ void Player::hideWarningLayer(Node* node)
         node->setVisible(false);
 }
 bool Player::hurt(float damage){
+    if(_invincible)
+        return false;
     float fromHP = _HP;
     float toHP = _HP-=damage;
     
-    auto fade = FadeTo::create(0.2, 40);
-    auto fadeBack = FadeTo::create(0.2, 0);
-    auto warningLayer = Director::getInstance()->getRunningScene()->getChildByTag(456);
-    warningLayer->setVisible(true);
-    warningLayer->runAction(Sequence::create(fade,fadeBack,
-                                             CallFunc::create(
-                                                              CC_CALLBACK_0(Player::hideWarningLayer, this, warningLayer)
-                                                              ),NULL));
-    
-    auto hpView = ((HelloWorld*)Director::getInstance()->getRunningScene()->getChildByTag(100))->getHPView();
-    
-    auto to = ProgressFromTo::create(0.5, PublicApi::hp2percent(fromHP), PublicApi::hp2percent(toHP));
-    hpView->runAction(to);
+    //a simulation only run has no scene with a warning layer and hp bar
+    if(!GameController::isSimulationOnly())
+    {
+        auto fade = FadeTo::create(0.2, 40);
+        auto fadeBack = FadeTo::create(0.2, 0);
+        auto warningLayer = Director::getInstance()->getRunningScene()->getChildByTag(456);
+        warningLayer->setVisible(true);
+        warningLayer->runAction(Sequence::create(fade,fadeBack,
+                                                 CallFunc::create(
+                                                                  CC_CALLBACK_0(Player::hideWarningLayer, this, warningLayer)
+                                                                  ),NULL));
+        
+        auto hpView = ((HelloWorld*)Director::getInstance()->getRunningScene()->getChildByTag(100))->getHPView();
+        
+        auto to = ProgressFromTo::create(0.5, PublicApi::hp2percent(fromHP), PublicApi::hp2percent(toHP));
+        hpView->runAction(to);
+    }
     
     if(_HP <= 0  && _alive)
     {
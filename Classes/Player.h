@@ -62,6 +62,7 @@ public:
     virtual bool hurt(float damage);
     virtual void die();
     void hideWarningLayer(Node* node);
+    CC_SYNTHESIZE(bool, _invincible, Invincible); //the benchmark uses it to play through the whole level
     
 #if(CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     //对游戏手柄的响应
@@ -0,0 +1,119 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ScoreLabel.h"
+
+ScoreLabel::ScoreLabel()
+: _number(0)
+, _length(1)
+{
+    _digits[0] = '0';
+    _digits[1] = 0;
+}
+
+ScoreLabel* ScoreLabel::create(const std::string& charMapFile, int itemWidth, int itemHeight)
+{
+    auto label = new (std::nothrow) ScoreLabel();
+    if(label && label->initWithString(label->_digits, charMapFile, itemWidth, itemHeight, '0'))
+    {
+        label->autorelease();
+        return label;
+    }
+    CC_SAFE_DELETE(label);
+    return nullptr;
+}
+
+int ScoreLabel::formatNumber(unsigned int number, char* buffer)
+{
+    char reversed[MaxDigits];
+    int length = 0;
+    do
+    {
+        reversed[length++] = '0'+number%10;
+        number /= 10;
+    } while(number);
+    for(int i = 0; i < length; i++)
+        buffer[i] = reversed[length-1-i];
+    buffer[length] = 0;
+    return length;
+}
+
+void ScoreLabel::setNumber(unsigned int number)
+{
+    if(number == _number)
+        return;
+    _number = number;
+    char digits[MaxDigits+1];
+    int length = formatNumber(number, digits);
+    if(length != _length)
+    {
+        //one more digit, the content size changes too, so let LabelAtlas rebuild it
+        memcpy(_digits, digits, length+1);
+        _length = length;
+        setString(_digits);
+        return;
+    }
+    for(int i = 0; i < length; i++)
+    {
+        if(digits[i] != _digits[i])
+            updateDigit(i, digits[i]);
+    }
+}
+
+void ScoreLabel::updateDigit(int index, char digit)
+{
+    _digits[index] = digit;
+    _string[index] = digit;
+
+    Texture2D *texture = _textureAtlas->getTexture();
+    float textureWide = (float) texture->getPixelsWide();
+    float textureHigh = (float) texture->getPixelsHigh();
+    float itemWidthInPixels = _ignoreContentScaleFactor ? _itemWidth : _itemWidth * CC_CONTENT_SCALE_FACTOR();
+    float itemHeightInPixels = _ignoreContentScaleFactor ? _itemHeight : _itemHeight * CC_CONTENT_SCALE_FACTOR();
+    unsigned char a = digit - _mapStartChar;
+    float row = (float) (a % _itemsPerRow);
+    float col = (float) (a / _itemsPerRow);
+    //same mapping as LabelAtlas::updateAtlasValues
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+    float left = (2 * row * itemWidthInPixels + 1) / (2 * textureWide);
+    float right = left + (itemWidthInPixels * 2 - 2) / (2 * textureWide);
+    float top = (2 * col * itemHeightInPixels + 1) / (2 * textureHigh);
+    float bottom = top + (itemHeightInPixels * 2 - 2) / (2 * textureHigh);
+#else
+    float left = row * itemWidthInPixels / textureWide;
+    float right = left + itemWidthInPixels / textureWide;
+    float top = col * itemHeightInPixels / textureHigh;
+    float bottom = top + itemHeightInPixels / textureHigh;
+#endif
+    auto& quad = _textureAtlas->getQuads()[index];
+    quad.tl.texCoords.u = left;
+    quad.tl.texCoords.v = top;
+    quad.tr.texCoords.u = right;
+    quad.tr.texCoords.v = top;
+    quad.bl.texCoords.u = left;
+    quad.bl.texCoords.v = bottom;
+    quad.br.texCoords.u = right;
+    quad.br.texCoords.v = bottom;
+    _textureAtlas->setDirty(true);
+}
@@ -0,0 +1,51 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __Moon3d__ScoreLabel__
+#define __Moon3d__ScoreLabel__
+
+#include "cocos2d.h"
+USING_NS_CC;
+
+//LabelAtlas for a non negative number, formats without allocating and only rewrites
+//the quads of digits that changed, the whole string is only rebuilt when the digit count grows
+class ScoreLabel : public LabelAtlas
+{
+public:
+    static ScoreLabel* create(const std::string& charMapFile, int itemWidth, int itemHeight);
+    void setNumber(unsigned int number);
+    unsigned int getNumber() const {return _number;};
+    //writes number into buffer, which needs room for MaxDigits plus the terminator, and returns the length
+    static int formatNumber(unsigned int number, char* buffer);
+    static const int MaxDigits = 10;
+
+protected:
+    ScoreLabel();
+    void updateDigit(int index, char digit);
+    unsigned int _number;
+    int _length;
+    char _digits[MaxDigits+1];
+};
+
+#endif /* defined(__Moon3d__ScoreLabel__) */
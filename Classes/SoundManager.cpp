@@ -0,0 +1,182 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "SoundManager.h"
+#include "SimpleAudioEngine.h"
+
+const int SoundManager::MaxVoices = 8;
+bool SoundManager::_inited = false;
+float SoundManager::_time = 0;
+std::vector<SoundManager::Effect> SoundManager::_effects;
+std::vector<int> SoundManager::_requests;
+std::vector<SoundManager::Voice> SoundManager::_voices;
+SoundStats SoundManager::_stats = {0,0,0,0,0};
+
+void SoundManager::init()
+{
+    _inited = true;
+    _voices.reserve(MaxVoices);
+    //higher priority wins when all voices are busy, the big explosions matter more than bullet hits
+    registerEffect("hit.mp3", 0.3, 3, 0);
+    registerEffect("boom.mp3", 0.6, 3, 1);
+    registerEffect("boom2.mp3", 0.8, 3, 2);
+    registerEffect("explodeEffect.mp3", 1.2, 4, 3);
+    //runs on the Director's clock so queued effects still play when the game layer stops updating
+    Director::getInstance()->getScheduler()->schedule(SoundManager::update, &_inited, 0, false, "SoundManager");
+}
+
+void SoundManager::registerEffect(const char* file, float duration, int maxVoices, int priority)
+{
+    int i = findEffect(file);
+    if(i < 0)
+    {
+        Effect e;
+        e.file = file;
+        e.requested = false;
+        e.voices = 0;
+        _effects.push_back(e);
+        i = _effects.size()-1;
+    }
+    _effects[i].duration = duration;
+    _effects[i].maxVoices = maxVoices;
+    _effects[i].priority = priority;
+}
+
+int SoundManager::findEffect(const char* file)
+{
+    //only a handful of effects, a linear compare avoids building a key string per call
+    for(size_t i = 0; i < _effects.size(); i++)
+    {
+        if(_effects[i].file == file)
+            return i;
+    }
+    return -1;
+}
+
+void SoundManager::playEffect(const char* file)
+{
+    if(!_inited)
+        init();
+    _stats.requested++;
+    int i = findEffect(file);
+    if(i < 0)
+    {
+        registerEffect(file, 1, 2, 0);
+        i = _effects.size()-1;
+    }
+    if(_effects[i].requested)
+    {
+        _stats.coalesced++;
+        return;
+    }
+    _effects[i].requested = true;
+    _requests.push_back(i);
+}
+
+void SoundManager::update(float dt)
+{
+    _time += dt;
+    for(size_t v = _voices.size(); v-- > 0;)
+    {
+        if(_voices[v].end <= _time)
+        {
+            _effects[_voices[v].effect].voices--;
+            _voices[v] = _voices.back();
+            _voices.pop_back();
+        }
+    }
+    for(auto i : _requests)
+    {
+        _effects[i].requested = false;
+        play(i);
+    }
+    _requests.clear();
+}
+
+void SoundManager::play(int effect)
+{
+    auto& e = _effects[effect];
+    int steal = -1;
+    if(e.voices >= e.maxVoices)
+    {
+        //restart the oldest voice of the same effect
+        for(size_t v = 0; v < _voices.size(); v++)
+        {
+            if(_voices[v].effect == effect && (steal < 0 || _voices[v].end < _voices[steal].end))
+                steal = v;
+        }
+    }
+    else if((int)_voices.size() >= MaxVoices)
+    {
+        //take the lowest priority voice, the oldest one among equals, but never a more important one
+        for(size_t v = 0; v < _voices.size(); v++)
+        {
+            int p = _effects[_voices[v].effect].priority;
+            if(p > e.priority)
+                continue;
+            if(steal < 0 || p < _effects[_voices[steal].effect].priority
+               || (p == _effects[_voices[steal].effect].priority && _voices[v].end < _voices[steal].end))
+                steal = v;
+        }
+        if(steal < 0)
+        {
+            _stats.dropped++;
+            return;
+        }
+    }
+    if(steal >= 0)
+    {
+        stopVoice(steal);
+        _stats.stolen++;
+    }
+    Voice voice;
+    voice.effect = effect;
+    voice.id = CocosDenshion::SimpleAudioEngine::getInstance()->playEffect(e.file.c_str());
+    voice.end = _time+e.duration;
+    _voices.push_back(voice);
+    e.voices++;
+    _stats.played++;
+}
+
+void SoundManager::stopVoice(size_t voice)
+{
+    CocosDenshion::SimpleAudioEngine::getInstance()->stopEffect(_voices[voice].id);
+    _effects[_voices[voice].effect].voices--;
+    _voices[voice] = _voices.back();
+    _voices.pop_back();
+}
+
+void SoundManager::stopAll()
+{
+    while(!_voices.empty())
+        stopVoice(_voices.size()-1);
+    for(auto i : _requests)
+        _effects[i].requested = false;
+    _requests.clear();
+}
+
+void SoundManager::resetStats()
+{
+    _stats = {0,0,0,0,0};
+}
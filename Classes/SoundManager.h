@@ -0,0 +1,83 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __Moon3d__SoundManager__
+#define __Moon3d__SoundManager__
+
+#include "cocos2d.h"
+USING_NS_CC;
+
+struct SoundStats
+{
+    unsigned int requested;
+    unsigned int played;
+    unsigned int coalesced; //same effect asked for again in the same frame
+    unsigned int dropped; //no voice free and nothing with a lower priority to steal
+    unsigned int stolen;
+};
+
+//sits in front of SimpleAudioEngine::playEffect, requests are collected during the frame and
+//played once per frame, at most once per effect, within per effect and global voice caps
+class SoundManager
+{
+public:
+    //duration is how long a voice is counted as busy, SimpleAudioEngine can not tell when an effect ends
+    static void registerEffect(const char* file, float duration, int maxVoices, int priority);
+    static void playEffect(const char* file);
+    static void stopAll();
+    static const SoundStats& getStats(){return _stats;};
+    static void resetStats();
+    static const int MaxVoices;
+
+protected:
+    struct Effect
+    {
+        std::string file;
+        float duration;
+        int maxVoices;
+        int priority;
+        bool requested;
+        int voices;
+    };
+    struct Voice
+    {
+        int effect;
+        unsigned int id;
+        float end;
+    };
+    static void init();
+    static int findEffect(const char* file);
+    static void update(float dt);
+    static void play(int effect);
+    static void stopVoice(size_t voice);
+
+    static bool _inited;
+    static float _time;
+    static std::vector<Effect> _effects;
+    static std::vector<int> _requests;
+    static std::vector<Voice> _voices;
+    static SoundStats _stats;
+};
+
+#endif /* defined(__Moon3d__SoundManager__) */
@@ -220,12 +220,248 @@ void Effect3DOutline::drawWithSprite(EffectSprite3D* sprite, const Mat4 &transfo
     }
 }
 
+bool Effect3DOutline::batchWithSprite(EffectSprite3D* sprite, const Mat4 &transform)
+{
+    auto batch = Effect3DOutlineBatch::getRunning();
+    if(!batch)
+        return false;
+    batch->add(this, sprite, transform);
+    return true;
+}
+
+Effect3DOutlineBatch* Effect3DOutlineBatch::s_running = nullptr;
+
+const std::string Effect3DOutlineBatch::_vertShaderFile = "Shaders3D/OutLineInstanced.vert";
+const std::string Effect3DOutlineBatch::_fragShaderFile = "Shaders3D/OutLineInstanced.frag";
+const std::string Effect3DOutlineBatch::_keyInGLProgramCache = "Effect3DLibrary_OutlineInstanced";
+//right after the instance color the engine reserves for the instanced 3d program
+static const GLuint VERTEX_ATTRIB_INSTANCE_WIDTH = GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR + 1;
+
+GLProgram* Effect3DOutlineBatch::getOrCreateProgram()
+{
+    auto program = GLProgramCache::getInstance()->getGLProgram(_keyInGLProgramCache);
+    if(program == nullptr)
+    {
+        program = new GLProgram();
+        program->initWithFilenames(_vertShaderFile, _fragShaderFile);
+        program->bindAttribLocation(GLProgram::ATTRIBUTE_NAME_INSTANCE_MV, GLProgram::VERTEX_ATTRIB_INSTANCE_MV);
+        program->bindAttribLocation(GLProgram::ATTRIBUTE_NAME_INSTANCE_COLOR, GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR);
+        program->bindAttribLocation("a_instanceWidth", VERTEX_ATTRIB_INSTANCE_WIDTH);
+        program->link();
+        program->updateUniforms();
+        GLProgramCache::getInstance()->addGLProgram(program, _keyInGLProgramCache);
+        program->release();
+    }
+    return program;
+}
+
+Effect3DOutlineBatch::Effect3DOutlineBatch()
+: _instanceVBO(0)
+{
+    
+}
+
+Effect3DOutlineBatch::~Effect3DOutlineBatch()
+{
+    if(_instanceVBO)
+        glDeleteBuffers(1, &_instanceVBO);
+}
+
+void Effect3DOutlineBatch::onEnter()
+{
+    Node::onEnter();
+    s_running = this;
+}
+
+void Effect3DOutlineBatch::onExit()
+{
+    if(s_running == this)
+        s_running = nullptr;
+    _pending.clear();
+    Node::onExit();
+}
+
+void Effect3DOutlineBatch::add(Effect3DOutline* effect, EffectSprite3D* sprite, const Mat4 &transform)
+{
+    Color4F color(sprite->getDisplayedColor());
+    color.a = sprite->getDisplayedOpacity() / 255.0f;
+    const Vec3& outline = effect->getOutlineColor();
+    Instance instance;
+    instance.mesh = sprite->getMesh();
+    instance.mv = transform;
+    instance.color = Vec4(outline.x * color.r, outline.y * color.g, outline.z * color.b, color.a);
+    instance.width = effect->getOutlineWidth();
+    if(Renderer::isRecording())
+    {
+        //from a parallel visit, queued in visit order when the recording is merged
+        Director::getInstance()->getRenderer()->runInVisitOrder([this, instance](){ _pending.push_back(instance); });
+        return;
+    }
+    _pending.push_back(instance);
+}
+
+static bool sameMesh(Mesh* a, Mesh* b)
+{
+    return a->getVertexBuffer() == b->getVertexBuffer() && a->getIndexBuffer() == b->getIndexBuffer();
+}
+
+void Effect3DOutlineBatch::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
+    //the previous frame has been rendered by now, its instances can go
+    _drawing.swap(_pending);
+    _pending.clear();
+    if(_drawing.empty())
+        return;
+    std::stable_sort(_drawing.begin(), _drawing.end(), [](const Instance& a, const Instance& b){
+        if(a.mesh->getVertexBuffer() != b.mesh->getVertexBuffer())
+            return a.mesh->getVertexBuffer() < b.mesh->getVertexBuffer();
+        return a.mesh->getIndexBuffer() < b.mesh->getIndexBuffer();
+    });
+    
+    size_t groups = 1;
+    for(size_t i = 1; i < _drawing.size(); i++)
+    {
+        if(!sameMesh(_drawing[i].mesh, _drawing[i-1].mesh))
+            groups++;
+    }
+    if(_commands.size() < groups)
+        _commands.resize(groups);
+    
+    size_t group = 0;
+    size_t first = 0;
+    for(size_t i = 1; i <= _drawing.size(); i++)
+    {
+        if(i < _drawing.size() && sameMesh(_drawing[i].mesh, _drawing[first].mesh))
+            continue;
+        CustomCommand &cc = _commands[group++];
+        cc.init(_globalZOrder);
+        cc.func = CC_CALLBACK_0(Effect3DOutlineBatch::drawGroup, this, first, i);
+        renderer->addCommand(&cc);
+        first = i;
+    }
+}
+
+void Effect3DOutlineBatch::drawGroup(size_t first, size_t last)
+{
+    auto mesh = _drawing[first].mesh;
+    GLsizei count = (GLsizei)(last - first);
+    
+    //state, buffers and vertex layout once for the whole group
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glEnable(GL_DEPTH_TEST);
+    GL::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->getVertexBuffer());
+    GL::enableVertexAttribs(1 << GLProgram::VERTEX_ATTRIB_POSITION | 1 << GLProgram::VERTEX_ATTRIB_NORMAL);
+    long offset = 0;
+    for (auto i = 0; i < mesh->getMeshVertexAttribCount(); i++)
+    {
+        auto meshvertexattrib = mesh->getMeshVertexAttribute(i);
+        if(meshvertexattrib.vertexAttrib == GLProgram::VERTEX_ATTRIB_POSITION || meshvertexattrib.vertexAttrib == GLProgram::VERTEX_ATTRIB_NORMAL)
+            glVertexAttribPointer(meshvertexattrib.vertexAttrib, meshvertexattrib.size, meshvertexattrib.type, GL_FALSE, mesh->getVertexSizeInBytes(), (GLvoid*)offset);
+        offset += meshvertexattrib.attribSizeBytes;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->getIndexBuffer());
+    
+    if(count > 1 && Configuration::getInstance()->supportsInstancedArrays())
+    {
+        drawInstanced(&_drawing[first], count);
+    }
+    else
+    {
+        auto program = Effect3DOutline::getOrCreateProgram();
+        program->use();
+        GLint widthLocation = program->getUniformLocation("OutlineWidth");
+        GLint colorLocation = program->getUniformLocation("u_color");
+        //the outline color is already folded into the instance color
+        program->setUniformLocationWith3f(program->getUniformLocation("OutLineColor"), 1, 1, 1);
+        for(size_t i = first; i < last; i++)
+        {
+            const Instance& instance = _drawing[i];
+            program->setUniformsForBuiltins(instance.mv);
+            program->setUniformLocationWith1f(widthLocation, instance.width);
+            program->setUniformLocationWith4f(colorLocation, instance.color.x, instance.color.y, instance.color.z, instance.color.w);
+            glDrawElements((GLenum)mesh->getPrimitiveType(), mesh->getIndexCount(), (GLenum)mesh->getIndexFormat(), (GLvoid*)0);
+        }
+        CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(count, mesh->getIndexCount() * count);
+    }
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisable(GL_DEPTH_TEST);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+}
+
+void Effect3DOutlineBatch::drawInstanced(const Instance* instances, GLsizei count)
+{
+#if CC_USE_INSTANCED_MESHES
+    static const int FLOATS_PER_INSTANCE = 16 + 4 + 1;
+    static const GLsizei INSTANCE_STRIDE = FLOATS_PER_INSTANCE * sizeof(GLfloat);
+    auto mesh = instances[0].mesh;
+    
+    _instanceData.resize(count * FLOATS_PER_INSTANCE);
+    GLfloat* out = _instanceData.data();
+    for(GLsizei i = 0; i < count; i++)
+    {
+        memcpy(out, instances[i].mv.m, 16 * sizeof(GLfloat));
+        out[16] = instances[i].color.x;
+        out[17] = instances[i].color.y;
+        out[18] = instances[i].color.z;
+        out[19] = instances[i].color.w;
+        out[20] = instances[i].width;
+        out += FLOATS_PER_INSTANCE;
+    }
+    
+    auto program = getOrCreateProgram();
+    program->use();
+    program->setUniformsForBuiltins(Mat4::IDENTITY);
+    
+    if(!_instanceVBO)
+        glGenBuffers(1, &_instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, count * INSTANCE_STRIDE, _instanceData.data(), GL_STREAM_DRAW);
+    for(GLuint i = 0; i < 4; i++)
+    {
+        glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_INSTANCE_MV + i);
+        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_INSTANCE_MV + i, 4, GL_FLOAT, GL_FALSE, INSTANCE_STRIDE, (GLvoid*)(i * 4 * sizeof(GLfloat)));
+        glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_INSTANCE_MV + i, 1);
+    }
+    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, INSTANCE_STRIDE, (GLvoid*)(16 * sizeof(GLfloat)));
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR, 1);
+    glEnableVertexAttribArray(VERTEX_ATTRIB_INSTANCE_WIDTH);
+    glVertexAttribPointer(VERTEX_ATTRIB_INSTANCE_WIDTH, 1, GL_FLOAT, GL_FALSE, INSTANCE_STRIDE, (GLvoid*)(20 * sizeof(GLfloat)));
+    glVertexAttribDivisorARB(VERTEX_ATTRIB_INSTANCE_WIDTH, 1);
+    
+    glDrawElementsInstancedARB((GLenum)mesh->getPrimitiveType(), mesh->getIndexCount(), (GLenum)mesh->getIndexFormat(), (GLvoid*)0, count);
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, mesh->getIndexCount() * count);
+    
+    for(GLuint i = 0; i < 4; i++)
+    {
+        glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_INSTANCE_MV + i, 0);
+        glDisableVertexAttribArray(GLProgram::VERTEX_ATTRIB_INSTANCE_MV + i);
+    }
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR, 0);
+    glDisableVertexAttribArray(GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR);
+    glVertexAttribDivisorARB(VERTEX_ATTRIB_INSTANCE_WIDTH, 0);
+    glDisableVertexAttribArray(VERTEX_ATTRIB_INSTANCE_WIDTH);
+#endif
+}
+
 void EffectSprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
+    //outlines hug the mesh, so one test covers the effects too
+    if(!checkVisibility(renderer, transform))
+        return;
+    
     for(auto &effect : _effects)
     {
         if(std::get<0>(effect) >=0)
             break;
+        if(std::get<1>(effect)->batchWithSprite(this, transform))
+            continue;
         CustomCommand &cc = std::get<2>(effect);
         cc.func = CC_CALLBACK_0(Effect3D::drawWithSprite,std::get<1>(effect),this,transform);
         renderer->addCommand(&cc);
@@ -234,7 +470,7 @@ void EffectSprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t fl
     
     if(!_defaultEffect)
     {
-        Sprite3D::draw(renderer, transform, flags);
+        Sprite3D::drawMeshes(renderer, transform, flags);
     }
     else
     {
@@ -247,6 +483,8 @@ void EffectSprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t fl
     {
         if(std::get<0>(effect) <=0)
             continue;
+        if(std::get<1>(effect)->batchWithSprite(this, transform))
+            continue;
         CustomCommand &cc = std::get<2>(effect);
         cc.func = CC_CALLBACK_0(Effect3D::drawWithSprite,std::get<1>(effect),this,transform);
         renderer->addCommand(&cc);
@@ -37,6 +37,8 @@ class Effect3D : public Ref
 {
 public:
     virtual void drawWithSprite(EffectSprite3D* sprite, const Mat4 &transform) = 0;
+    //hands the draw to a batch instead of a CustomCommand per sprite, returns false if nothing took it
+    virtual bool batchWithSprite(EffectSprite3D* sprite, const Mat4 &transform) { return false; }
 protected:
     Effect3D() : _glProgramState(nullptr) {}
     virtual ~Effect3D()
@@ -58,6 +60,12 @@ public:
     
     void drawWithSprite(EffectSprite3D* sprite, const Mat4 &transform);
     
+    bool batchWithSprite(EffectSprite3D* sprite, const Mat4 &transform) override;
+    
+    const Vec3& getOutlineColor() const { return _outlineColor; }
+    
+    float getOutlineWidth() const { return _outlineWidth; }
+    
 protected:
     
     Effect3DOutline();
@@ -75,6 +83,47 @@ public:
     
 };
 
+//draws the outlines of the sprites visited before it, grouped by mesh. a group sets the outline state once
+//and draws all of its sprites with one instanced call, or one glDrawElements each without instancing.
+//outlines no longer put a CustomCommand between every two enemy MeshCommands, so those batch too.
+//it has to be visited after the outlined sprites
+class Effect3DOutlineBatch : public Node
+{
+public:
+    CREATE_FUNC(Effect3DOutlineBatch);
+    static Effect3DOutlineBatch* getRunning(){return s_running;};
+    void add(Effect3DOutline* effect, EffectSprite3D* sprite, const Mat4 &transform);
+    virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    
+    static const std::string _vertShaderFile;
+    static const std::string _fragShaderFile;
+    static const std::string _keyInGLProgramCache;
+    static GLProgram* getOrCreateProgram();
+    
+protected:
+    Effect3DOutlineBatch();
+    virtual ~Effect3DOutlineBatch();
+    
+    struct Instance
+    {
+        Mesh* mesh;
+        Mat4 mv;
+        Vec4 color; //outline color times the sprite's displayed color
+        float width;
+    };
+    void drawGroup(size_t first, size_t last);
+    void drawInstanced(const Instance* instances, GLsizei count);
+    
+    static Effect3DOutlineBatch* s_running;
+    std::vector<Instance> _pending; //filled during the visit
+    std::vector<Instance> _drawing; //read when the renderer runs the commands
+    std::vector<CustomCommand> _commands;
+    std::vector<GLfloat> _instanceData;
+    GLuint _instanceVBO;
+};
+
 class EffectSprite3D : public Sprite3D
 {
 public:
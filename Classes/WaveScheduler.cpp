@@ -0,0 +1,337 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "WaveScheduler.h"
+#include "GameControllers.h"
+#include "Enemies.h"
+#include "Player.h"
+#include "consts.h"
+#include "SimpleAudioEngine.h"
+#include <random>
+
+ValueVector WaveScheduler::_waves;
+float WaveScheduler::_startTime = 0;
+int WaveScheduler::_spawnBudget = 4;
+float WaveScheduler::_prewarmAhead = 3;
+unsigned int WaveScheduler::_defaultSeed = 0;
+unsigned int WaveScheduler::_seedOverride = 0;
+unsigned int WaveScheduler::_seed = 0;
+float WaveScheduler::_time = 0;
+std::vector<WaveEvent> WaveScheduler::_events;
+std::vector<WaveSpawn> WaveScheduler::_spawns;
+size_t WaveScheduler::_nextEvent = 0;
+std::vector<int> WaveScheduler::_pending;
+std::vector<float> WaveScheduler::_pendingTime;
+size_t WaveScheduler::_pendingHead = 0;
+
+//the timeline has its own generator so the waves do not depend on how often the rest of the game calls rand
+static std::mt19937 s_rng;
+static float random0_1()
+{
+    return (s_rng()>>8)/16777216.0f;
+}
+static float randomMinus1_1()
+{
+    return random0_1()*2-1;
+}
+
+bool WaveScheduler::load(const std::string& file)
+{
+    auto root = FileUtils::getInstance()->getValueMapFromFile(file);
+    if(root.find("waves") == root.end())
+    {
+        CCLOG("WaveScheduler: no waves in %s", file.c_str());
+        return false;
+    }
+    _waves = root["waves"].asValueVector();
+    _startTime = root.find("startTime") != root.end() ? root["startTime"].asFloat() : 0;
+    _spawnBudget = root.find("spawnBudget") != root.end() ? root["spawnBudget"].asInt() : 4;
+    _prewarmAhead = root.find("prewarmAhead") != root.end() ? root["prewarmAhead"].asFloat() : 3;
+    _defaultSeed = root.find("seed") != root.end() ? root["seed"].asInt() : 0;
+    return true;
+}
+
+void WaveScheduler::start(unsigned int seed)
+{
+    if(_waves.empty())
+        load("waves.plist");
+    _seed = seed ? seed : (_seedOverride ? _seedOverride : _defaultSeed);
+    if(!_seed)
+    {
+        _seed = std::random_device()();
+        CCLOG("WaveScheduler: seed %u", _seed);
+    }
+    //the rest of the game still uses CCRANDOM, seed it as well so the whole run can be replayed
+    std::srand(_seed);
+    s_rng.seed(_seed);
+    _time = _startTime;
+    _nextEvent = 0;
+    _pending.clear();
+    _pendingTime.clear();
+    _pendingHead = 0;
+    compile();
+}
+
+void WaveScheduler::compile()
+{
+    _events.clear();
+    _spawns.clear();
+    for(auto& w : _waves)
+    {
+        auto& wave = w.asValueMap();
+        auto formation = wave["formation"].asString();
+        float start = wave["start"].asFloat();
+        float end = wave.find("end") != wave.end() ? wave["end"].asFloat() : start;
+        float interval = wave.find("interval") != wave.end() ? wave["interval"].asFloat() : 0;
+        int maxEnemies = wave.find("maxEnemies") != wave.end() ? wave["maxEnemies"].asInt() : -1;
+        for(float t = start; ; t += interval)
+        {
+            WaveEvent e;
+            e.time = t;
+            e.maxEnemies = maxEnemies;
+            e.firstSpawn = _spawns.size();
+            compileFormation(formation);
+            e.spawnCount = _spawns.size()-e.firstSpawn;
+            _events.push_back(e);
+            if(interval <= 0 || t+interval >= end)
+                break;
+        }
+    }
+    //stable so formations due on the same tick keep the order they have in the file
+    std::stable_sort(_events.begin(), _events.end(), [](const WaveEvent& a, const WaveEvent& b){ return a.time < b.time; });
+}
+
+void WaveScheduler::compileFormation(const std::string& formation)
+{
+    WaveSpawn s;
+    s.rotation = 0;
+    s.turnRate = 0;
+    s.scale = 1;
+    s.duration = 0;
+    if(formation == "fodderV")
+    {
+        Vec2 random = Vec2(100*randomMinus1_1(), BOUND_RECT.size.height/2+200);
+        s.kind = kSpawnFodder;
+        for(int i=0; i < 4; i++)
+        {
+            s.position = random + Vec2(60,60)*(i+1);
+            _spawns.push_back(s);
+            s.position = random + Vec2(-60,60)*(i+1);
+            _spawns.push_back(s);
+        }
+        s.kind = kSpawnLeader;
+        s.position = random;
+        _spawns.push_back(s);
+    }
+    else if(formation == "fodderTurn")
+    {
+        Vec2 random = Vec2(-400, BOUND_RECT.size.height/4*randomMinus1_1()+350);
+        s.kind = kSpawnFodderTurn;
+        for(int i=0; i < 3; i++)
+        {
+            float randomAngle = randomMinus1_1()*70;
+            s.turnRate = randomAngle*0.5;
+            s.rotation = -randomAngle-90;
+            s.position = random + Vec2(60,60)*(i+1);
+            _spawns.push_back(s);
+            s.position = random + Vec2(-60,60)*(i+1);
+            _spawns.push_back(s);
+        }
+        s.kind = kSpawnLeaderTurn;
+        s.position = random;
+        s.turnRate = 45;
+        s.rotation = -45;
+        s.duration = random0_1()*1+1; //shoot interval
+        _spawns.push_back(s);
+    }
+    else if(formation == "bigDudes")
+    {
+        s.kind = kSpawnBigDude;
+        for(int q = 0; q< 2; q++)
+        {
+            //random if its from the top, left, or bottom
+            int direction = random0_1()*4;
+            switch(direction)
+            {
+                case 0://top
+                    s.position = Vec2(ENEMY_BOUND_RECT.size.width*random0_1(), BOUND_RECT.size.height/2+200);
+                    break;
+                case 1://bottom
+                    s.position = Vec2(ENEMY_BOUND_RECT.size.width*random0_1(), -200);
+                    break;
+                case 2://left
+                    s.position = Vec2(ENEMY_BOUND_RECT.origin.x, ENEMY_BOUND_RECT.size.height*random0_1());
+                    break;
+                default://right
+                    s.position = Vec2(ENEMY_BOUND_RECT.size.width, ENEMY_BOUND_RECT.size.height*random0_1());
+                    break;
+            }
+            s.target = Vec2(BOUND_RECT.size.width/3*randomMinus1_1(),BOUND_RECT.size.height/3*random0_1());
+            s.scale = 2*randomMinus1_1()+2;
+            s.duration = random0_1()*1+1;
+            _spawns.push_back(s);
+        }
+    }
+    else if(formation == "boss")
+    {
+        s.kind = kSpawnBoss;
+        s.position = Vec2(0,800);
+        _spawns.push_back(s);
+    }
+    else
+    {
+        CCLOG("WaveScheduler: unknown formation %s", formation.c_str());
+    }
+}
+
+int WaveScheduler::enemyType(int kind)
+{
+    switch(kind)
+    {
+        case kSpawnLeader:
+        case kSpawnLeaderTurn:
+            return kEnemyFodderL;
+        case kSpawnBigDude:
+            return kEnemyBigDude;
+        case kSpawnBoss:
+            return kEnemyBoss;
+        default:
+            return kEnemyFodder;
+    }
+}
+
+void WaveScheduler::update(float dt, Player* player)
+{
+    CC_PROFILER_START("WaveScheduler - update");
+    _time += dt;
+    //every formation due this frame is tested against the same count, like the old fixed tick did
+    int enemyCount = EnemyController::enemies.size();
+    for(size_t i = _pendingHead; i < _pending.size(); i++)
+    {
+        if(_spawns[_pending[i]].kind != kSpawnBigDude)
+            enemyCount++;
+    }
+    while(_nextEvent < _events.size() && _events[_nextEvent].time <= _time)
+    {
+        auto& e = _events[_nextEvent++];
+        if(e.maxEnemies >= 0 && enemyCount >= e.maxEnemies)
+            continue;
+        for(int i = 0; i < e.spawnCount; i++)
+        {
+            _pending.push_back(e.firstSpawn+i);
+            _pendingTime.push_back(e.time);
+        }
+    }
+
+    //a formation is spread over a few frames instead of landing all at once
+    int budget = _spawnBudget;
+    while(_pendingHead < _pending.size() && budget-- > 0)
+    {
+        spawn(_spawns[_pending[_pendingHead]], _time-_pendingTime[_pendingHead], player);
+        _pendingHead++;
+    }
+    if(_pendingHead == _pending.size())
+    {
+        _pending.clear();
+        _pendingTime.clear();
+        _pendingHead = 0;
+    }
+    prewarm();
+    CC_PROFILER_STOP("WaveScheduler - update");
+}
+
+void WaveScheduler::spawn(const WaveSpawn& s, float late, Player* player)
+{
+    int type = enemyType(s.kind);
+    if(s.kind == kSpawnBigDude)
+    {
+        auto enemy = EnemyController::showCaseEnemy(type);
+        enemy->setPosition(s.position);
+        enemy->setScale(s.scale);
+        enemy->setRotation3D(Vec3(300,0,-CC_RADIANS_TO_DEGREES((s.position-s.target).getAngle())+90));
+        enemy->runAction(
+                         Sequence::create(
+                                          Spawn::create(
+                                                        EaseSineOut::create(MoveTo::create(s.duration, s.target)),
+                                                        EaseSineOut::create(ScaleTo::create(s.duration,1)),//TODO: replace with move 3d when possible
+                                                        EaseBackOut::create(RotateBy::create(s.duration+0.2,Vec3(-300,0,0))),
+                                                        nullptr
+                                                        ),
+                                          CallFunc::create(CC_CALLBACK_0(BigDude::showFinished, static_cast<BigDude*>(enemy))),
+                                          nullptr
+                         ));
+        return;
+    }
+    auto enemy = EnemyController::spawnEnemy(type);
+    enemy->setPosition(s.position);
+    switch(s.kind)
+    {
+        case kSpawnFodder:
+        case kSpawnLeader:
+            enemy->setRotation3D(Vec3::ZERO);
+            static_cast<Fodder*>(enemy)->setMoveMode(moveMode::kDefault);
+            break;
+        case kSpawnFodderTurn:
+        case kSpawnLeaderTurn:
+            static_cast<Fodder*>(enemy)->setTurnRate(s.turnRate);
+            enemy->setRotation(s.rotation);
+            break;
+        case kSpawnBoss:
+            if(GameController::isSimulationOnly())
+                return;
+            CocosDenshion::SimpleAudioEngine::getInstance()->stopBackgroundMusic();
+            // Music By Matthew Pable (http://www.matthewpablo.com/)
+            // Licensed under CC-BY 3.0 (http://creativecommons.org/licenses/by/3.0/)
+            CocosDenshion::SimpleAudioEngine::getInstance()->playBackgroundMusic("Orbital Colossus_0.mp3", true);
+            return;
+    }
+    if(s.kind == kSpawnLeader || s.kind == kSpawnLeaderTurn)
+        static_cast<FodderLeader*>(enemy)->setTarget(player);
+    if(s.kind == kSpawnLeaderTurn)
+        enemy->schedule(schedule_selector(FodderLeader::shoot),s.duration,90,0);
+    //spawns held back by the budget catch up with the rest of their formation
+    if(late > 0)
+        enemy->move(EnemyController::EnemyMoveDist*late, late);
+}
+
+void WaveScheduler::prewarm()
+{
+    //count what the formations of the next few seconds will take from each pool,
+    //and create at most one missing object per frame so the spawn itself never allocates
+    int demand[4] = {0,0,0,0};
+    for(size_t i = _nextEvent; i < _events.size() && _events[i].time <= _time+_prewarmAhead; i++)
+    {
+        auto& e = _events[i];
+        for(int j = 0; j < e.spawnCount; j++)
+            demand[enemyType(_spawns[e.firstSpawn+j].kind)-kEnemyFodder]++;
+    }
+    if(demand[0] > (int)EnemyController::_fodderPool.getFreeCount())
+        EnemyController::_fodderPool.prewarm(1);
+    else if(demand[1] > (int)EnemyController::_fodderLPool.getFreeCount())
+        EnemyController::_fodderLPool.prewarm(1);
+    else if(demand[2] > (int)EnemyController::_bigDudePool.getFreeCount())
+        EnemyController::_bigDudePool.prewarm(1);
+    else if(demand[3] > (int)EnemyController::_bossPool.getFreeCount())
+        EnemyController::_bossPool.prewarm(1);
+}
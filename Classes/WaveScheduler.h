@@ -0,0 +1,100 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __Moon3d__WaveScheduler__
+#define __Moon3d__WaveScheduler__
+
+#include "cocos2d.h"
+USING_NS_CC;
+class Player;
+
+//one enemy of a formation, all random placement is rolled when the timeline is compiled
+struct WaveSpawn
+{
+    int kind;
+    Vec2 position;
+    Vec2 target;
+    float rotation;
+    float turnRate;
+    float scale;
+    float duration;
+};
+
+//a formation that is due at time, it only spawns while fewer than maxEnemies are alive
+struct WaveEvent
+{
+    float time;
+    int maxEnemies;
+    int firstSpawn;
+    int spawnCount;
+};
+
+//replaces the hard coded GameLayer::gameMaster, the wave timeline is read from a plist once,
+//compiled into a flat time sorted event array per run and spawned a few enemies per frame
+class WaveScheduler
+{
+public:
+    enum SpawnKind
+    {
+        kSpawnFodder,
+        kSpawnFodderTurn,
+        kSpawnLeader,
+        kSpawnLeaderTurn,
+        kSpawnBigDude,
+        kSpawnBoss
+    };
+    static bool load(const std::string& file);
+    //seed 0 uses the seed from the plist, if that is 0 too a random one is picked and logged
+    static void start(unsigned int seed = 0);
+    //when set, start() uses it instead of the plist seed, so the benchmark can replay a run through GameLayer
+    static void setSeedOverride(unsigned int seed){_seedOverride = seed;};
+    static void update(float dt, Player* player);
+    static unsigned int getSeed(){return _seed;};
+    static float getTime(){return _time;};
+
+protected:
+    static void compile();
+    static void compileFormation(const std::string& formation);
+    static void spawn(const WaveSpawn& s, float late, Player* player);
+    static void prewarm();
+    static int enemyType(int kind);
+
+    static ValueVector _waves;
+    static float _startTime;
+    static int _spawnBudget;
+    static float _prewarmAhead;
+    static unsigned int _defaultSeed;
+    static unsigned int _seedOverride;
+
+    static unsigned int _seed;
+    static float _time;
+    static std::vector<WaveEvent> _events;
+    static std::vector<WaveSpawn> _spawns;
+    static size_t _nextEvent;
+    static std::vector<int> _pending; //spawn indices that are due but over the per frame budget
+    static std::vector<float> _pendingTime;
+    static size_t _pendingHead;
+};
+
+#endif /* defined(__Moon3d__WaveScheduler__) */
@@ -0,0 +1,10 @@
+#ifdef GL_ES
+varying lowp vec4 v_color;
+#else
+varying vec4 v_color;
+#endif
+
+void main(void)
+{
+    gl_FragColor = v_color;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+attribute vec4 a_position;
+attribute vec3 a_normal;
+attribute mat4 a_instanceMV;
+attribute vec4 a_instanceColor;
+attribute float a_instanceWidth;
+varying vec4 v_color;
+
+void main(void)
+{
+    mat4 mvp = CC_PMatrix * a_instanceMV;
+    vec4 pos = mvp * a_position;
+    vec4 normalproj = mvp * vec4(a_normal, 0);
+    normalproj = normalize(normalproj);
+    pos.xy += normalproj.xy * (a_instanceWidth * (pos.z * 0.25));
+    v_color = a_instanceColor;
+    gl_Position = pos;
+}
\ No newline at end of file
@@ -31,7 +31,106 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "deprecated/CCString.h"
 
+#if CC_USE_ACTION_POOL
+#include <atomic>
+#endif
+
 NS_CC_BEGIN
+
+#if CC_USE_ACTION_POOL
+//
+// Action pool
+//
+namespace {
+    // blocks are grouped in 16 byte size classes, actions bigger than the last class use the heap directly
+    const size_t POOL_GRANULARITY = 16;
+    const size_t POOL_CLASSES = 16;
+    // per size class, blocks freed beyond this go back to the heap
+    const unsigned int POOL_MAX_FREE = 4096;
+
+    struct PoolBlock
+    {
+        PoolBlock* next;
+    };
+
+    // plain zero initialized statics, so actions created by static initializers find a usable pool
+    PoolBlock* s_poolFree[POOL_CLASSES];
+    unsigned int s_poolFreeCount[POOL_CLASSES];
+    std::atomic_flag s_poolLock = ATOMIC_FLAG_INIT;
+
+    // actions are nearly always created on the main thread, a spin lock is cheaper than a mutex there
+    class PoolLock
+    {
+    public:
+        PoolLock() { while (s_poolLock.test_and_set(std::memory_order_acquire)) {} }
+        ~PoolLock() { s_poolLock.clear(std::memory_order_release); }
+    };
+
+    void* poolAllocate(size_t size, bool nothrow)
+    {
+        size_t index = (size - 1) / POOL_GRANULARITY;
+        if (index < POOL_CLASSES)
+        {
+            {
+                PoolLock lock;
+                PoolBlock* block = s_poolFree[index];
+                if (block)
+                {
+                    s_poolFree[index] = block->next;
+                    s_poolFreeCount[index]--;
+                    return block;
+                }
+            }
+            // allocate the whole class so the block can serve any action of that class later
+            size = (index + 1) * POOL_GRANULARITY;
+        }
+        return nothrow ? ::operator new(size, std::nothrow) : ::operator new(size);
+    }
+
+    void poolFree(void* ptr, size_t size)
+    {
+        if (ptr == nullptr)
+            return;
+
+        size_t index = (size - 1) / POOL_GRANULARITY;
+        if (index < POOL_CLASSES)
+        {
+            PoolLock lock;
+            if (s_poolFreeCount[index] < POOL_MAX_FREE)
+            {
+                auto block = static_cast<PoolBlock*>(ptr);
+                block->next = s_poolFree[index];
+                s_poolFree[index] = block;
+                s_poolFreeCount[index]++;
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+}
+
+void* Action::operator new(size_t size)
+{
+    return poolAllocate(size, false);
+}
+
+void* Action::operator new(size_t size, const std::nothrow_t&)
+{
+    return poolAllocate(size, true);
+}
+
+void Action::operator delete(void* ptr, size_t size)
+{
+    poolFree(ptr, size);
+}
+
+void Action::operator delete(void* ptr, const std::nothrow_t&)
+{
+    // only reached when a constructor throws, every pooled block came from the global operator new
+    ::operator delete(ptr);
+}
+#endif // CC_USE_ACTION_POOL
+
 //
 // Action Base Class
 //
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "base/CCRef.h"
 #include "math/CCGeometry.h"
+#include <new>
 
 NS_CC_BEGIN
 
@@ -107,6 +108,17 @@ public:
     inline int getTag() const { return _tag; }
     inline void setTag(int tag) { _tag = tag; }
 
+#if CC_USE_ACTION_POOL
+    /** Actions are small and short lived, so they are recycled through free lists of 16 byte size classes instead of going to the heap every time.
+     * @js NA
+     * @lua NA
+     */
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, const std::nothrow_t&);
+    static void operator delete(void* ptr, size_t size);
+    static void operator delete(void* ptr, const std::nothrow_t&);
+#endif
+
 CC_CONSTRUCTOR_ACCESS:
     Action();
     virtual ~Action();
@@ -98,6 +98,9 @@ CC_CONSTRUCTOR_ACCESS:
 protected:
     float _elapsed;
     bool   _firstTick;
+
+    // steps the common interval actions without the virtual step/update chain
+    friend class ActionManager;
 };
 
 /** @brief Runs actions sequentially, one after another
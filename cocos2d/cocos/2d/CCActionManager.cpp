@@ -26,33 +26,75 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 ****************************************************************************/
 
+
 #include "2d/CCActionManager.h"
 #include "2d/CCNode.h"
 #include "2d/CCAction.h"
+#include "2d/CCActionInterval.h"
+#include "2d/CCActionEase.h"
+#include "2d/CCTweenFunction.h"
 #include "base/CCScheduler.h"
 #include "base/ccMacros.h"
-#include "base/ccCArray.h"
-#include "base/uthash.h"
+#include <algorithm>
+#include <typeinfo>
 
 NS_CC_BEGIN
-//
-// singleton stuff
-//
-typedef struct _hashElement
+
+// how update steps an action, everything but STEP_VIRTUAL is an interval action stepped by stepInterval
+enum : unsigned char
+{
+    STEP_VIRTUAL,
+    STEP_MOVE,
+    STEP_SCALE,
+    STEP_ROTATE,
+    STEP_FADE,
+};
+
+// the ease wrapped around an interval action stepped by stepInterval
+enum : unsigned char
+{
+    EASE_NONE,
+    EASE_SINE_IN,
+    EASE_SINE_OUT,
+    EASE_SINE_IN_OUT,
+    EASE_QUADRATIC_IN_OUT,
+    EASE_BACK_OUT,
+};
+
+// exact types only, a subclass may override update
+static unsigned char intervalKind(const Action *action)
+{
+    const std::type_info& type = typeid(*action);
+    if (type == typeid(MoveTo) || type == typeid(MoveBy))
+        return STEP_MOVE;
+    if (type == typeid(ScaleTo) || type == typeid(ScaleBy))
+        return STEP_SCALE;
+    if (type == typeid(RotateBy))
+        return STEP_ROTATE;
+    if (type == typeid(FadeTo) || type == typeid(FadeIn) || type == typeid(FadeOut))
+        return STEP_FADE;
+    return STEP_VIRTUAL;
+}
+
+static unsigned char easeKind(const Action *action)
 {
-    struct _ccArray     *actions;
-    Node                *target;
-    int                 actionIndex;
-    Action              *currentAction;
-    bool                currentActionSalvaged;
-    bool                paused;
-    UT_hash_handle      hh;
-} tHashElement;
+    const std::type_info& type = typeid(*action);
+    if (type == typeid(EaseSineIn))
+        return EASE_SINE_IN;
+    if (type == typeid(EaseSineOut))
+        return EASE_SINE_OUT;
+    if (type == typeid(EaseSineInOut))
+        return EASE_SINE_IN_OUT;
+    if (type == typeid(EaseQuadraticActionInOut))
+        return EASE_QUADRATIC_IN_OUT;
+    if (type == typeid(EaseBackOut))
+        return EASE_BACK_OUT;
+    return EASE_NONE;
+}
 
 ActionManager::ActionManager()
-: _targets(nullptr),
-  _currentTarget(nullptr),
-  _currentTargetSalvaged(false)
+: _deadTargets(0)
+, _updating(false)
 {
 
 }
@@ -66,78 +108,191 @@ ActionManager::~ActionManager()
 
 // private
 
-void ActionManager::deleteHashElement(tHashElement *element)
+ActionManager::ActionEntry ActionManager::makeEntry(Action *action)
 {
-    ccArrayFree(element->actions);
-    HASH_DEL(_targets, element);
-    element->target->release();
-    free(element);
+    ActionEntry entry = { action, nullptr, STEP_VIRTUAL, EASE_NONE };
+
+    auto inner = action;
+    entry.ease = easeKind(action);
+    if (entry.ease != EASE_NONE)
+    {
+        inner = static_cast<ActionEase*>(action)->getInnerAction();
+    }
+    entry.kind = intervalKind(inner);
+    if (entry.kind != STEP_VIRTUAL)
+    {
+        entry.inner = static_cast<ActionInterval*>(inner);
+    }
+    else
+    {
+        entry.ease = EASE_NONE;
+    }
+    return entry;
 }
 
-void ActionManager::actionAllocWithHashElement(tHashElement *element)
+void ActionManager::stepInterval(const ActionEntry &entry, float dt)
 {
-    // 4 actions per Node by default
-    if (element->actions == nullptr)
+    // ActionInterval::step followed by the ease's and the action's update, without going through the vtable
+    auto action = static_cast<ActionInterval*>(entry.action);
+    if (action->_firstTick)
     {
-        element->actions = ccArrayNew(4);
-    }else 
-    if (element->actions->num == element->actions->max)
+        action->_firstTick = false;
+        action->_elapsed = 0;
+    }
+    else
     {
-        ccArrayDoubleCapacity(element->actions);
+        action->_elapsed += dt;
     }
 
+    float time = MAX (0, MIN(1, action->_elapsed / MAX(action->_duration, FLT_EPSILON)));
+
+    switch (entry.ease)
+    {
+        case EASE_SINE_IN:
+            time = tweenfunc::sineEaseIn(time);
+            break;
+        case EASE_SINE_OUT:
+            time = tweenfunc::sineEaseOut(time);
+            break;
+        case EASE_SINE_IN_OUT:
+            time = tweenfunc::sineEaseInOut(time);
+            break;
+        case EASE_QUADRATIC_IN_OUT:
+            time = tweenfunc::quadraticInOut(time);
+            break;
+        case EASE_BACK_OUT:
+            time = tweenfunc::backEaseOut(time);
+            break;
+        default:
+            break;
+    }
+
+    switch (entry.kind)
+    {
+        case STEP_MOVE:
+            static_cast<MoveBy*>(entry.inner)->MoveBy::update(time);
+            break;
+        case STEP_SCALE:
+            static_cast<ScaleTo*>(entry.inner)->ScaleTo::update(time);
+            break;
+        case STEP_ROTATE:
+            static_cast<RotateBy*>(entry.inner)->RotateBy::update(time);
+            break;
+        case STEP_FADE:
+            static_cast<FadeTo*>(entry.inner)->FadeTo::update(time);
+            break;
+        default:
+            break;
+    }
 }
 
-void ActionManager::removeActionAtIndex(ssize_t index, tHashElement *element)
+ssize_t ActionManager::findTarget(const Node *target) const
 {
-    Action *action = (Action*)element->actions->arr[index];
+    auto it = _targetIndices.find(target);
+    return it != _targetIndices.end() ? (ssize_t)it->second : -1;
+}
 
-    if (action == element->currentAction && (! element->currentActionSalvaged))
+void ActionManager::removeActionAt(size_t index, size_t slot)
+{
+    auto& element = _targets[index];
+    Action *action = element.actions[slot].action;
+    element.actions[slot].action = nullptr;
+    element.count--;
+    if (! element.holes)
     {
-        element->currentAction->retain();
-        element->currentActionSalvaged = true;
+        element.holes = true;
+        // outside of update the caller purges the element right away
+        if (_updating)
+        {
+            _dirtyTargets.push_back(index);
+        }
     }
 
-    ccArrayRemoveObjectAtIndex(element->actions, index, true);
+    if (_updating)
+    {
+        // it may be the action being stepped, keep it alive until update is done with it
+        _removed.push_back(action);
+    }
+    else
+    {
+        action->release();
+    }
+}
 
-    // update actionIndex in case we are in tick. looping over the actions
-    if (element->actionIndex >= index)
+void ActionManager::purgeTarget(size_t index)
+{
+    auto& element = _targets[index];
+    if (element.holes)
     {
-        element->actionIndex--;
+        element.actions.erase(std::remove_if(element.actions.begin(), element.actions.end(),
+                                             [](const ActionEntry& entry){ return entry.action == nullptr; }),
+                              element.actions.end());
+        element.holes = false;
     }
 
-    if (element->actions->num == 0)
+    if (element.count == 0 && element.target != nullptr)
     {
-        if (_currentTarget == element)
+        // the element stays in place so the indices of the others stay valid, compactTargets drops it later
+        Node *target = element.target;
+        element.target = nullptr;
+        _targetIndices.erase(target);
+        _deadTargets++;
+
+        if (_updating)
         {
-            _currentTargetSalvaged = true;
+            _removed.push_back(target);
         }
         else
         {
-            deleteHashElement(element);
+            compactTargets();
+            target->release();
         }
     }
 }
 
+void ActionManager::compactTargets()
+{
+    if (_deadTargets < 32 || _deadTargets * 2 < _targets.size())
+    {
+        return;
+    }
+
+    size_t live = 0;
+    for (size_t index = 0; index < _targets.size(); ++index)
+    {
+        if (_targets[index].target == nullptr)
+        {
+            continue;
+        }
+
+        if (live != index)
+        {
+            _targets[live] = std::move(_targets[index]);
+            _targetIndices[_targets[live].target] = live;
+        }
+        live++;
+    }
+    _targets.resize(live);
+    _deadTargets = 0;
+}
+
 // pause / resume
 
 void ActionManager::pauseTarget(Node *target)
 {
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        element->paused = true;
+        _targets[index].paused = true;
     }
 }
 
 void ActionManager::resumeTarget(Node *target)
 {
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        element->paused = false;
+        _targets[index].paused = false;
     }
 }
 
@@ -145,12 +300,12 @@ Vector<Node*> ActionManager::pauseAllRunningActions()
 {
     Vector<Node*> idsWithActions;
     
-    for (tHashElement *element=_targets; element != nullptr; element = (tHashElement *)element->hh.next) 
+    for (auto& element : _targets)
     {
-        if (! element->paused) 
+        if (element.target != nullptr && ! element.paused)
         {
-            element->paused = true;
-            idsWithActions.pushBack(element->target);
+            element.paused = true;
+            idsWithActions.pushBack(element.target);
         }
     }    
     
@@ -171,35 +326,49 @@ void ActionManager::addAction(Action *action, Node *target, bool paused)
     CCASSERT(action != nullptr, "");
     CCASSERT(target != nullptr, "");
 
-    tHashElement *element = nullptr;
-    // we should convert it to Ref*, because we save it as Ref*
-    Ref *tmp = target;
-    HASH_FIND_PTR(_targets, &tmp, element);
-    if (! element)
+    ssize_t index = findTarget(target);
+    if (index < 0)
     {
-        element = (tHashElement*)calloc(sizeof(*element), 1);
-        element->paused = paused;
+        index = _targets.size();
+
+        TargetElement element;
+        element.target = target;
+        element.count = 0;
+        element.holes = false;
+        element.paused = paused;
+        // 4 actions per Node by default
+        element.actions.reserve(4);
+        _targets.push_back(std::move(element));
+        _targetIndices[target] = index;
         target->retain();
-        element->target = target;
-        HASH_ADD_PTR(_targets, target, element);
     }
 
-     actionAllocWithHashElement(element);
- 
-     CCASSERT(! ccArrayContainsObject(element->actions, action), "");
-     ccArrayAppendObject(element->actions, action);
- 
-     action->startWithTarget(target);
+    auto& element = _targets[index];
+    CCASSERT(std::none_of(element.actions.begin(), element.actions.end(),
+                          [action](const ActionEntry& entry){ return entry.action == action; }), "");
+    action->retain();
+    element.actions.push_back(makeEntry(action));
+    element.count++;
+
+    action->startWithTarget(target);
 }
 
 // remove
 
 void ActionManager::removeAllActions()
 {
-    for (tHashElement *element = _targets; element != nullptr; )
+    std::vector<Node*> targets;
+    targets.reserve(_targets.size());
+    for (auto& element : _targets)
+    {
+        if (element.target != nullptr)
+        {
+            targets.push_back(element.target);
+        }
+    }
+
+    for (auto target : targets)
     {
-        auto target = element->target;
-        element = (tHashElement*)element->hh.next;
         removeAllActionsFromTarget(target);
     }
 }
@@ -212,24 +381,20 @@ void ActionManager::removeAllActionsFromTarget(Node *target)
         return;
     }
 
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        if (ccArrayContainsObject(element->actions, element->currentAction) && (! element->currentActionSalvaged))
+        for (size_t slot = 0; slot < _targets[index].actions.size(); ++slot)
         {
-            element->currentAction->retain();
-            element->currentActionSalvaged = true;
+            if (_targets[index].actions[slot].action != nullptr)
+            {
+                removeActionAt(index, slot);
+            }
         }
 
-        ccArrayRemoveAllObjects(element->actions);
-        if (_currentTarget == element)
-        {
-            _currentTargetSalvaged = true;
-        }
-        else
+        if (! _updating)
         {
-            deleteHashElement(element);
+            purgeTarget(index);
         }
     }
     else
@@ -246,15 +411,21 @@ void ActionManager::removeAction(Action *action)
         return;
     }
 
-    tHashElement *element = nullptr;
-    Ref *target = action->getOriginalTarget();
-    HASH_FIND_PTR(_targets, &target, element);
-    if (element)
+    ssize_t index = findTarget(action->getOriginalTarget());
+    if (index >= 0)
     {
-        auto i = ccArrayGetIndexOfObject(element->actions, action);
-        if (i != CC_INVALID_INDEX)
+        auto& actions = _targets[index].actions;
+        for (size_t slot = 0; slot < actions.size(); ++slot)
         {
-            removeActionAtIndex(i, element);
+            if (actions[slot].action == action)
+            {
+                removeActionAt(index, slot);
+                if (! _updating)
+                {
+                    purgeTarget(index);
+                }
+                break;
+            }
         }
     }
     else
@@ -268,19 +439,21 @@ void ActionManager::removeActionByTag(int tag, Node *target)
     CCASSERT(tag != Action::INVALID_TAG, "");
     CCASSERT(target != nullptr, "");
 
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        auto limit = element->actions->num;
-        for (int i = 0; i < limit; ++i)
+        auto& actions = _targets[index].actions;
+        for (size_t slot = 0; slot < actions.size(); ++slot)
         {
-            Action *action = (Action*)element->actions->arr[i];
+            Action *action = actions[slot].action;
 
-            if (action->getTag() == (int)tag && action->getOriginalTarget() == target)
+            if (action != nullptr && action->getTag() == (int)tag && action->getOriginalTarget() == target)
             {
-                removeActionAtIndex(i, element);
+                removeActionAt(index, slot);
+                if (! _updating)
+                {
+                    purgeTarget(index);
+                }
                 break;
             }
         }
@@ -292,53 +465,40 @@ void ActionManager::removeAllActionsByTag(int tag, Node *target)
     CCASSERT(tag != Action::INVALID_TAG, "");
     CCASSERT(target != nullptr, "");
     
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-    
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        auto limit = element->actions->num;
-        for (int i = 0; i < limit;)
+        for (size_t slot = 0; slot < _targets[index].actions.size(); ++slot)
         {
-            Action *action = (Action*)element->actions->arr[i];
+            Action *action = _targets[index].actions[slot].action;
             
-            if (action->getTag() == (int)tag && action->getOriginalTarget() == target)
-            {
-                removeActionAtIndex(i, element);
-                --limit;
-            }
-            else
+            if (action != nullptr && action->getTag() == (int)tag && action->getOriginalTarget() == target)
             {
-                ++i;
+                removeActionAt(index, slot);
             }
         }
+
+        if (! _updating)
+        {
+            purgeTarget(index);
+        }
     }
 }
 
 // get
 
-// FIXME: Passing "const O *" instead of "const O&" because HASH_FIND_IT requries the address of a pointer
-// and, it is not possible to get the address of a reference
 Action* ActionManager::getActionByTag(int tag, const Node *target) const
 {
     CCASSERT(tag != Action::INVALID_TAG, "");
 
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        if (element->actions != nullptr)
+        for (const auto& entry : _targets[index].actions)
         {
-            auto limit = element->actions->num;
-            for (int i = 0; i < limit; ++i)
+            if (entry.action != nullptr && entry.action->getTag() == (int)tag)
             {
-                Action *action = (Action*)element->actions->arr[i];
-
-                if (action->getTag() == (int)tag)
-                {
-                    return action;
-                }
+                return entry.action;
             }
         }
         //CCLOG("cocos2d : getActionByTag(tag = %d): Action not found", tag);
@@ -351,15 +511,12 @@ Action* ActionManager::getActionByTag(int tag, const Node *target) const
     return nullptr;
 }
 
-// FIXME: Passing "const O *" instead of "const O&" because HASH_FIND_IT requries the address of a pointer
-// and, it is not possible to get the address of a reference
 ssize_t ActionManager::getNumberOfRunningActionsInTarget(const Node *target) const
 {
-    tHashElement *element = nullptr;
-    HASH_FIND_PTR(_targets, &target, element);
-    if (element)
+    ssize_t index = findTarget(target);
+    if (index >= 0)
     {
-        return element->actions ? element->actions->num : 0;
+        return _targets[index].count;
     }
 
     return 0;
@@ -368,61 +525,68 @@ ssize_t ActionManager::getNumberOfRunningActionsInTarget(const Node *target) con
 // main loop
 void ActionManager::update(float dt)
 {
-    for (tHashElement *elt = _targets; elt != nullptr; )
+    _updating = true;
+
+    // actions and targets added while stepping are appended, so they still run this frame.
+    // Elements are only indexed, the vectors may grow under us
+    for (size_t index = 0; index < _targets.size(); ++index)
     {
-        _currentTarget = elt;
-        _currentTargetSalvaged = false;
+        if (_targets[index].paused || _targets[index].count == 0)
+        {
+            continue;
+        }
 
-        if (! _currentTarget->paused)
+        for (size_t slot = 0; slot < _targets[index].actions.size(); ++slot)
         {
-            // The 'actions' MutableArray may change while inside this loop.
-            for (_currentTarget->actionIndex = 0; _currentTarget->actionIndex < _currentTarget->actions->num;
-                _currentTarget->actionIndex++)
+            ActionEntry entry = _targets[index].actions[slot];
+            if (entry.action == nullptr)
             {
-                _currentTarget->currentAction = (Action*)_currentTarget->actions->arr[_currentTarget->actionIndex];
-                if (_currentTarget->currentAction == nullptr)
-                {
-                    continue;
-                }
+                continue;
+            }
 
-                _currentTarget->currentActionSalvaged = false;
+            if (entry.kind != STEP_VIRTUAL)
+            {
+                stepInterval(entry, dt);
+            }
+            else
+            {
+                entry.action->step(dt);
+            }
 
-                _currentTarget->currentAction->step(dt);
+            // The action told the node to remove it, it is kept alive in _removed until the end of update
+            if (_targets[index].actions[slot].action != entry.action)
+            {
+                continue;
+            }
 
-                if (_currentTarget->currentActionSalvaged)
-                {
-                    // The currentAction told the node to remove it. To prevent the action from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    _currentTarget->currentAction->release();
-                } else
-                if (_currentTarget->currentAction->isDone())
-                {
-                    _currentTarget->currentAction->stop();
+            if (entry.action->isDone())
+            {
+                entry.action->stop();
 
-                    Action *action = _currentTarget->currentAction;
-                    // Make currentAction nil to prevent removeAction from salvaging it.
-                    _currentTarget->currentAction = nullptr;
-                    removeAction(action);
+                // stop may have removed it already
+                if (_targets[index].actions[slot].action == entry.action)
+                {
+                    removeActionAt(index, slot);
                 }
-
-                _currentTarget->currentAction = nullptr;
             }
         }
-
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashElement*)(elt->hh.next);
-
-        // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
-        if (_currentTargetSalvaged && _currentTarget->actions->num == 0)
-        {
-            deleteHashElement(_currentTarget);
-        }
     }
 
-    // issue #635
-    _currentTarget = nullptr;
+    for (auto index : _dirtyTargets)
+    {
+        purgeTarget(index);
+    }
+    _dirtyTargets.clear();
+    compactTargets();
+    _updating = false;
+
+    // releasing may delete nodes whose cleanup stops more actions, so it works on its own copy
+    std::vector<Ref*> removed;
+    removed.swap(_removed);
+    for (auto ref : removed)
+    {
+        ref->release();
+    }
 }
 
 NS_CC_END
@@ -32,12 +32,13 @@ THE SOFTWARE.
 #include "2d/CCAction.h"
 #include "base/CCVector.h"
 #include "base/CCRef.h"
+#include <unordered_map>
+#include <vector>
 
 NS_CC_BEGIN
 
 class Action;
-
-struct _hashElement;
+class ActionInterval;
 
 /**
  * @addtogroup actions
@@ -130,16 +131,44 @@ public:
     void update(float dt);
     
 protected:
-    // declared in ActionManager.m
-
-    void removeActionAtIndex(ssize_t index, struct _hashElement *element);
-    void deleteHashElement(struct _hashElement *element);
-    void actionAllocWithHashElement(struct _hashElement *element);
+    struct ActionEntry
+    {
+        Action          *action;
+        // the action MoveBy, ScaleTo, RotateBy or FadeTo acts through, itself or the action an ease wraps
+        ActionInterval  *inner;
+        unsigned char   kind;
+        unsigned char   ease;
+    };
+
+    struct TargetElement
+    {
+        Node                        *target;
+        // removed actions leave a null hole until purgeTarget drops it
+        std::vector<ActionEntry>    actions;
+        ssize_t                     count;
+        bool                        holes;
+        bool                        paused;
+    };
+
+    static ActionEntry makeEntry(Action *action);
+    static void stepInterval(const ActionEntry &entry, float dt);
+    ssize_t findTarget(const Node *target) const;
+    void removeActionAt(size_t index, size_t slot);
+    // drops the holes of an element and releases its target once it has no actions left
+    void purgeTarget(size_t index);
+    // drops the elements purgeTarget emptied, once they are a good part of the array
+    void compactTargets();
 
 protected:
-    struct _hashElement    *_targets;
-    struct _hashElement    *_currentTarget;
-    bool            _currentTargetSalvaged;
+    // in the order targets were added, so they are stepped in that order
+    std::vector<TargetElement>                  _targets;
+    std::unordered_map<const Node*, size_t>     _targetIndices;
+    // removed while updating, released once update is done with them
+    std::vector<Ref*>                           _removed;
+    // elements that got holes while updating
+    std::vector<size_t>                         _dirtyTargets;
+    size_t                                      _deadTargets;
+    bool                                        _updating;
 };
 
 // end of actions group
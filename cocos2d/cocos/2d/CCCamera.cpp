@@ -25,11 +25,15 @@
 #include "base/CCDirector.h"
 #include "platform/CCGLView.h"
 #include "2d/CCScene.h"
+#include "3d/CCAABB.h"
 
 NS_CC_BEGIN
 
 Camera* Camera::_visitingCamera = nullptr;
 
+// shared by all cameras, so a revision also tells which camera it came from
+static unsigned int s_frustumRevisions = 0;
+
 Camera* Camera::create()
 {
     Camera* camera = new (std::nothrow) Camera();
@@ -68,6 +72,7 @@ Camera* Camera::createOrthographic(float zoomX, float zoomY, float nearPlane, fl
 Camera::Camera()
 : _scene(nullptr)
 , _viewProjectionDirty(true)
+, _frustumRevision(0)
 , _cameraFlag(1)
 {
     
@@ -148,11 +153,51 @@ const Mat4& Camera::getViewProjectionMatrix() const
     {
         _viewProjectionDirty = false;
         Mat4::multiply(_projection, _view, &_viewProjection);
+        updateFrustumPlanes();
     }
     
     return _viewProjection;
 }
 
+void Camera::updateFrustumPlanes() const
+{
+    // the planes are sums and differences of the matrix rows, it is column major
+    const float* m = _viewProjection.m;
+    Vec4 row[4];
+    for (int i = 0; i < 4; i++)
+        row[i].set(m[i], m[4 + i], m[8 + i], m[12 + i]);
+    for (int i = 0; i < 3; i++)
+    {
+        _frustumPlanes[i * 2] = row[3] + row[i];
+        _frustumPlanes[i * 2 + 1] = row[3] - row[i];
+    }
+
+    // 0 is what nodes start with, so skip it when the counter wraps
+    if (++s_frustumRevisions == 0)
+        ++s_frustumRevisions;
+    _frustumRevision = s_frustumRevisions;
+}
+
+bool Camera::isVisibleInFrustum(const AABB& box, const Mat4& transform) const
+{
+    const float* m = transform.m;
+    for (const auto& plane : _frustumPlanes)
+    {
+        // the plane in the box's space is the plane times the transform
+        float a = plane.x * m[0] + plane.y * m[1] + plane.z * m[2] + plane.w * m[3];
+        float b = plane.x * m[4] + plane.y * m[5] + plane.z * m[6] + plane.w * m[7];
+        float c = plane.x * m[8] + plane.y * m[9] + plane.z * m[10] + plane.w * m[11];
+        float d = plane.x * m[12] + plane.y * m[13] + plane.z * m[14] + plane.w * m[15];
+        // the corner farthest along the normal, if that is outside the whole box is
+        float x = a >= 0 ? box._max.x : box._min.x;
+        float y = b >= 0 ? box._max.y : box._min.y;
+        float z = c >= 0 ? box._max.z : box._min.z;
+        if (a * x + b * y + c * z + d < 0)
+            return false;
+    }
+    return true;
+}
+
 void Camera::setAdditionalProjection(const Mat4& mat)
 {
     _projection = mat * _projection;
@@ -29,6 +29,7 @@ THE SOFTWARE.
 NS_CC_BEGIN
 
 class Scene;
+class AABB;
 
 /**
  * Note: 
@@ -130,6 +131,19 @@ public:
     /**get view projection matrix*/
     const Mat4& getViewProjectionMatrix() const;
 
+    /**
+    * Whether a box intersects the frustum of the view projection matrix, as of the last getViewProjectionMatrix() call.
+    * The box is in the space `transform` maps to world space, the frustum planes are brought into it instead of the corners out.
+    * Scene::render refreshes the matrix before each visit, so draw() can call this from the visit threads.
+    */
+    bool isVisibleInFrustum(const AABB& box, const Mat4& transform) const;
+
+    /**
+    * Changes every time the frustum planes are updated, and no two cameras share a value,
+    * so nodes can keep a visibility result for as long as their transform and this stay the same. Never 0.
+    */
+    unsigned int getFrustumRevision() const { return _frustumRevision; }
+
     /**
     * Convert the specified point of viewport from screenspace coordinate into the worldspace coordinate.
     */
@@ -156,6 +170,7 @@ CC_CONSTRUCTOR_ACCESS:
     bool initOrthographic(float zoomX, float zoomY, float nearPlane, float farPlane);
 
 protected:
+    void updateFrustumPlanes() const;
 
     Scene* _scene; //Scene camera belongs to
     Mat4 _projection;
@@ -170,6 +185,8 @@ protected:
     float _nearPlane;
     float _farPlane;
     mutable bool  _viewProjectionDirty;
+    mutable Vec4 _frustumPlanes[6]; // left, right, bottom, top, near, far. a point is inside when dot(plane, point) >= 0
+    mutable unsigned int _frustumRevision;
     unsigned short _cameraFlag; // camera flag
     
     static Camera* _visitingCamera;
@@ -30,6 +30,8 @@
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "renderer/CCRenderer.h"
+#include "renderer/CCUploadScheduler.h"
 
 
 NS_CC_BEGIN
@@ -45,6 +47,9 @@ FontAtlas::FontAtlas(Font &theFont)
 , _rendererRecreatedListener(nullptr)
 , _antialiasEnabled(true)
 , _rendererRecreate(false)
+, _dirtyTop(CacheTextureHeight)
+, _dirtyBottom(0)
+, _uploadScheduled(false)
 {
     _font->retain();
 
@@ -102,6 +107,11 @@ FontAtlas::~FontAtlas()
     }
 #endif
 
+    if (_uploadScheduled)
+    {
+        Director::getInstance()->getUploadScheduler()->cancel(this);
+    }
+
     _font->release();
     relaseTextures();
 
@@ -138,6 +148,8 @@ void FontAtlas::purgeTexturesAtlas()
         _currentPage = 0;
         _currentPageOrigX = 0;
         _currentPageOrigY = 0;
+        _dirtyTop = CacheTextureHeight;
+        _dirtyBottom = 0;
 
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
         eventDispatcher->dispatchCustomEvent(EVENT_PURGE_TEXTURES,this);
@@ -165,6 +177,8 @@ void FontAtlas::listenRendererRecreated(EventCustom *event)
         _currentPage = 0;
         _currentPageOrigX = 0;
         _currentPageOrigY = 0;
+        _dirtyTop = CacheTextureHeight;
+        _dirtyBottom = 0;
 
         _rendererRecreate = true;
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
@@ -196,6 +210,7 @@ bool FontAtlas::getLetterDefinitionForChar(char16_t letteCharUTF16, FontLetterDe
 
 bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16String)
 {
+    CCASSERT(!Renderer::isRecording(), "font atlases are filled on the cocos thread");
     FontFreeType* fontTTf = dynamic_cast<FontFreeType*>(_font);
     if(fontTTf == nullptr)
         return false;
@@ -241,17 +256,10 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16String)
                     _currentPageOrigX = 0;
                     if(_currentPageOrigY + _commonLineHeight >= CacheTextureHeight)
                     {
-                        unsigned char *data = nullptr;
-                        if(pixelFormat == Texture2D::PixelFormat::AI88)
-                        {
-                            data = _currentPageData + CacheTextureWidth * (int)startY * 2;
-                        }
-                        else
-                        {
-                            data = _currentPageData + CacheTextureWidth * (int)startY;
-                        }
-                        _atlasTextures[_currentPage]->updateWithData(data, 0, startY, 
-                            CacheTextureWidth, CacheTextureHeight - startY);
+                        // the page data is reused for the next page, so the full page can't wait for its upload job
+                        _dirtyTop = std::min(_dirtyTop, (int)startY);
+                        _dirtyBottom = CacheTextureHeight;
+                        uploadDirtyRows();
 
                         startY = 0.0f;
 
@@ -313,25 +321,41 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16String)
         {
             _atlasTextures[_currentPage]->initWithData(_currentPageData, _currentPageDataSize, 
                 pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
+            _dirtyTop = CacheTextureHeight;
+            _dirtyBottom = 0;
         } 
         else
         {
-            unsigned char *data = nullptr;
-            if(pixelFormat == Texture2D::PixelFormat::AI88)
+            // every label preparing letters this frame shares one upload of the rows they touched
+            _dirtyTop = std::min(_dirtyTop, (int)startY);
+            _dirtyBottom = std::max(_dirtyBottom, (int)(_currentPageOrigY + _commonLineHeight));
+            if (!_uploadScheduled)
             {
-                data = _currentPageData + CacheTextureWidth * (int)startY * 2;
+                _uploadScheduled = true;
+                ssize_t bytes = (ssize_t)(_dirtyBottom - _dirtyTop) * CacheTextureWidth * (_currentPageDataSize / (CacheTextureWidth * CacheTextureHeight));
+                Director::getInstance()->getUploadScheduler()->schedule(UploadScheduler::Type::FONT_ATLAS, bytes, this, [this](){
+                    _uploadScheduled = false;
+                    uploadDirtyRows();
+                });
             }
-            else
-            {
-                data = _currentPageData + CacheTextureWidth * (int)startY;
-            }
-            _atlasTextures[_currentPage]->updateWithData(data, 0, startY, 
-                CacheTextureWidth, _currentPageOrigY - startY + _commonLineHeight);
         }
     }
     return true;
 }
 
+void FontAtlas::uploadDirtyRows()
+{
+    if (_dirtyTop >= _dirtyBottom)
+        return;
+
+    int bytesPerPixel = _currentPageDataSize / (CacheTextureWidth * CacheTextureHeight);
+    _atlasTextures[_currentPage]->updateWithData(_currentPageData + CacheTextureWidth * _dirtyTop * bytesPerPixel, 0, _dirtyTop,
+        CacheTextureWidth, _dirtyBottom - _dirtyTop);
+
+    _dirtyTop = CacheTextureHeight;
+    _dirtyBottom = 0;
+}
+
 void FontAtlas::addTexture(Texture2D *texture, int slot)
 {
     texture->retain();
@@ -109,6 +109,8 @@ public:
 
 protected:
     void relaseTextures();
+    /**uploads the rows of the current page changed since the last upload*/
+    void uploadDirtyRows();
     std::unordered_map<ssize_t, Texture2D*> _atlasTextures;
     std::unordered_map<unsigned short, FontLetterDefinition> _fontLetterDefinitions;
     float _commonLineHeight;
@@ -126,6 +128,11 @@ protected:
     EventListenerCustom* _rendererRecreatedListener;
     bool _antialiasEnabled;
     bool _rendererRecreate;
+
+    // rows of the current page waiting for the UploadScheduler
+    int _dirtyTop;
+    int _dirtyBottom;
+    bool _uploadScheduled;
 };
 
 
@@ -36,6 +36,8 @@
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventCustom.h"
+#include "base/CCProfiling.h"
+#include "2d/CCCamera.h"
 
 #include "deprecated/CCString.h"
 
@@ -259,6 +261,7 @@ Label::Label(FontAtlas *atlas /* = nullptr */, TextHAlignment hAlignment /* = Te
 , _uniformEffectColor(0)
 , _shadowDirty(false)
 , _insideBounds(true)
+, _insideBoundsRevision(0)
 {
     setAnchorPoint(Vec2::ANCHOR_MIDDLE);
     reset();
@@ -890,9 +893,15 @@ void Label::drawShadowWithoutBlur()
 
 void Label::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
-    // Don't do calculate the culling if the transform was not updated
+    // Don't do calculate the culling if neither the transform nor the visiting camera's frustum changed
     bool transformUpdated = flags & FLAGS_TRANSFORM_DIRTY;
-    _insideBounds = transformUpdated ? renderer->checkVisibility(transform, _contentSize) : _insideBounds;
+    auto camera = Camera::getVisitingCamera();
+    unsigned int frustumRevision = camera ? camera->getFrustumRevision() : 0;
+    if (transformUpdated || frustumRevision != _insideBoundsRevision)
+    {
+        _insideBounds = renderer->checkVisibility(transform, _contentSize);
+        _insideBoundsRevision = frustumRevision;
+    }
 
     if(_insideBounds) {
         _customCommand.init(_globalZOrder);
@@ -1068,6 +1077,8 @@ void Label::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t pare
     {
         return;
     }
+    // both create sprites and fill the shared font atlas, see Node::setParallelVisit
+    CCASSERT(!Renderer::isRecording() || (!_systemFontDirty && !_contentDirty), "a Label can't change its text in a parallel visit");
     if (_systemFontDirty)
     {
         updateFont();
@@ -1100,8 +1111,12 @@ void Label::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t pare
     Director* director = Director::getInstance();
     CCASSERT(nullptr != director, "Director is null when seting matrix stack");
     
-    director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
-    director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
+    bool legacyStack = director->isLegacyMatrixStackEnabled();
+    if (legacyStack)
+    {
+        director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+        director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
+    }
     
 
     if (_textSprite)
@@ -1113,7 +1128,8 @@ void Label::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t pare
         draw(renderer, _modelViewTransform, flags);
     }
 
-    director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+    if (legacyStack)
+        director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
     
     // FIX ME: Why need to set _orderOfArrival to 0??
     // Please refer to https://github.com/cocos2d/cocos2d-x/pull/6920
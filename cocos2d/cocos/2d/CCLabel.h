@@ -406,6 +406,7 @@ protected:
     bool _clipEnabled;
     bool _blendFuncDirty;
     bool _insideBounds;                     /// whether or not the sprite was inside bounds the previous frame
+    unsigned int _insideBoundsRevision;     /// frustum revision of the camera _insideBounds was tested against
 
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Label);
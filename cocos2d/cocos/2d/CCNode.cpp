@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "2d/CCComponentContainer.h"
 #include "renderer/CCGLProgram.h"
 #include "renderer/CCGLProgramState.h"
+#include "renderer/CCRenderer.h"
 #include "math/TransformUtils.h"
 
 #include "deprecated/CCString.h"
@@ -132,6 +133,7 @@ Node::Node(void)
 , _cascadeColorEnabled(false)
 , _cascadeOpacityEnabled(false)
 , _cameraMask(1)
+, _parallelVisit(false)
 {
     // set default scheduler and actionManager
     Director *director = Director::getInstance();
@@ -1297,13 +1299,24 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
     // To ease the migration to v3.0, we still support the Mat4 stack,
     // but it is deprecated and your code should not rely on it
     Director* director = Director::getInstance();
-    director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
-    director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
+    bool legacyStack = director->isLegacyMatrixStackEnabled();
+    if (legacyStack)
+    {
+        director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+        director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
+    }
     
     bool visibleByCamera = isVisitableByVisitingCamera();
 
     int i = 0;
 
+#if CC_USE_PARALLEL_VISIT
+    if(_parallelVisit && !Renderer::isRecording() && _children.size() > 1)
+    {
+        visitChildrenInParallel(renderer, flags, visibleByCamera);
+    }
+    else
+#endif
     if(!_children.empty())
     {
         sortAllChildren();
@@ -1329,7 +1342,8 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
         this->draw(renderer, _modelViewTransform, flags);
     }
 
-    director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+    if (legacyStack)
+        director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
     
     // FIX ME: Why need to set _orderOfArrival to 0??
     // Please refer to https://github.com/cocos2d/cocos2d-x/pull/6920
@@ -1337,6 +1351,48 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
     // _orderOfArrival = 0;
 }
 
+void Node::visitChildrenInParallel(Renderer* renderer, uint32_t flags, bool visibleByCamera)
+{
+    sortAllChildren();
+    
+    int count = (int)_children.size();
+    int negative = 0;
+    while (negative < count && _children.at(negative)->_localZOrder < 0)
+        ++negative;
+    
+    // a few jobs per thread so one heavy subtree doesn't hold up the others,
+    // children with zOrder < 0 get their own jobs so this node's draw can go in between
+    int jobs = std::min(count, (renderer->getVisitThreads() + 1) * 4);
+    int negativeJobs = negative > 0 ? std::max(1, jobs * negative / count) : 0;
+    int positiveJobs = std::max(jobs - negativeJobs, count > negative ? 1 : 0);
+    jobs = negativeJobs + positiveJobs;
+    
+    const Mat4& transform = _modelViewTransform;
+    renderer->recordInParallel(jobs, [&](int job){
+        int first, last;
+        if (job < negativeJobs)
+        {
+            first = negative * job / negativeJobs;
+            last = negative * (job + 1) / negativeJobs;
+        }
+        else
+        {
+            job -= negativeJobs;
+            first = negative + (count - negative) * job / positiveJobs;
+            last = negative + (count - negative) * (job + 1) / positiveJobs;
+        }
+        for (int i = first; i < last; ++i)
+            _children.at(i)->visit(renderer, transform, flags);
+    });
+    
+    for (int job = 0; job < negativeJobs; ++job)
+        renderer->replayRecorded(job);
+    if (visibleByCamera)
+        this->draw(renderer, _modelViewTransform, flags);
+    for (int job = negativeJobs; job < jobs; ++job)
+        renderer->replayRecorded(job);
+}
+
 Mat4 Node::transform(const Mat4& parentTransform)
 {
     Mat4 ret = this->getNodeToParentTransform();
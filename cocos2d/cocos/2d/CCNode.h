@@ -1062,6 +1062,21 @@ public:
     virtual void visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags);
     virtual void visit() final;
 
+    /**
+     * Visits the children on the renderer's visit threads, see Renderer::recordInParallel.
+     * The commands are merged in child order, so it draws the same as a serial visit, as long as the children's
+     * draw() only touches their own subtree, or defers the rest with Renderer::runInVisitOrder.
+     * The deprecated matrix stack of the Director is not updated for them.
+     * Nothing under a parallel node may create shared objects or call GL while it is visited, so these can't go under one:
+     * - Labels that change their text or font after they are added, they fill the shared FontAtlas (it asserts)
+     * - RenderTexture, ClippingNode, NodeGrid, ui::Layout with clipping and cocostudio::BatchNode, they push render groups (it asserts)
+     * - any node that creates textures or program states, or calls GL, in visit() or draw() instead of in its commands
+     * Sprite3D is fine, when it needs new program states or its dummy texture it queues its meshes at replay, on the cocos thread.
+     * Only has an effect with CC_USE_PARALLEL_VISIT.
+     */
+    void setParallelVisit(bool parallelVisit) { _parallelVisit = parallelVisit; }
+    bool isParallelVisit() const { return _parallelVisit; }
+
 
     /** Returns the Scene that contains the Node.
      It returns `nullptr` if the node doesn't belong to any Scene.
@@ -1596,6 +1611,8 @@ protected:
     //check whether this camera mask is visible by the current visiting camera
     bool isVisitableByVisitingCamera() const;
     
+    void visitChildrenInParallel(Renderer* renderer, uint32_t flags, bool visibleByCamera);
+    
 #if CC_USE_PHYSICS
     void updatePhysicsBodyTransform(Scene* layer);
     virtual void updatePhysicsBodyPosition(Scene* layer);
@@ -1706,6 +1723,8 @@ protected:
     // camera mask, it is visible only when _cameraMask & current camera' camera flag is true
     unsigned short _cameraMask;
     
+    bool _parallelVisit;              ///< whether the children are visited on the visit threads
+    
     std::function<void()> _onEnterCallback;
     std::function<void()> _onExitCallback;
     std::function<void()> _onEnterTransitionDidFinishCallback;
@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "renderer/CCTexture2D.h"
 #include "renderer/CCRenderer.h"
 #include "base/CCDirector.h"
+#include "2d/CCCamera.h"
 
 #include "deprecated/CCString.h"
 
@@ -265,6 +266,7 @@ Sprite::Sprite(void)
 , _shouldBeHidden(false)
 , _texture(nullptr)
 , _insideBounds(true)
+, _insideBoundsRevision(0)
 {
 #if CC_SPRITE_DEBUG_DRAW
     _debugDrawNode = DrawNode::create();
@@ -585,8 +587,15 @@ void Sprite::updateTransform(void)
 
 void Sprite::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
-    // Don't do calculate the culling if the transform was not updated
-    _insideBounds = (flags & FLAGS_TRANSFORM_DIRTY) ? renderer->checkVisibility(transform, _contentSize) : _insideBounds;
+    // Don't do calculate the culling if neither the transform nor the visiting camera's frustum changed
+    auto camera = Camera::getVisitingCamera();
+    unsigned int frustumRevision = camera ? camera->getFrustumRevision() : 0;
+    if ((flags & FLAGS_TRANSFORM_DIRTY) || frustumRevision != _insideBoundsRevision)
+    {
+        _insideBounds = renderer->checkVisibility(transform, _contentSize);
+        _insideBoundsRevision = frustumRevision;
+    }
+    renderer->addCullResult(_insideBounds);
 
     if(_insideBounds)
     {
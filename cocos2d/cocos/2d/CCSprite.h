@@ -565,6 +565,7 @@ protected:
     bool _flippedY;                         /// Whether the sprite is flipped vertically or not
 
     bool _insideBounds;                     /// whether or not the sprite was inside bounds the previous frame
+    unsigned int _insideBoundsRevision;     /// frustum revision of the camera _insideBounds was tested against
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Sprite);
 };
@@ -166,11 +166,21 @@ void Bundle3D::destroyInstance()
     CC_SAFE_DELETE(_instance);
 }
 
+Bundle3D* Bundle3D::createBundle()
+{
+    return new (std::nothrow) Bundle3D();
+}
+
+void Bundle3D::destroyBundle(Bundle3D* bundle)
+{
+    delete bundle;
+}
+
 void Bundle3D::clear()
 {
     if (_isBinary)
     {
-        CC_SAFE_DELETE(_binaryBuffer);
+        _binaryBuffer = nullptr;
         CC_SAFE_DELETE_ARRAY(_references);
     }
     else
@@ -248,23 +258,24 @@ bool Bundle3D::loadObj(MeshDatas& meshdatas, MaterialDatas& materialdatas, NodeD
             meshdata->attribs.push_back(attrib);
         }
         auto vertexNum = shapes.positions.size() / 3;
-        for(auto i = 0; i < vertexNum; i++)
+        auto perVertex = 3 + (hasnormal ? 3 : 0) + (hastex ? 2 : 0);
+        meshdata->vertex.resize(vertexNum * perVertex);
+        float* vertex = meshdata->vertex.data();
+        for(size_t i = 0; i < vertexNum; i++)
         {
-            meshdata->vertex.push_back(shapes.positions[i * 3]);
-            meshdata->vertex.push_back(shapes.positions[i * 3 + 1]);
-            meshdata->vertex.push_back(shapes.positions[i * 3 + 2]);
+            memcpy(vertex, &shapes.positions[i * 3], 3 * sizeof(float));
+            vertex += 3;
 
             if (hasnormal)
             {
-                meshdata->vertex.push_back(shapes.normals[i * 3]);
-                meshdata->vertex.push_back(shapes.normals[i * 3 + 1]);
-                meshdata->vertex.push_back(shapes.normals[i * 3 + 2]);
+                memcpy(vertex, &shapes.normals[i * 3], 3 * sizeof(float));
+                vertex += 3;
             }
 
             if (hastex)
             {
-                meshdata->vertex.push_back(shapes.texcoords[i * 2]);
-                meshdata->vertex.push_back(shapes.texcoords[i * 2 + 1]);
+                memcpy(vertex, &shapes.texcoords[i * 2], 2 * sizeof(float));
+                vertex += 2;
             }
         }
         meshdatas.meshDatas.push_back(meshdata);
@@ -409,8 +420,10 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
             return false;
         }
 
-        meshData->vertex.resize(vertexSizeInFloat);
-        if (_binaryReader.read(&meshData->vertex[0], 4, vertexSizeInFloat) != vertexSizeInFloat)
+        meshData->mappedFile = _binaryBuffer;
+        meshData->mappedVertexSizeInFloat = vertexSizeInFloat;
+        meshData->mappedVertex = _binaryReader.readInPlace(4, vertexSizeInFloat);
+        if (!meshData->mappedVertex)
         {
             CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
             return false;
@@ -422,7 +435,6 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
 
         for (unsigned int k = 0; k < meshPartCount; ++k)
         {
-            std::vector<unsigned short>      indexArray;
             std:: string meshPartid = _binaryReader.readString();
             meshData->subMeshIds.push_back(meshPartid);
             unsigned int nIndexCount;
@@ -431,15 +443,15 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
                 CCLOG("warning: Failed to read meshdata: nIndexCount '%s'.", _path.c_str());
                 return false;
             }
-            indexArray.resize(nIndexCount);
-            if (_binaryReader.read(&indexArray[0], 2, nIndexCount) != nIndexCount)
+            const char* indices = _binaryReader.readInPlace(2, nIndexCount);
+            if (!indices)
             {
                 CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
                 return false;
             }
-            meshData->subMeshIndices.push_back(indexArray);
-            meshData->numIndex = (int)meshData->subMeshIndices.size();
-            meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
+            meshData->mappedSubMeshIndices.push_back(std::make_pair(indices, (ssize_t)nIndexCount));
+            meshData->numIndex = (int)meshData->mappedSubMeshIndices.size();
+            meshData->subMeshAABB.push_back(calculateAABB(meshData->mappedVertex, meshData->getPerVertexSize(), indices, nIndexCount));
         }
         meshdatas.meshDatas.push_back(meshData);
     }
@@ -520,8 +532,10 @@ bool Bundle3D::loadMeshDatasBinary_0_1(MeshDatas& meshdatas)
         return false;
     }
 
-    meshdata->vertex.resize(meshdata->vertexSizeInFloat);
-    if (_binaryReader.read(&meshdata->vertex[0], 4, meshdata->vertexSizeInFloat) != meshdata->vertexSizeInFloat)
+    meshdata->mappedFile = _binaryBuffer;
+    meshdata->mappedVertexSizeInFloat = meshdata->vertexSizeInFloat;
+    meshdata->mappedVertex = _binaryReader.readInPlace(4, meshdata->vertexSizeInFloat);
+    if (!meshdata->mappedVertex)
     {
         CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
         return false;
@@ -538,16 +552,15 @@ bool Bundle3D::loadMeshDatasBinary_0_1(MeshDatas& meshdatas)
             return false;
         }
 
-        std::vector<unsigned short> indices;
-        indices.resize(nIndexCount);
-        if (_binaryReader.read(&indices[0], 2, nIndexCount) != nIndexCount)
+        const char* indices = _binaryReader.readInPlace(2, nIndexCount);
+        if (!indices)
         {
             CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
             return false;
         }
 
-        meshdata->subMeshIndices.push_back(indices);
-        meshdata->subMeshAABB.push_back(calculateAABB(meshdata->vertex, meshdata->getPerVertexSize(), indices));
+        meshdata->mappedSubMeshIndices.push_back(std::make_pair(indices, (ssize_t)nIndexCount));
+        meshdata->subMeshAABB.push_back(calculateAABB(meshdata->mappedVertex, meshdata->getPerVertexSize(), indices, nIndexCount));
     }
 
     meshdatas.meshDatas.push_back(meshdata);
@@ -629,8 +642,10 @@ bool Bundle3D::loadMeshDatasBinary_0_2(MeshDatas& meshdatas)
         return false;
     }
 
-    meshdata->vertex.resize(meshdata->vertexSizeInFloat);
-    if (_binaryReader.read(&meshdata->vertex[0], 4, meshdata->vertexSizeInFloat) != meshdata->vertexSizeInFloat)
+    meshdata->mappedFile = _binaryBuffer;
+    meshdata->mappedVertexSizeInFloat = meshdata->vertexSizeInFloat;
+    meshdata->mappedVertex = _binaryReader.readInPlace(4, meshdata->vertexSizeInFloat);
+    if (!meshdata->mappedVertex)
     {
         CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
         return false;
@@ -653,16 +668,15 @@ bool Bundle3D::loadMeshDatasBinary_0_2(MeshDatas& meshdatas)
             return false;
         }
 
-        std::vector<unsigned short> indices;
-        indices.resize(nIndexCount);
-        if (_binaryReader.read(&indices[0], 2, nIndexCount) != nIndexCount)
+        const char* indices = _binaryReader.readInPlace(2, nIndexCount);
+        if (!indices)
         {
             CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
             return false;
         }
 
-        meshdata->subMeshIndices.push_back(indices);
-        meshdata->subMeshAABB.push_back(calculateAABB(meshdata->vertex, meshdata->getPerVertexSize(), indices));
+        meshdata->mappedSubMeshIndices.push_back(std::make_pair(indices, (ssize_t)nIndexCount));
+        meshdata->subMeshAABB.push_back(calculateAABB(meshdata->mappedVertex, meshdata->getPerVertexSize(), indices, nIndexCount));
     }
 
     meshdatas.meshDatas.push_back(meshdata);
@@ -979,11 +993,9 @@ bool Bundle3D::loadBinary(const std::string& path)
 {
     clear();
     
-    // get file data
-    CC_SAFE_DELETE(_binaryBuffer);
-    _binaryBuffer = new (std::nothrow) Data();
-    *_binaryBuffer = FileUtils::getInstance()->getDataFromFile(path);
-    if (_binaryBuffer->isNull())
+    // map the file, mesh datas keep pointing into it after the bundle moves on
+    _binaryBuffer = MappedFile::open(path);
+    if (!_binaryBuffer)
     {
         clear();
         CCLOG("warning: Failed to read file: %s", path.c_str());
@@ -1995,7 +2007,6 @@ Bundle3D::Bundle3D()
     _path(""),
     _version(""),
     _jsonBuffer(nullptr),
-    _binaryBuffer(nullptr),
     _referenceCount(0),
     _references(nullptr),
     _isBinary(false)
@@ -2009,14 +2020,24 @@ Bundle3D::~Bundle3D()
 }
 
 cocos2d::AABB Bundle3D::calculateAABB( const std::vector<float>& vertex, int stride, const std::vector<unsigned short>& index )
+{
+    return calculateAABB(vertex.data(), stride, index.data(), index.size());
+}
+
+cocos2d::AABB Bundle3D::calculateAABB(const void* vertex, int stride, const void* index, ssize_t indexCount)
 {
     AABB aabb;
-    stride /= 4;
-    for(const auto& it : index)
-        {
-            Vec3 point = Vec3(vertex[it * stride ], vertex[ it * stride + 1], vertex[it * stride + 2 ]);
-            aabb.updateMinMax(&point, 1);
-        }
+    const char* vertexBytes = (const char*)vertex;
+    const char* indexBytes = (const char*)index;
+    for (ssize_t i = 0; i < indexCount; i++)
+    {
+        // either may point into a mapped .c3b with no alignment
+        unsigned short it;
+        memcpy(&it, indexBytes + i * sizeof(it), sizeof(it));
+        Vec3 point;
+        memcpy(&point, vertexBytes + it * stride, sizeof(point));
+        aabb.updateMinMax(&point, 1);
+    }
     return aabb;
 }
 
@@ -49,6 +49,10 @@ public:
     
     static void destroyInstance();
     
+    /**creates a bundle of its own, the shared instance belongs to the cocos thread so loaders on other threads use these*/
+    static Bundle3D* createBundle();
+    static void destroyBundle(Bundle3D* bundle);
+    
 	virtual void clear();
 
     /**
@@ -82,6 +86,8 @@ public:
     
     //calculate aabb
     static AABB calculateAABB(const std::vector<float>& vertex, int stride, const std::vector<unsigned short>& index);
+    //stride is in bytes, vertex and index need no alignment
+    static AABB calculateAABB(const void* vertex, int stride, const void* index, ssize_t indexCount);
   
 protected:
 
@@ -168,7 +174,7 @@ protected:
     rapidjson::Document _jsonReader;
 
     // for binary reading
-    Data* _binaryBuffer;
+    std::shared_ptr<MappedFile> _binaryBuffer;
     BundleReader _binaryReader;
     unsigned int _referenceCount;
     Reference* _references;
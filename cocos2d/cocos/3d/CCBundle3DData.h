@@ -32,9 +32,12 @@
 
 #include <vector>
 #include <map>
+#include <memory>
  
 NS_CC_BEGIN
 
+class MappedFile;
+
 /**mesh vertex attribute*/
 struct MeshVertexAttrib
 {
@@ -127,6 +130,12 @@ struct MeshData
     int numIndex;
     std::vector<MeshVertexAttrib> attribs;
     int attribCount;
+    // a .c3b is read in place, its vertices and indices stay in the mapped file and vertex and
+    // subMeshIndices are left empty. The pointers have no alignment, read them with memcpy.
+    std::shared_ptr<MappedFile> mappedFile;
+    const char* mappedVertex;
+    ssize_t mappedVertexSizeInFloat;
+    std::vector<std::pair<const char*, ssize_t>> mappedSubMeshIndices;
 
 public:
     int getPerVertexSize() const
@@ -138,12 +147,22 @@ public:
         }
         return vertexsize;
     }
+    // vertices and indices wherever they are, use these instead of vertex and subMeshIndices
+    const void* getVertexData() const { return mappedVertex ? (const void*)mappedVertex : (const void*)vertex.data(); }
+    ssize_t getVertexSizeInFloat() const { return mappedVertex ? mappedVertexSizeInFloat : (ssize_t)vertex.size(); }
+    ssize_t getSubMeshCount() const { return mappedVertex ? (ssize_t)mappedSubMeshIndices.size() : (ssize_t)subMeshIndices.size(); }
+    const void* getSubMeshIndexData(ssize_t i) const { return mappedVertex ? (const void*)mappedSubMeshIndices[i].first : (const void*)subMeshIndices[i].data(); }
+    ssize_t getSubMeshIndexCount(ssize_t i) const { return mappedVertex ? mappedSubMeshIndices[i].second : (ssize_t)subMeshIndices[i].size(); }
     void resetData()
     {
         vertex.clear();
         subMeshIndices.clear();
         subMeshAABB.clear();
         attribs.clear();
+        mappedFile = nullptr;
+        mappedVertex = nullptr;
+        mappedVertexSizeInFloat = 0;
+        mappedSubMeshIndices.clear();
         vertexSizeInFloat = 0;
         numIndex = 0;
         attribCount = 0;
@@ -152,6 +171,8 @@ public:
     : vertexSizeInFloat(0)
     , numIndex(0)
     , attribCount(0)
+    , mappedVertex(nullptr)
+    , mappedVertexSizeInFloat(0)
     {
     }
     ~MeshData()
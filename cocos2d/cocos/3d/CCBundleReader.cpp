@@ -25,8 +25,69 @@
 #include "CCBundleReader.h"
 #include "platform/CCFileUtils.h"
 
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
+#define CC_BUNDLE_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CC_BUNDLE_USE_MMAP 0
+#endif
+
 NS_CC_BEGIN
 
+MappedFile::MappedFile()
+: _bytes(nullptr)
+, _size(0)
+, _mapped(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#if CC_BUNDLE_USE_MMAP
+    if (_mapped)
+        munmap((void*)_bytes, _size);
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& fullPath)
+{
+    std::shared_ptr<MappedFile> file(new (std::nothrow) MappedFile());
+    if (!file)
+        return nullptr;
+
+#if CC_BUNDLE_USE_MMAP
+    // files inside the apk have no file descriptor of their own and fail here
+    int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* bytes = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (bytes != MAP_FAILED)
+            {
+                file->_bytes = (const char*)bytes;
+                file->_size = st.st_size;
+                file->_mapped = true;
+            }
+        }
+        close(fd);
+        if (file->_mapped)
+            return file;
+    }
+#endif
+
+    file->_copy = FileUtils::getInstance()->getDataFromFile(fullPath);
+    if (file->_copy.isNull())
+        return nullptr;
+    file->_bytes = (const char*)file->_copy.getBytes();
+    file->_size = file->_copy.getSize();
+    return file;
+}
+
 BundleReader::BundleReader()
 {
     _buffer = nullptr;
@@ -84,6 +145,19 @@ ssize_t BundleReader::read(void* ptr, ssize_t size, ssize_t count)
     return validCount;
 }
 
+const char* BundleReader::readInPlace(ssize_t size, ssize_t count)
+{
+    if (!_buffer || count < 0 || size * count > _length - _position)
+    {
+        CCLOG("warning: bundle reader out of range");
+        return nullptr;
+    }
+
+    const char* ptr = _buffer + _position;
+    _position += size * count;
+    return ptr;
+}
+
 char* BundleReader::readLine(int num,char* line)
 {
     if (!_buffer)
@@ -27,13 +27,49 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "base/CCRef.h"
+#include "base/CCData.h"
 #include "platform/CCPlatformMacros.h"
 #include "base/CCConsole.h"
 
 NS_CC_BEGIN
 
+/**
+ * A whole file mapped read only into memory, so a bundle can be read in place.
+ * Where a file can not be mapped, e.g. inside the Android apk or on Windows, it holds
+ * a copy read through FileUtils instead.
+ */
+class CC_DLL MappedFile
+{
+public:
+    /**
+     * map a file
+     * @param fullPath The full path of the file
+     * @return the mapped file, nullptr if it can not be read
+     */
+    static std::shared_ptr<MappedFile> open(const std::string& fullPath);
+
+    ~MappedFile();
+
+    const char* getBytes() const { return _bytes; }
+    ssize_t getSize() const { return _size; }
+
+    /**
+     * Returns false if the file had to be copied into memory.
+     */
+    bool isMapped() const { return _mapped; }
+
+private:
+    MappedFile();
+
+    const char* _bytes;
+    ssize_t _size;
+    bool _mapped;
+    Data _copy;
+};
+
 /**
  * BundleReader is an interface for reading sequence of bytes.
  */
@@ -69,6 +105,14 @@ public:
      */
     ssize_t read(void* ptr, ssize_t size, ssize_t count);
 
+    /**
+     * Skips an array of elements without copying it.
+     *
+     * @return a pointer to the array inside the buffer, nullptr if the buffer is too short.
+     *         The pointer has no alignment, read the elements with memcpy.
+     */
+    const char* readInPlace(ssize_t size, ssize_t count);
+
     /**
      * Reads a line from the buffer.
      */
@@ -85,7 +85,7 @@ MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
 {
     auto vertexdata = new (std::nothrow) MeshVertexData();
     int pervertexsize = meshdata.getPerVertexSize();
-    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.vertex.size() / (pervertexsize / 4)));
+    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.getVertexSizeInFloat() / (pervertexsize / 4)));
     vertexdata->_vertexData = VertexData::create();
     CC_SAFE_RETAIN(vertexdata->_vertexData);
     CC_SAFE_RETAIN(vertexdata->_vertexBuffer);
@@ -100,20 +100,22 @@ MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
     
     if(vertexdata->_vertexBuffer)
     {
-        vertexdata->_vertexBuffer->updateVertices((void*)&meshdata.vertex[0], (int)meshdata.vertex.size() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
+        // straight from the mapped .c3b when the mesh came from one
+        vertexdata->_vertexBuffer->updateVertices(meshdata.getVertexData(), (int)meshdata.getVertexSizeInFloat() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
     }
     
-    bool needCalcAABB = (meshdata.subMeshAABB.size() != meshdata.subMeshIndices.size());
-    for (size_t i = 0; i < meshdata.subMeshIndices.size(); i++) {
-
-        auto& index = meshdata.subMeshIndices[i];
-        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)(index.size()));
-        indexBuffer->updateIndices(&index[0], (int)index.size(), 0);
-        std::string id = (i < meshdata.subMeshIds.size() ? meshdata.subMeshIds[i] : "");
+    bool needCalcAABB = ((ssize_t)meshdata.subMeshAABB.size() != meshdata.getSubMeshCount());
+    for (ssize_t i = 0; i < meshdata.getSubMeshCount(); i++) {
+
+        auto index = meshdata.getSubMeshIndexData(i);
+        auto indexCount = meshdata.getSubMeshIndexCount(i);
+        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)indexCount);
+        indexBuffer->updateIndices(index, (int)indexCount, 0);
+        std::string id = (i < (ssize_t)meshdata.subMeshIds.size() ? meshdata.subMeshIds[i] : "");
         MeshIndexData* indexdata = nullptr;
         if (needCalcAABB)
         {
-            auto aabb = Bundle3D::calculateAABB(meshdata.vertex, meshdata.getPerVertexSize(), index);
+            auto aabb = Bundle3D::calculateAABB(meshdata.getVertexData(), meshdata.getPerVertexSize(), index, indexCount);
             indexdata = MeshIndexData::create(id, vertexdata, indexBuffer, aabb);
         }
         else
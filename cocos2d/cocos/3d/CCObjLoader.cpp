@@ -18,53 +18,145 @@
 
 #include "CCObjLoader.h"
 
+#include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 
 #include "platform/CCFileUtils.h"
 #include "base/ccUtils.h"
+#include "xxhash.h"
 
 NS_CC_BEGIN
 
-struct vertex_index 
+struct vertex_index
 {
     int v_idx, vt_idx, vn_idx;
     vertex_index() {};
     vertex_index(int idx) : v_idx(idx), vt_idx(idx), vn_idx(idx) {};
     vertex_index(int vidx, int vtidx, int vnidx) : v_idx(vidx), vt_idx(vtidx), vn_idx(vnidx) {};
-    
+
 };
-// for std::map
-static inline bool operator<(const vertex_index& a, const vertex_index& b)
+
+static inline bool operator==(const vertex_index& a, const vertex_index& b)
 {
-    if (a.v_idx != b.v_idx) return (a.v_idx < b.v_idx);
-    if (a.vn_idx != b.vn_idx) return (a.vn_idx < b.vn_idx);
-    if (a.vt_idx != b.vt_idx) return (a.vt_idx < b.vt_idx);
-    return false;
+    return a.v_idx == b.v_idx && a.vn_idx == b.vn_idx && a.vt_idx == b.vt_idx;
 }
 
-struct obj_shape 
+// Open addressing table from a v/vt/vn triple to the index of the flattened vertex.
+// Every face corner goes through it, so it replaces the std::map the loader used to have.
+class VertexCache
 {
-    std::vector<float> v;
-    std::vector<float> vn;
-    std::vector<float> vt;
+public:
+    VertexCache() : _mask(0), _count(0) {}
+
+    // Returns the cached index, or inserts 'value' and returns -1.
+    int findOrInsert(const vertex_index& key, int value)
+    {
+        if ((_count + 1) * 2 > _slots.size())
+            grow();
+
+        size_t i = hash(key) & _mask;
+        while (_slots[i].value >= 0)
+        {
+            if (_slots[i].key == key)
+                return _slots[i].value;
+            i = (i + 1) & _mask;
+        }
+        _slots[i].key = key;
+        _slots[i].value = value;
+        _count++;
+        return -1;
+    }
+
+private:
+    struct Slot
+    {
+        vertex_index key;
+        int value;
+    };
+
+    static size_t hash(const vertex_index& key)
+    {
+        unsigned int h = (unsigned int)key.v_idx * 0x9E3779B1u;
+        h ^= (unsigned int)key.vt_idx * 0x85EBCA77u;
+        h ^= (unsigned int)key.vn_idx * 0xC2B2AE3Du;
+        return h ^ (h >> 15);
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old;
+        old.swap(_slots);
+        Slot empty;
+        empty.value = -1;
+        _slots.assign(old.empty() ? 1024 : old.size() * 2, empty);
+        _mask = _slots.size() - 1;
+        for (const auto& slot : old)
+        {
+            if (slot.value < 0)
+                continue;
+            size_t i = hash(slot.key) & _mask;
+            while (_slots[i].value >= 0)
+                i = (i + 1) & _mask;
+            _slots[i] = slot;
+        }
+    }
+
+    std::vector<Slot> _slots;
+    size_t _mask;
+    size_t _count;
 };
 
-static inline bool isSpace(const char c) 
+// Faces of the current group, flattened so a face costs no allocation of its own.
+struct face_group
+{
+    std::vector<vertex_index> corners;
+    std::vector<int> sizes;
+
+    bool empty() const { return sizes.empty(); }
+    void clear() { corners.clear(); sizes.clear(); }
+};
+
+static inline bool isSpace(const char c)
 {
     return (c == ' ') || (c == '\t');
 }
 
-static inline bool isNewLine(const char c) 
+static inline bool isNewLine(const char c)
 {
     return (c == '\r') || (c == '\n') || (c == '\0');
 }
 
+static inline bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// strspn/strcspn are not inlined and set up a table on every call, too slow for every number
+static inline void skipSpace(const char*& token)
+{
+    while (isSpace(*token))
+        token++;
+}
+
+static inline void skipToken(const char*& token)
+{
+    while (!isSpace(*token) && !isNewLine(*token))
+        token++;
+}
+
+static inline void skipIndex(const char*& token)
+{
+    while (*token != '/' && !isSpace(*token) && !isNewLine(*token))
+        token++;
+}
+
 // Make index zero-base, and also support relative index.
 static inline int fixIndex(int idx, int n)
 {
     int i;
-    
+
     if (idx > 0) {
         i = idx - 1;
     } else if (idx == 0) {
@@ -75,30 +167,112 @@ static inline int fixIndex(int idx, int n)
     return i;
 }
 
+// Reads an optionally signed integer and leaves 'token' after the last digit.
+static inline int readInt(const char*& token)
+{
+    bool negative = false;
+    if (*token == '-' || *token == '+')
+        negative = (*token++ == '-');
+
+    int i = 0;
+    while (isDigit(*token))
+        i = i * 10 + (*token++ - '0');
+    return negative ? -i : i;
+}
+
+// Reads a decimal float with up to 19 significant digits exactly, then scales it by a
+// power of ten in double precision, which is far more than a float needs.
+// Anything else (nan, inf, hex) goes to utils::atof.
+static inline float readFloat(const char*& token)
+{
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const double inversePowers[] = {
+        1e-0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11,
+        1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18, 1e-19, 1e-20, 1e-21, 1e-22
+    };
+
+    const char* p = token;
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; isDigit(*p); p++)
+    {
+        hasDigits = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa)
+                digits++;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if (*p == '.')
+    {
+        for (p++; isDigit(*p); p++)
+        {
+            hasDigits = true;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa)
+                    digits++;
+                exponent--;
+            }
+        }
+    }
+    if (!hasDigits)
+    {
+        float f = (float)utils::atof(token);
+        skipToken(token);
+        return f;
+    }
+    if ((*p == 'e' || *p == 'E') && (isDigit(p[1]) || ((p[1] == '-' || p[1] == '+') && isDigit(p[2]))))
+    {
+        p++;
+        exponent += readInt(p);
+    }
+    token = p;
+
+    double value = (double)mantissa;
+    if (mantissa != 0 && exponent > 0)
+        value *= exponent <= 22 ? powers[exponent] : std::pow(10.0, exponent);
+    else if (mantissa != 0 && exponent < 0)
+        value = exponent >= -22 ? value * inversePowers[-exponent] : value * std::pow(10.0, exponent);
+    return (float)(negative ? -value : value);
+}
+
 static inline std::string parseString(const char*& token)
 {
-    std::string s;
-    auto b = strspn(token, " \t");
-    auto e = strcspn(token, " \t\r");
-    s = std::string(&token[b], &token[e]);
-    
-    token += (e - b);
-    return s;
+    skipSpace(token);
+    const char* begin = token;
+    skipToken(token);
+    return std::string(begin, token);
 }
 
 static inline int parseInt(const char*& token)
 {
-    token += strspn(token, " \t");
-    int i = atoi(token);
-    token += strcspn(token, " \t\r");
+    skipSpace(token);
+    int i = readInt(token);
+    skipToken(token);
     return i;
 }
 
 static inline float parseFloat(const char*& token)
 {
-    token += strspn(token, " \t");
-    float f = (float)utils::atof(token);
-    token += strcspn(token, " \t\r");
+    skipSpace(token);
+    float f = readFloat(token);
+    skipToken(token);
     return f;
 }
 
@@ -119,123 +293,159 @@ static inline void parseFloat3(float& x, float& y, float& z, const char*& token)
 static vertex_index parseTriple(const char* &token, int vsize, int vnsize, int vtsize)
 {
     vertex_index vi(-1);
-    
-    vi.v_idx = fixIndex(atoi(token), vsize);
-    token += strcspn(token, "/ \t\r");
+
+    vi.v_idx = fixIndex(readInt(token), vsize);
+    skipIndex(token);
     if (token[0] != '/') {
         return vi;
     }
     token++;
-    
+
     // i//k
     if (token[0] == '/') {
         token++;
-        vi.vn_idx = fixIndex(atoi(token), vnsize);
-        token += strcspn(token, "/ \t\r");
+        vi.vn_idx = fixIndex(readInt(token), vnsize);
+        skipIndex(token);
         return vi;
     }
-    
+
     // i/j/k or i/j
-    vi.vt_idx = fixIndex(atoi(token), vtsize);
-    token += strcspn(token, "/ \t\r");
+    vi.vt_idx = fixIndex(readInt(token), vtsize);
+    skipIndex(token);
     if (token[0] != '/') {
         return vi;
     }
-    
+
     // i/j/k
     token++;  // skip '/'
-    vi.vn_idx = fixIndex(atoi(token), vnsize);
-    token += strcspn(token, "/ \t\r");
+    vi.vn_idx = fixIndex(readInt(token), vnsize);
+    skipIndex(token);
     return vi;
 }
 
-static ssize_t updateVertex( std::map<vertex_index, ssize_t>& vertexCache, std::vector<float>& positions, std::vector<float>& normals,
-             std::vector<float>& texcoords, const std::vector<float>& in_positions, const std::vector<float>& in_normals, const std::vector<float>& in_texcoords,
-             const vertex_index& i)
+// Walks the lines of a buffer in place. The line ending is overwritten with '\0', so each line
+// is a C string inside the buffer and nothing gets copied. Only a last line without a line
+// ending has no room for the terminator, that one line is copied.
+class LineScanner
 {
-    const auto it = vertexCache.find(i);
-    
-    if (it != vertexCache.end()) 
+public:
+    LineScanner(char* begin, char* end) : _cur(begin), _end(end) {}
+
+    const char* next()
+    {
+        if (_cur >= _end)
+            return nullptr;
+
+        char* line = _cur;
+        char* eol = (char*)memchr(_cur, '\n', _end - _cur);
+        if (!eol)
+        {
+            _last.assign(line, _end);
+            _cur = _end;
+            return _last.c_str();
+        }
+        *eol = '\0';
+        if (eol > line && eol[-1] == '\r')
+            eol[-1] = '\0';
+        _cur = eol + 1;
+        return line;
+    }
+
+private:
+    char* _cur;
+    char* _end;
+    std::string _last;
+};
+
+static bool updateVertex(VertexCache& vertexCache, std::vector<float>& positions, std::vector<float>& normals,
+                         std::vector<float>& texcoords, const std::vector<float>& in_positions, const std::vector<float>& in_normals, const std::vector<float>& in_texcoords,
+                         const vertex_index& i, unsigned short& index)
+{
+    int idx = (int)(positions.size() / 3);
+    int cached = vertexCache.findOrInsert(i, idx);
+    if (cached >= 0)
     {
         // found cache
-        return it->second;
-    }
-    
-    assert(in_positions.size() > (3*i.v_idx+2));
-    
-    positions.push_back(in_positions[3*i.v_idx+0]);
-    positions.push_back(in_positions[3*i.v_idx+1]);
-    positions.push_back(in_positions[3*i.v_idx+2]);
-    
-    if (i.vn_idx >= 0) 
-    {
-        normals.push_back(in_normals[3*i.vn_idx+0]);
-        normals.push_back(in_normals[3*i.vn_idx+1]);
-        normals.push_back(in_normals[3*i.vn_idx+2]);
-    }
-    
-    if (i.vt_idx >= 0) 
-    {
-        texcoords.push_back(in_texcoords[2*i.vt_idx+0]);
-        texcoords.push_back(in_texcoords[2*i.vt_idx+1]);
-    }
-    
-    auto idx = positions.size() / 3 - 1;
-    vertexCache[i] = idx;
-    
-    return idx;
+        index = (unsigned short)cached;
+        return true;
+    }
+
+    if (i.v_idx < 0 || in_positions.size() < 3 * (size_t)i.v_idx + 3
+        || (i.vn_idx >= 0 && in_normals.size() < 3 * (size_t)i.vn_idx + 3)
+        || (i.vt_idx >= 0 && in_texcoords.size() < 2 * (size_t)i.vt_idx + 2))
+    {
+        return false;
+    }
+
+    positions.insert(positions.end(), &in_positions[3*i.v_idx], &in_positions[3*i.v_idx] + 3);
+    if (i.vn_idx >= 0)
+    {
+        normals.insert(normals.end(), &in_normals[3*i.vn_idx], &in_normals[3*i.vn_idx] + 3);
+    }
+    if (i.vt_idx >= 0)
+    {
+        texcoords.insert(texcoords.end(), &in_texcoords[2*i.vt_idx], &in_texcoords[2*i.vt_idx] + 2);
+    }
+
+    index = (unsigned short)idx;
+    return true;
 }
 
-static bool exportFaceGroupToShape( std::map<vertex_index, ssize_t>& vertexCache, ObjLoader::shapes_t& shapes, const std::vector<float> &in_positions,
-                       const std::vector<float> &in_normals, const std::vector<float> &in_texcoords, const std::vector<std::vector<vertex_index> >& faceGroup,
-                       const ObjLoader::material_t &material, const std::string &name)
+static bool exportFaceGroupToShape(VertexCache& vertexCache, ObjLoader::shapes_t& shapes, const std::vector<float> &in_positions,
+                                   const std::vector<float> &in_normals, const std::vector<float> &in_texcoords, const face_group& faceGroup,
+                                   const ObjLoader::material_t &material, const std::string &name, std::stringstream& err)
 {
-    if (faceGroup.empty()) 
+    if (faceGroup.empty())
     {
         return false;
     }
-    
+
     // Flattened version of vertex data
     std::vector<float>& positions = shapes.positions;
     std::vector<float>& normals = shapes.normals;
     std::vector<float>& texcoords = shapes.texcoords;
     std::vector<unsigned short> indices;
-    
+    indices.reserve(faceGroup.corners.size() * 2);
+
     // Flatten vertices and indices
-    for (size_t i = 0; i < faceGroup.size(); i++) 
-    {
-        const std::vector<vertex_index>& face = faceGroup[i];
-        
-        vertex_index i0 = face[0];
-        vertex_index i1(-1);
-        vertex_index i2 = face[1];
-        
-        size_t npolys = face.size();
-        
+    const vertex_index* face = faceGroup.corners.data();
+    for (size_t i = 0; i < faceGroup.sizes.size(); face += faceGroup.sizes[i++])
+    {
+        size_t npolys = faceGroup.sizes[i];
+        if (npolys < 3)
+            continue;
+
+        unsigned short v0, v1, v2;
+        if (!updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, face[0], v0)
+            || !updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, face[1], v2))
+        {
+            err << "Invalid vertex index in group [" << name << "]" << std::endl;
+            return false;
+        }
+
         // Polygon -> triangle fan conversion
-        for (size_t k = 2; k < npolys; k++) 
-        {
-            i1 = i2;
-            i2 = face[k];
-            
-            unsigned short v0 = updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, i0);
-            unsigned short v1 = updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, i1);
-            unsigned short v2 = updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, i2);
-            
+        for (size_t k = 2; k < npolys; k++)
+        {
+            v1 = v2;
+            if (!updateVertex(vertexCache, positions, normals, texcoords, in_positions, in_normals, in_texcoords, face[k], v2))
+            {
+                err << "Invalid vertex index in group [" << name << "]" << std::endl;
+                return false;
+            }
+
             indices.push_back(v0);
             indices.push_back(v1);
             indices.push_back(v2);
         }
     }
-    
-    ObjLoader::shape_t shape;
+
+    shapes.shapes.push_back(ObjLoader::shape_t());
+    ObjLoader::shape_t& shape = shapes.shapes.back();
     shape.name = name;
     shape.material = material;
     shape.mesh.indices.swap(indices);
-    
-    shapes.shapes.push_back(shape);
+
     return true;
-    
 }
 
 std::string trim(const std::string& str)
@@ -244,7 +454,7 @@ std::string trim(const std::string& str)
         return str;
     auto len = str.length();
     char c = str[len - 1];
-    while (c == '\r' || c == '\n') 
+    while (c == '\r' || c == '\n')
     {
         len--;
         c = str[len - 1];
@@ -252,14 +462,14 @@ std::string trim(const std::string& str)
     return str.substr(0, len);
 }
 
-void InitMaterial(ObjLoader::material_t& material) 
+void InitMaterial(ObjLoader::material_t& material)
 {
     material.name = "";
     material.ambient_texname = "";
     material.diffuse_texname = "";
     material.specular_texname = "";
     material.normal_texname = "";
-    for (int i = 0; i < 3; i ++) 
+    for (int i = 0; i < 3; i ++)
     {
         material.ambient[i] = 0.f;
         material.diffuse[i] = 0.f;
@@ -270,84 +480,61 @@ void InitMaterial(ObjLoader::material_t& material)
     material.illum = 0;
     material.dissolve = 1.f;
     material.shininess = 1.f;
+    material.ior = 1.f;
     material.unknown_parameter.clear();
 }
 
-std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map, const char* filename, const char* mtl_basepath)
+static std::string mtlPath(const char* filename, const char* mtl_basepath)
+{
+    return mtl_basepath ? std::string(mtl_basepath) + std::string(filename) : std::string(filename);
+}
+
+static bool readMtl(const std::string& filepath, std::string& content)
+{
+    std::ifstream ifs(filepath.c_str(), std::ios::in | std::ios::binary);
+    if (!ifs)
+        return false;
+    std::ostringstream buf;
+    buf << ifs.rdbuf();
+    content = buf.str();
+    return true;
+}
+
+std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map, const std::string& content)
 {
     material_map.clear();
     std::stringstream err;
-    
-    std::string filepath;
-    
-    if (mtl_basepath) 
-    {
-        filepath = std::string(mtl_basepath) + std::string(filename);
-    }
-    else 
-    {
-        filepath = std::string(filename);
-    }
-    
-    std::ifstream ifs(filepath.c_str());
-    if (!ifs) 
-    {
-        err << "Cannot open file [" << filepath << "]" << std::endl;
-        return err.str();
-    }
-    
+
     ObjLoader::material_t material;
-    
-    int maxchars = 8192;  // Alloc enough size.
-    std::vector<char> buf(maxchars);  // Alloc enough size.
-    while (ifs.peek() != -1) 
+    InitMaterial(material);
+
+    std::string buf(content);
+    LineScanner lines(&buf[0], &buf[0] + buf.size());
+    while (const char* line = lines.next())
     {
-        ifs.getline(&buf[0], maxchars);
-        
-        std::string linebuf(&buf[0]);
-        
-        // Trim newline '\r\n' or '\r'
-        if (linebuf.size() > 0) 
-        {
-            if (linebuf[linebuf.size()-1] == '\n') linebuf.erase(linebuf.size()-1);
-        }
-        if (linebuf.size() > 0)
-        {
-            if (linebuf[linebuf.size()-1] == '\n') linebuf.erase(linebuf.size()-1);
-        }
-        
-        // Skip if empty line.
-        if (linebuf.empty())
-        {
-            continue;
-        }
-        
         // Skip leading space.
-        const char* token = linebuf.c_str();
-        token += strspn(token, " \t");
-        
-        assert(token);
+        const char* token = line;
+        skipSpace(token);
+
         if (token[0] == '\0') continue; // empty line
-        
+
         if (token[0] == '#') continue;  // comment line
-        
+
         // new mtl
         if ((0 == strncmp(token, "newmtl", 6)) && isSpace((token[6])))
         {
             // flush previous material.
             material_map.insert(std::pair<std::string, ObjLoader::material_t>(material.name, material));
-            
+
             // initial temporary material
             InitMaterial(material);
-            
+
             // set new mtl name
-            char namebuf[4096];
             token += 7;
-            sscanf(token, "%s", namebuf);
-            material.name = namebuf;
+            material.name = parseString(token);
             continue;
         }
-        
+
         // ambient
         if (token[0] == 'K' && token[1] == 'a' && isSpace((token[2])))
         {
@@ -359,7 +546,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.ambient[2] = b;
             continue;
         }
-        
+
         // diffuse
         if (token[0] == 'K' && token[1] == 'd' && isSpace((token[2])))
         {
@@ -371,7 +558,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.diffuse[2] = b;
             continue;
         }
-        
+
         // specular
         if (token[0] == 'K' && token[1] == 's' && isSpace((token[2])))
         {
@@ -383,7 +570,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.specular[2] = b;
             continue;
         }
-        
+
         // transmittance
         if (token[0] == 'K' && token[1] == 't' && isSpace((token[2])))
         {
@@ -395,7 +582,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.transmittance[2] = b;
             continue;
         }
-        
+
         // ior(index of refraction)
         if (token[0] == 'N' && token[1] == 'i' && isSpace((token[2])))
         {
@@ -403,7 +590,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.ior = parseFloat(token);
             continue;
         }
-        
+
         // emission
         if(token[0] == 'K' && token[1] == 'e' && isSpace(token[2]))
         {
@@ -415,7 +602,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.emission[2] = b;
             continue;
         }
-        
+
         // shininess
         if(token[0] == 'N' && token[1] == 's' && isSpace(token[2]))
         {
@@ -423,7 +610,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.shininess = parseFloat(token);
             continue;
         }
-        
+
         // illum model
         if (0 == strncmp(token, "illum", 5) && isSpace(token[5]))
         {
@@ -431,7 +618,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.illum = parseInt(token);
             continue;
         }
-        
+
         // dissolve
         if ((token[0] == 'd' && isSpace(token[1])))
         {
@@ -445,7 +632,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.dissolve = parseFloat(token);
             continue;
         }
-        
+
         // ambient texture
         if ((0 == strncmp(token, "map_Ka", 6)) && isSpace(token[6]))
         {
@@ -453,7 +640,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.ambient_texname = trim(token);
             continue;
         }
-        
+
         // diffuse texture
         if ((0 == strncmp(token, "map_Kd", 6)) && isSpace(token[6]))
         {
@@ -461,7 +648,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.diffuse_texname = trim(token);
             continue;
         }
-        
+
         // specular texture
         if ((0 == strncmp(token, "map_Ks", 6)) && isSpace(token[6]))
         {
@@ -469,7 +656,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.specular_texname = trim(token);
             continue;
         }
-        
+
         // normal texture
         if ((0 == strncmp(token, "map_Ns", 6)) && isSpace(token[6]))
         {
@@ -477,7 +664,7 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
             material.normal_texname = trim(token);
             continue;
         }
-        
+
         // unknown parameter
         const char* _space = strchr(token, ' ');
         if(!_space)
@@ -494,67 +681,299 @@ std::string LoadMtl ( std::map<std::string, ObjLoader::material_t>& material_map
     }
     // flush last material.
     material_map.insert(std::pair<std::string, ObjLoader::material_t>(material.name, material));
+
     return err.str();
 }
 
+//
+// Binary cache of a parsed .obj. The file name is the xxhash and size of the .obj content, the
+// header repeats both and lists the .mtl files with their hashes, so editing either one misses
+// the cache. The payload is the shapes_t arrays as they are in memory.
+//
+
+static const unsigned int CACHE_MAGIC = 0x4a424f43; // "COBJ"
+static const unsigned int CACHE_VERSION = 1;
+static const unsigned int MTL_MISSING = 0xffffffff;
+
+static bool s_cacheEnabled = true;
+
+struct mtl_source
+{
+    std::string path;
+    unsigned int size;
+    unsigned int hash;
+};
+
+class CacheWriter
+{
+public:
+    void u32(unsigned int value) { bytes(&value, sizeof(value)); }
+    void f32(float value) { bytes(&value, sizeof(value)); }
+    void str(const std::string& s) { u32((unsigned int)s.size()); bytes(s.data(), s.size()); }
+    template <typename T> void array(const std::vector<T>& v) { u32((unsigned int)v.size()); bytes(v.data(), v.size() * sizeof(T)); }
+    void bytes(const void* data, size_t size) { _buf.insert(_buf.end(), (const char*)data, (const char*)data + size); }
+
+    const std::vector<char>& buffer() const { return _buf; }
+
+private:
+    std::vector<char> _buf;
+};
+
+class CacheReader
+{
+public:
+    CacheReader(const unsigned char* data, size_t size) : _cur(data), _end(data + size), _ok(true) {}
+
+    unsigned int u32() { unsigned int value = 0; bytes(&value, sizeof(value)); return value; }
+    float f32() { float value = 0; bytes(&value, sizeof(value)); return value; }
+    void str(std::string& s)
+    {
+        size_t size = u32();
+        if (!check(size)) return;
+        s.assign((const char*)_cur, size);
+        _cur += size;
+    }
+    template <typename T> void array(std::vector<T>& v)
+    {
+        size_t count = u32();
+        if (!check(count * sizeof(T))) return;
+        v.resize(count);
+        if (count)
+            memcpy(&v[0], _cur, count * sizeof(T));
+        _cur += count * sizeof(T);
+    }
+    void bytes(void* data, size_t size)
+    {
+        if (!check(size)) return;
+        memcpy(data, _cur, size);
+        _cur += size;
+    }
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _cur == _end; }
+
+private:
+    bool check(size_t size)
+    {
+        if (_ok && size <= (size_t)(_end - _cur))
+            return true;
+        _ok = false;
+        return false;
+    }
+
+    const unsigned char* _cur;
+    const unsigned char* _end;
+    bool _ok;
+};
+
+static std::string cachePath(unsigned int hash, size_t size)
+{
+    char name[64];
+    sprintf(name, "objcache_%08x_%u.bin", hash, (unsigned int)size);
+    return FileUtils::getInstance()->getWritablePath() + name;
+}
+
+static void writeMaterial(CacheWriter& out, const ObjLoader::material_t& material)
+{
+    out.str(material.name);
+    for (int i = 0; i < 3; i++)
+    {
+        out.f32(material.ambient[i]);
+        out.f32(material.diffuse[i]);
+        out.f32(material.specular[i]);
+        out.f32(material.transmittance[i]);
+        out.f32(material.emission[i]);
+    }
+    out.f32(material.shininess);
+    out.f32(material.ior);
+    out.f32(material.dissolve);
+    out.u32((unsigned int)material.illum);
+    out.str(material.ambient_texname);
+    out.str(material.diffuse_texname);
+    out.str(material.specular_texname);
+    out.str(material.normal_texname);
+    out.u32((unsigned int)material.unknown_parameter.size());
+    for (const auto& it : material.unknown_parameter)
+    {
+        out.str(it.first);
+        out.str(it.second);
+    }
+}
+
+static void readMaterial(CacheReader& in, ObjLoader::material_t& material)
+{
+    in.str(material.name);
+    for (int i = 0; i < 3; i++)
+    {
+        material.ambient[i] = in.f32();
+        material.diffuse[i] = in.f32();
+        material.specular[i] = in.f32();
+        material.transmittance[i] = in.f32();
+        material.emission[i] = in.f32();
+    }
+    material.shininess = in.f32();
+    material.ior = in.f32();
+    material.dissolve = in.f32();
+    material.illum = (int)in.u32();
+    in.str(material.ambient_texname);
+    in.str(material.diffuse_texname);
+    in.str(material.specular_texname);
+    in.str(material.normal_texname);
+    material.unknown_parameter.clear();
+    unsigned int count = in.u32();
+    for (unsigned int i = 0; i < count && in.ok(); i++)
+    {
+        std::string key, value;
+        in.str(key);
+        in.str(value);
+        material.unknown_parameter[key] = value;
+    }
+}
+
+static void writeCache(const std::string& path, unsigned int hash, unsigned int size, const std::vector<mtl_source>& mtls, const ObjLoader::shapes_t& shapes)
+{
+    CacheWriter out;
+    out.u32(CACHE_MAGIC);
+    out.u32(CACHE_VERSION);
+    out.u32(hash);
+    out.u32(size);
+    out.u32((unsigned int)mtls.size());
+    for (const auto& mtl : mtls)
+    {
+        out.str(mtl.path);
+        out.u32(mtl.size);
+        out.u32(mtl.hash);
+    }
+    out.array(shapes.positions);
+    out.array(shapes.normals);
+    out.array(shapes.texcoords);
+    out.u32((unsigned int)shapes.shapes.size());
+    for (const auto& shape : shapes.shapes)
+    {
+        out.str(shape.name);
+        writeMaterial(out, shape.material);
+        out.array(shape.mesh.indices);
+    }
+
+    // write next to it and rename, a reader never sees half a file and two loaders don't clash
+    char suffix[32];
+    sprintf(suffix, ".%p.tmp", (const void*)&shapes);
+    std::string tmp = path + suffix;
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp)
+        return;
+    bool written = fwrite(out.buffer().data(), 1, out.buffer().size(), fp) == out.buffer().size();
+    written = fclose(fp) == 0 && written;
+    if (!written || rename(tmp.c_str(), path.c_str()) != 0)
+        remove(tmp.c_str());
+}
+
+static bool readCache(const std::string& path, unsigned int hash, unsigned int size, ObjLoader::shapes_t& shapes)
+{
+    auto fileUtils = FileUtils::getInstance();
+    if (!fileUtils->isFileExist(path))
+        return false;
+    Data data = fileUtils->getDataFromFile(path);
+    CacheReader in(data.getBytes(), data.getSize());
+    if (in.u32() != CACHE_MAGIC || in.u32() != CACHE_VERSION || in.u32() != hash || in.u32() != size)
+        return false;
+
+    unsigned int mtlCount = in.u32();
+    for (unsigned int i = 0; i < mtlCount && in.ok(); i++)
+    {
+        mtl_source mtl;
+        in.str(mtl.path);
+        mtl.size = in.u32();
+        mtl.hash = in.u32();
+        std::string content;
+        bool found = in.ok() && readMtl(mtl.path, content);
+        if (!in.ok() || found != (mtl.size != MTL_MISSING))
+            return false;
+        if (found && (content.size() != mtl.size || XXH32(content.data(), (int)content.size(), 0) != mtl.hash))
+            return false;
+    }
+
+    in.array(shapes.positions);
+    in.array(shapes.normals);
+    in.array(shapes.texcoords);
+    unsigned int shapeCount = in.u32();
+    if (!in.ok())
+        return false;
+    shapes.shapes.resize(shapeCount);
+    for (auto& shape : shapes.shapes)
+    {
+        in.str(shape.name);
+        readMaterial(in, shape.material);
+        in.array(shape.mesh.indices);
+    }
+    if (!in.ok() || !in.atEnd())
+    {
+        shapes.reset();
+        return false;
+    }
+    return true;
+}
+
+void ObjLoader::setCacheEnabled(bool enabled)
+{
+    s_cacheEnabled = enabled;
+}
+
+bool ObjLoader::isCacheEnabled()
+{
+    return s_cacheEnabled;
+}
+
 std::string ObjLoader::LoadObj(shapes_t& shapes, const char* filename, const char* mtl_basepath)
 {
     shapes.reset();
-    
+
     std::stringstream err;
-    std::istringstream ifs(FileUtils::getInstance()->getStringFromFile(filename));
-    std::map<vertex_index, ssize_t> vertexCache;
-    //std::ifstream ifs(filename);
-    
-    if (!ifs)
+    Data data = FileUtils::getInstance()->getDataFromFile(filename);
+
+    if (data.isNull())
     {
         err << "Cannot open file [" << filename << "]" << std::endl;
         return err.str();
     }
-    
+
+    char* begin = (char*)data.getBytes();
+    unsigned int size = (unsigned int)data.getSize();
+    unsigned int hash = 0;
+    std::string cache;
+    if (s_cacheEnabled)
+    {
+        hash = XXH32(begin, (int)size, 0);
+        cache = cachePath(hash, size);
+        if (readCache(cache, hash, size, shapes))
+            return "";
+    }
+
+    VertexCache vertexCache;
     std::vector<float> v;
     std::vector<float> vn;
     std::vector<float> vt;
-    std::vector<std::vector<vertex_index> > faceGroup;
+    face_group faceGroup;
     std::string name;
-    
+
     // material
     std::map<std::string, material_t> material_map;
+    std::vector<mtl_source> mtls;
     material_t material;
-    
-    int maxchars = 8192;  // Alloc enough size.
-    std::vector<char> buf(maxchars);  // Alloc enough size.
-    while (ifs.peek() != -1)
+    InitMaterial(material);
+
+    // the scanner writes line terminators into the buffer, so the hash above has to come first
+    LineScanner lines(begin, begin + size);
+    while (const char* line = lines.next())
     {
-        ifs.getline(&buf[0], maxchars);
-        
-        std::string linebuf(&buf[0]);
-        
-        // Trim newline '\r\n' or '\r'
-        if (linebuf.size() > 0)
-        {
-            if (linebuf[linebuf.size()-1] == '\n') linebuf.erase(linebuf.size()-1);
-        }
-        if (linebuf.size() > 0)
-        {
-            if (linebuf[linebuf.size()-1] == '\n') linebuf.erase(linebuf.size()-1);
-        }
-        
-        // Skip if empty line.
-        if (linebuf.empty())
-        {
-            continue;
-        }
-        
         // Skip leading space.
-        const char* token = linebuf.c_str();
-        token += strspn(token, " \t");
-        
-        assert(token);
+        const char* token = line;
+        skipSpace(token);
+
         if (token[0] == '\0') continue; // empty line
-        
+
         if (token[0] == '#') continue;  // comment line
-        
+
         // vertex
         if (token[0] == 'v' && isSpace((token[1])))
         {
@@ -566,7 +985,7 @@ std::string ObjLoader::LoadObj(shapes_t& shapes, const char* filename, const cha
             v.push_back(z);
             continue;
         }
-        
+
         // normal
         if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2])))
         {
@@ -578,7 +997,7 @@ std::string ObjLoader::LoadObj(shapes_t& shapes, const char* filename, const cha
             vn.push_back(z);
             continue;
         }
-        
+
         // texcoord
         if (token[0] == 'v' && token[1] == 't' && isSpace((token[2])))
         {
@@ -589,38 +1008,37 @@ std::string ObjLoader::LoadObj(shapes_t& shapes, const char* filename, const cha
             vt.push_back(y);
             continue;
         }
-        
+
         // face
         if (token[0] == 'f' && isSpace((token[1])))
         {
             token += 2;
-            token += strspn(token, " \t");
-            
-            std::vector<vertex_index> face;
+            skipSpace(token);
+
+            int corners = 0;
             while (!isNewLine(token[0])) {
                 // fix warning, cast to int, i think int is enough
                 vertex_index vi = parseTriple(token, (int)v.size() / 3, (int)vn.size() / 3, (int)vt.size() / 2);
-                face.push_back(vi);
-                auto n = strspn(token, " \t\r");
-                token += n;
+                faceGroup.corners.push_back(vi);
+                corners++;
+                skipSpace(token);
             }
-            
-            faceGroup.push_back(face);
-            
+
+            faceGroup.sizes.push_back(corners);
+
             continue;
         }
-        
+
         // use mtl
         if ((0 == strncmp(token, "usemtl", 6)) && isSpace((token[6])))
         {
-            
-            char namebuf[4096];
             token += 7;
-            sscanf(token, "%s", namebuf);
-            
-            if (material_map.find(namebuf) != material_map.end())
+            std::string mtlname = parseString(token);
+
+            auto it = material_map.find(mtlname);
+            if (it != material_map.end())
             {
-                material = material_map[namebuf];
+                material = it->second;
             }
             else
             {
@@ -628,82 +1046,91 @@ std::string ObjLoader::LoadObj(shapes_t& shapes, const char* filename, const cha
                 InitMaterial(material);
             }
             continue;
-            
+
         }
-        
+
         // load mtl
         if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6])))
         {
-            char namebuf[4096];
             token += 7;
-            sscanf(token, "%s", namebuf);
-            
-            std::string err_mtl = LoadMtl(material_map, namebuf, mtl_basepath);
-            if (!err_mtl.empty())
+            mtl_source mtl;
+            mtl.path = mtlPath(parseString(token).c_str(), mtl_basepath);
+
+            std::string content;
+            if (readMtl(mtl.path, content))
+            {
+                mtl.size = (unsigned int)content.size();
+                mtl.hash = XXH32(content.data(), (int)content.size(), 0);
+                mtls.push_back(mtl);
+                LoadMtl(material_map, content);
+            }
+            else
             {
+                // remembered as missing, so the cache is dropped once it shows up
+                mtl.size = MTL_MISSING;
+                mtl.hash = 0;
+                mtls.push_back(mtl);
+                material_map.clear();
                 faceGroup.clear();  // for safety
                 //return err_mtl;
             }
             continue;
         }
-        
+
         // group name
         if (token[0] == 'g' && isSpace((token[1])))
         {
             // flush previous face group.
-            shape_t shape;
-            exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name);
-            
-            faceGroup.clear();
-            
-            std::vector<std::string> names;
-            while (!isNewLine(token[0]))
-            {
-                std::string str = parseString(token);
-                names.push_back(str);
-                token += strspn(token, " \t\r"); // skip tag
-            }
-            
-            assert(names.size() > 0);
-            
-            // names[0] must be 'g', so skipt 0th element.
-            if (names.size() > 1)
-            {
-                name = names[1];
-            }
-            else
+            exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name, err);
+            if (!err.str().empty())
             {
-                name = "";
+                shapes.reset();
+                return err.str();
             }
-            
+
+            faceGroup.clear();
+
+            // skip the 'g' tag, only the first name is used
+            token += 2;
+            name = parseString(token);
+
             continue;
         }
-        
+
         // object name
         if (token[0] == 'o' && isSpace((token[1])))
         {
             // flush previous face group.
-            shape_t shape;
-            exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name);
-            
+            exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name, err);
+            if (!err.str().empty())
+            {
+                shapes.reset();
+                return err.str();
+            }
+
             faceGroup.clear();
-            
+
             // @todo { multiple object name? }
-            char namebuf[4096];
             token += 2;
-            sscanf(token, "%s", namebuf);
-            name = std::string(namebuf);
-            
+            name = parseString(token);
+
             continue;
         }
-        
+
         // Ignore unknown command.
     }
-    
-    shape_t shape;
-    exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name);
+
+    exportFaceGroupToShape(vertexCache, shapes, v, vn, vt, faceGroup, material, name, err);
     faceGroup.clear();  // for safety
-    
+    if (!err.str().empty())
+    {
+        shapes.reset();
+        return err.str();
+    }
+
+    if (s_cacheEnabled)
+        writeCache(cache, hash, size, mtls, shapes);
+
     return err.str();
 }
 
@@ -80,6 +80,12 @@ public:
                         const char* filename,
                         const char* mtl_basepath = NULL);
 
+    /// Parsed .obj files are written to the writable path as a binary cache, named after the
+    /// xxhash of the file content, and later loads of the same content read that instead of
+    /// parsing. Enabled by default.
+    static void setCacheEnabled(bool enabled);
+    static bool isCacheEnabled();
+
 };
 
 NS_CC_END
@@ -31,6 +31,7 @@
 #include "3d/CCMesh.h"
 
 #include "base/CCDirector.h"
+#include "base/CCScheduler.h"
 #include "2d/CCLight.h"
 #include "2d/CCCamera.h"
 #include "base/ccMacros.h"
@@ -38,11 +39,13 @@
 #include "platform/CCFileUtils.h"
 #include "renderer/CCTextureCache.h"
 #include "renderer/CCRenderer.h"
+#include "renderer/CCUploadScheduler.h"
 #include "renderer/CCGLProgramState.h"
 #include "renderer/CCGLProgramCache.h"
 
 #include "deprecated/CCString.h" // For StringUtils::format
 
+
 NS_CC_BEGIN
 
 std::string s_attributeNames[] = {GLProgram::ATTRIBUTE_NAME_POSITION, GLProgram::ATTRIBUTE_NAME_COLOR, GLProgram::ATTRIBUTE_NAME_TEX_COORD, GLProgram::ATTRIBUTE_NAME_TEX_COORD1, GLProgram::ATTRIBUTE_NAME_TEX_COORD2,GLProgram::ATTRIBUTE_NAME_TEX_COORD3,GLProgram::ATTRIBUTE_NAME_NORMAL, GLProgram::ATTRIBUTE_NAME_BLEND_WEIGHT, GLProgram::ATTRIBUTE_NAME_BLEND_INDEX};
@@ -73,6 +76,27 @@ Sprite3D* Sprite3D::create(const std::string &modelPath, const std::string &text
     return sprite;
 }
 
+void Sprite3D::createAsync(const std::string &modelPath, const std::function<void(Sprite3D*)>& callback)
+{
+    createAsync(modelPath, "", callback);
+}
+
+void Sprite3D::createAsync(const std::string &modelPath, const std::string &texturePath, const std::function<void(Sprite3D*)>& callback)
+{
+    if (modelPath.length() < 4)
+        CCASSERT(false, "improper name specified when creating Sprite3D");
+    
+    auto cache = Sprite3DCache::getInstance();
+    if (cache->getSpriteData(modelPath))
+    {
+        // already uploaded, creating it is cheap
+        auto sprite = texturePath.empty() ? create(modelPath) : create(modelPath, texturePath);
+        callback(sprite);
+        return;
+    }
+    cache->addSprite3DDataAsync(modelPath, texturePath, callback);
+}
+
 bool Sprite3D::loadFromCache(const std::string& path)
 {
     auto spritedata = Sprite3DCache::getInstance()->getSpriteData(path);
@@ -118,19 +142,9 @@ bool Sprite3D::loadFromObj(const std::string& path)
     MaterialDatas* materialdatas = new (std::nothrow) MaterialDatas();
     NodeDatas*   nodeDatas = new (std::nothrow) NodeDatas();
     bool ret = Bundle3D::loadObj(meshdatas, *materialdatas, *nodeDatas, fullPath);
-    if (ret && initFrom(*nodeDatas, meshdatas, *materialdatas))
+    if (ret)
     {
-        //add to cache
-        auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
-        data->materialdatas = materialdatas;
-        data->nodedatas = nodeDatas;
-        data->meshVertexDatas = _meshVertexDatas;
-        for (const auto mesh : _meshes) {
-            data->glProgramStates.pushBack(mesh->getGLProgramState());
-        }
-        
-        Sprite3DCache::getInstance()->addSprite3DData(path, data);
-        return true;
+        return initAndCache(path, meshdatas, materialdatas, nodeDatas);
     }
     delete materialdatas;
     delete nodeDatas;
@@ -151,8 +165,20 @@ bool Sprite3D::loadFromC3x(const std::string& path)
     NodeDatas*   nodeDatas = new (std::nothrow) NodeDatas();
     if (bundle->loadMeshDatas(meshdatas)
         && bundle->loadMaterials(*materialdatas)
-        && bundle->loadNodes(*nodeDatas)
-        && initFrom(*nodeDatas, meshdatas, *materialdatas))
+        && bundle->loadNodes(*nodeDatas))
+    {
+        return initAndCache(path, meshdatas, materialdatas, nodeDatas);
+    }
+    
+    delete materialdatas;
+    delete nodeDatas;
+    
+    return false;
+}
+
+bool Sprite3D::initAndCache(const std::string& path, const MeshDatas& meshdatas, MaterialDatas* materialdatas, NodeDatas* nodeDatas)
+{
+    if (initFrom(*nodeDatas, meshdatas, *materialdatas))
     {
         //add to cache
         auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
@@ -176,6 +202,7 @@ Sprite3D::Sprite3D()
 : _skeleton(nullptr)
 , _blend(BlendFunc::ALPHA_NON_PREMULTIPLIED)
 , _aabbDirty(true)
+, _localAABBMeshes(-1)
 , _lightMask(-1)
 , _shaderUsingLight(false)
 {
@@ -311,6 +338,8 @@ void Sprite3D::createAttachSprite3DNode(NodeData* nodedata,const MaterialDatas&
 }
 void Sprite3D::genGLProgramState(bool useLight)
 {
+    // the states are autoreleased and come from the shared caches
+    CCASSERT(!Renderer::isRecording(), "Sprite3D::genGLProgramState can't run in a parallel visit");
     _shaderUsingLight = useLight;
     
     std::unordered_map<const MeshVertexData*, GLProgramState*> glProgramestates;
@@ -522,6 +551,7 @@ void Sprite3D::removeAllAttachNode()
 //Generate a dummy texture when the texture file is missing
 static Texture2D * getDummyTexture()
 {
+    CCASSERT(!Renderer::isRecording(), "the dummy texture is created on the cocos thread");
     auto texture = Director::getInstance()->getTextureCache()->getTextureForKey("/dummyTexture");
     if(!texture)
     {
@@ -537,12 +567,36 @@ static Texture2D * getDummyTexture()
 
 void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
-    if (_skeleton)
-        _skeleton->updateBoneMatrix();
+    if (checkVisibility(renderer, transform))
+        drawMeshes(renderer, transform, flags);
+}
+
+bool Sprite3D::checkVisibility(Renderer *renderer, const Mat4 &transform)
+{
+    auto camera = Camera::getVisitingCamera();
+    if (!camera)
+        return true;
     
-    Color4F color(getDisplayedColor());
-    color.a = getDisplayedOpacity() / 255.0f;
+    // hidden meshes are merged too, so showing one does not need a rebuild
+    if (_localAABBMeshes != _meshes.size())
+    {
+        _localAABB.reset();
+        for (const auto& it : _meshes)
+            _localAABB.merge(it->getAABB());
+        _localAABBMeshes = _meshes.size();
+    }
+    
+    // no meshes, nothing to draw or count
+    if (_localAABB.isEmpty())
+        return false;
     
+    bool visible = camera->isVisibleInFrustum(_localAABB, transform);
+    renderer->addCullResult(visible);
+    return visible;
+}
+
+void Sprite3D::drawMeshes(Renderer *renderer, const Mat4 &transform, uint32_t flags)
+{
     //check light and determine the shader used
     const auto& lights = Director::getInstance()->getRunningScene()->getLights();
     bool usingLight = false;
@@ -551,9 +605,35 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
         if (usingLight)
             break;
     }
+    
+    // new program states and the dummy texture can only be made on the cocos thread,
+    // in a parallel visit the meshes are queued when the recording is replayed instead, in the same place
+    if (Renderer::isRecording())
+    {
+        bool needsCocosThread = usingLight != _shaderUsingLight;
+#if (!defined NDEBUG) || (defined CC_MODEL_VIEWER) 
+        for (const auto& mesh : _meshes)
+            needsCocosThread = needsCocosThread || (mesh->isVisible() && !mesh->getTexture());
+#endif
+        if (needsCocosThread)
+        {
+            Mat4 deferredTransform = transform;
+            renderer->runInVisitOrder([this, renderer, deferredTransform, flags](){
+                drawMeshes(renderer, deferredTransform, flags);
+            });
+            return;
+        }
+    }
+    
     if (usingLight != _shaderUsingLight)
         genGLProgramState(usingLight);
     
+    if (_skeleton)
+        _skeleton->updateBoneMatrix();
+    
+    Color4F color(getDisplayedColor());
+    color.a = getDisplayedOpacity() / 255.0f;
+    
     int i = 0;
     for (auto& mesh : _meshes) {
         if (!mesh->isVisible())
@@ -769,12 +849,327 @@ void Sprite3DCache::removeAllSprite3DData()
     _spriteDatas.clear();
 }
 
+//
+// async loading
+//
+struct Sprite3DCache::AsyncLoad
+{
+    struct Request
+    {
+        std::string texturePath;
+        std::function<void(Sprite3D*)> callback;
+    };
+
+    AsyncLoad()
+    : id(0)
+    , materialdatas(new (std::nothrow) MaterialDatas())
+    , nodedatas(new (std::nothrow) NodeDatas())
+    , loaded(false)
+    , pendingTextures(0)
+    {
+    }
+    ~AsyncLoad()
+    {
+        delete materialdatas;
+        delete nodedatas;
+    }
+
+    unsigned int id;
+    std::string path; // the key in the cache, as passed to createAsync
+    std::string fullPath;
+    std::vector<Request> requests;
+
+    // written by the worker thread
+    MeshDatas meshdatas;
+    MaterialDatas* materialdatas;
+    NodeDatas* nodedatas;
+    bool loaded;
+
+    int pendingTextures;
+};
+
+// everything initAndCache does before it needs GL, runs on a worker thread
+static bool parseModel(const std::string& fullPath, MeshDatas& meshdatas, MaterialDatas& materialdatas, NodeDatas& nodedatas)
+{
+    if (fullPath.length() < 4)
+        return false;
+
+    std::string ext = fullPath.substr(fullPath.length() - 4, 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), tolower);
+
+    bool ret = false;
+    if (ext == ".obj")
+    {
+        ret = Bundle3D::loadObj(meshdatas, materialdatas, nodedatas, fullPath);
+    }
+    else if (ext == ".c3b" || ext == ".c3t")
+    {
+        // the shared instance belongs to the cocos thread
+        auto bundle = Bundle3D::createBundle();
+        ret = bundle->load(fullPath)
+            && bundle->loadMeshDatas(meshdatas)
+            && bundle->loadMaterials(materialdatas)
+            && bundle->loadNodes(nodedatas);
+        Bundle3D::destroyBundle(bundle);
+    }
+
+    // MeshVertexData::create would compute the missing boxes on the cocos thread
+    for (auto meshdata : meshdatas.meshDatas)
+    {
+        if (meshdata && (ssize_t)meshdata->subMeshAABB.size() != meshdata->getSubMeshCount())
+        {
+            meshdata->subMeshAABB.clear();
+            for (ssize_t i = 0; i < meshdata->getSubMeshCount(); i++)
+            {
+                meshdata->subMeshAABB.push_back(Bundle3D::calculateAABB(meshdata->getVertexData(), meshdata->getPerVertexSize(),
+                                                                        meshdata->getSubMeshIndexData(i), meshdata->getSubMeshIndexCount(i)));
+            }
+        }
+    }
+    return ret;
+}
+
+void Sprite3DCache::addSprite3DDataAsync(const std::string& path, const std::string& texturePath, const std::function<void(Sprite3D*)>& callback)
+{
+    AsyncLoad::Request request;
+    request.texturePath = texturePath;
+    request.callback = callback;
+
+    auto it = _asyncLoads.find(path);
+    if (it != _asyncLoads.end())
+    {
+        auto load = it->second;
+        load->requests.push_back(request);
+        // the load is waiting for its textures, this one joins them
+        if (!texturePath.empty() && load->pendingTextures > 0)
+        {
+            load->pendingTextures++;
+            loadAsyncTexture(load, texturePath);
+        }
+        return;
+    }
+
+    static unsigned int s_loadIds = 0;
+    auto load = new (std::nothrow) AsyncLoad();
+    load->id = ++s_loadIds;
+    load->path = path;
+    // FileUtils caches full paths in a map that is not thread safe, so they are resolved here
+    load->fullPath = FileUtils::getInstance()->fullPathForFilename(path);
+    load->requests.push_back(request);
+    _asyncLoads[path] = load;
+
+    if (_loadingThreads.empty())
+    {
+        for (int i = 0; i < _asyncThreadCount; ++i)
+        {
+            _loadingThreads.push_back(std::thread(&Sprite3DCache::loadAsyncModels, this));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        _asyncQueue.push_back(load);
+    }
+    _asyncSleep.notify_one();
+
+    if (!_asyncScheduled)
+    {
+        _asyncScheduled = true;
+        Director::getInstance()->getScheduler()->schedule(CC_CALLBACK_1(Sprite3DCache::uploadAsyncModels, this), this, 0, false, "uploadAsyncModels");
+    }
+}
+
+void Sprite3DCache::loadAsyncModels()
+{
+    for (;;)
+    {
+        AsyncLoad* load = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_asyncMutex);
+            _asyncSleep.wait(lock, [this]{ return _quitAsync || !_asyncQueue.empty(); });
+            if (_quitAsync)
+                return;
+            load = _asyncQueue.front();
+            _asyncQueue.pop_front();
+        }
+
+        load->loaded = parseModel(load->fullPath, load->meshdatas, *load->materialdatas, *load->nodedatas);
+        if (!load->loaded)
+        {
+            CCLOG("warning: Sprite3DCache failed to load %s", load->path.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        _asyncParsed.push_back(load);
+    }
+}
+
+void Sprite3DCache::uploadAsyncModels(float dt)
+{
+    std::vector<AsyncLoad*> parsed;
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        parsed.swap(_asyncParsed);
+    }
+
+    // textures go through the TextureCache loading thread too, so initFrom finds them cached
+    for (auto load : parsed)
+    {
+        std::vector<std::string> textures;
+        if (load->loaded)
+        {
+            for (const auto& material : load->materialdatas->materials)
+            {
+                for (const auto& texture : material.textures)
+                {
+                    textures.push_back(texture.filename);
+                }
+            }
+            for (const auto& request : load->requests)
+            {
+                if (!request.texturePath.empty())
+                    textures.push_back(request.texturePath);
+            }
+        }
+
+        // one extra so textures that are already cached, and call back right away, can't finish the load early
+        load->pendingTextures = (int)textures.size() + 1;
+        for (const auto& texture : textures)
+        {
+            loadAsyncTexture(load, texture);
+        }
+        asyncTextureLoaded(load->path, load->id);
+    }
+
+    if (_asyncLoads.empty())
+    {
+        _asyncScheduled = false;
+        Director::getInstance()->getScheduler()->unschedule("uploadAsyncModels", this);
+    }
+}
+
+void Sprite3DCache::loadAsyncTexture(AsyncLoad* load, const std::string& texturePath)
+{
+    // the cache may be gone, or the path loaded again, by the time the texture is
+    auto path = load->path;
+    auto id = load->id;
+
+    // a missing texture must not keep the load waiting, initFrom skips it like the sync path does
+    if (!FileUtils::getInstance()->isFileExist(texturePath))
+    {
+        CCLOG("warning: Sprite3DCache can't find texture %s for %s", texturePath.c_str(), path.c_str());
+        asyncTextureLoaded(path, id);
+        return;
+    }
+
+    Director::getInstance()->getTextureCache()->addImageAsync(texturePath, [path, id](Texture2D*){
+        if (_cacheInstance)
+            _cacheInstance->asyncTextureLoaded(path, id);
+    });
+}
+
+void Sprite3DCache::asyncTextureLoaded(const std::string& path, unsigned int loadId)
+{
+    auto it = _asyncLoads.find(path);
+    if (it == _asyncLoads.end() || it->second->id != loadId)
+        return;
+
+    auto load = it->second;
+    if (--load->pendingTextures == 0)
+    {
+        // what MeshVertexData::create puts in GL buffers
+        ssize_t bytes = 0;
+        for (auto meshdata : load->meshdatas.meshDatas)
+        {
+            if (meshdata == nullptr)
+                continue;
+            bytes += meshdata->getVertexSizeInFloat() * sizeof(float);
+            for (ssize_t i = 0; i < meshdata->getSubMeshCount(); i++)
+            {
+                bytes += meshdata->getSubMeshIndexCount(i) * sizeof(unsigned short);
+            }
+        }
+        Director::getInstance()->getUploadScheduler()->schedule(UploadScheduler::Type::VERTEX_BUFFER, bytes, this, [this, load](){
+            finishAsyncLoad(load);
+        });
+    }
+}
+
+void Sprite3DCache::finishAsyncLoad(AsyncLoad* load)
+{
+    _asyncLoads.erase(load->path);
+
+    Sprite3D* sprite = nullptr;
+    if (load->loaded && getSpriteData(load->path) == nullptr)
+    {
+        sprite = new (std::nothrow) Sprite3D();
+        bool ret = sprite->initAndCache(load->path, load->meshdatas, load->materialdatas, load->nodedatas);
+        load->materialdatas = nullptr;
+        load->nodedatas = nullptr;
+        if (ret)
+        {
+            sprite->_contentSize = sprite->getBoundingBox().size;
+            sprite->autorelease();
+        }
+        else
+        {
+            CC_SAFE_DELETE(sprite);
+        }
+    }
+
+    // the first request gets the sprite that did the upload, the others come from the cache
+    for (const auto& request : load->requests)
+    {
+        if (sprite == nullptr && getSpriteData(load->path))
+        {
+            sprite = Sprite3D::create(load->path);
+        }
+        if (sprite && !request.texturePath.empty())
+        {
+            sprite->setTexture(request.texturePath);
+        }
+        request.callback(sprite);
+        sprite = nullptr;
+    }
+    delete load;
+}
+
 Sprite3DCache::Sprite3DCache()
+: _quitAsync(false)
+, _asyncScheduled(false)
 {
-    
+    // the cocos thread keeps a core
+    _asyncThreadCount = (int)std::thread::hardware_concurrency() - 1;
+    _asyncThreadCount = std::max(1, std::min(_asyncThreadCount, 4));
+}
+
+void Sprite3DCache::setAsyncThreadCount(int count)
+{
+    CCASSERT(_loadingThreads.empty(), "the loading threads have already started");
+    _asyncThreadCount = std::max(1, count);
 }
 Sprite3DCache::~Sprite3DCache()
 {
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        _quitAsync = true;
+    }
+    _asyncSleep.notify_all();
+    for (auto& thread : _loadingThreads)
+    {
+        thread.join();
+    }
+    if (_asyncScheduled)
+    {
+        Director::getInstance()->getScheduler()->unschedule("uploadAsyncModels", this);
+        Director::getInstance()->getUploadScheduler()->cancel(this);
+    }
+    // loads still in flight are dropped without calling back
+    for (auto& it : _asyncLoads)
+    {
+        delete it.second;
+    }
+
     removeAllSprite3DData();
 }
 
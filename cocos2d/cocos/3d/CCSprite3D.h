@@ -25,6 +25,11 @@
 #ifndef __CCSPRITE3D_H__
 #define __CCSPRITE3D_H__
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "base/CCVector.h"
@@ -56,6 +61,14 @@ public:
     // creates a Sprite3D. It only supports one texture, and overrides the internal texture with 'texturePath'
     static Sprite3D* create(const std::string &modelPath, const std::string &texturePath);
     
+    /** creates a Sprite3D without blocking: the model is parsed on worker threads and its textures are loaded with TextureCache::addImageAsync,
+     only the GL upload runs on the cocos thread, within the budget of the Director's UploadScheduler.
+     The callback runs on the cocos thread with the sprite, or nullptr if the model failed to load */
+    static void createAsync(const std::string &modelPath, const std::function<void(Sprite3D*)>& callback);
+    
+    // like the above, overriding the internal texture with 'texturePath'
+    static void createAsync(const std::string &modelPath, const std::string &texturePath, const std::function<void(Sprite3D*)>& callback);
+    
     /**set texture, set the first if multiple textures exist*/
     void setTexture(const std::string& texFile);
     void setTexture(Texture2D* texture);
@@ -138,6 +151,9 @@ CC_CONSTRUCTOR_ACCESS:
     
     /**load from .c3b or .c3t*/
     bool loadFromC3x(const std::string& path);
+    
+    /**init from parsed datas and add them to the Sprite3DCache under path, the cache takes ownership of materialdatas and nodedatas, they are deleted if it fails*/
+    bool initAndCache(const std::string& path, const MeshDatas& meshdatas, MaterialDatas* materialdatas, NodeDatas* nodedatas);
 
     /**draw*/
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
@@ -157,6 +173,10 @@ CC_CONSTRUCTOR_ACCESS:
     void onAABBDirty() { _aabbDirty = true; }
     
 protected:
+    /**tests the meshes against the frustum of the visiting camera and counts the result in the renderer stats*/
+    bool checkVisibility(Renderer *renderer, const Mat4 &transform);
+    /**queues the mesh commands, draw() calls it once the sprite passed the culling test*/
+    void drawMeshes(Renderer *renderer, const Mat4 &transform, uint32_t flags);
 
     Skeleton3D*                  _skeleton; //skeleton
     
@@ -171,8 +191,12 @@ protected:
     mutable AABB                 _aabb;                 // cache current aabb
     mutable Mat4                 _nodeToWorldTransform; // cache the matrix
     bool                         _aabbDirty;
+    AABB                         _localAABB;            // all meshes in node space, for culling
+    ssize_t                      _localAABBMeshes;      // mesh count _localAABB was merged from
     unsigned int                 _lightMask;
     bool                         _shaderUsingLight; // is current shader using light ?
+
+    friend class Sprite3DCache;
 };
 
 ///////////////////////////////////////////////////////
@@ -208,15 +232,43 @@ public:
     
     void removeAllSprite3DData();
     
+    /**number of threads parsing models for Sprite3D::createAsync, defaults to one less than the number of cores, between 1 and 4.
+     The threads start with the first createAsync, so it has to be set before that*/
+    void setAsyncThreadCount(int count);
+    int getAsyncThreadCount() const { return _asyncThreadCount; }
+    
     CC_CONSTRUCTOR_ACCESS:
     Sprite3DCache();
     ~Sprite3DCache();
     
 protected:
-    
+    struct AsyncLoad;
+    
+    /**queues path for the worker threads, requests for a path already loading share its load*/
+    void addSprite3DDataAsync(const std::string& path, const std::string& texturePath, const std::function<void(Sprite3D*)>& callback);
+    /**worker thread loop, parses models into MeshDatas, MaterialDatas and NodeDatas*/
+    void loadAsyncModels();
+    /**scheduled on the cocos thread while loads are in flight, loads the textures of parsed models*/
+    void uploadAsyncModels(float dt);
+    void loadAsyncTexture(AsyncLoad* load, const std::string& texturePath);
+    void asyncTextureLoaded(const std::string& path, unsigned int loadId);
+    /**upload job of a load whose textures are loaded, creates its sprite and calls back*/
+    void finishAsyncLoad(AsyncLoad* load);
     
     static Sprite3DCache*                        _cacheInstance;
     std::unordered_map<std::string, Sprite3DData*> _spriteDatas; //cached sprite datas
+    
+    std::vector<std::thread>                     _loadingThreads;
+    int                                          _asyncThreadCount;
+    std::mutex                                   _asyncMutex;
+    std::condition_variable                      _asyncSleep;
+    std::deque<AsyncLoad*>                       _asyncQueue;      //waiting for a worker, guarded by _asyncMutex
+    std::vector<AsyncLoad*>                      _asyncParsed;     //parsed, waiting for the cocos thread, guarded by _asyncMutex
+    bool                                         _quitAsync;       //guarded by _asyncMutex
+    std::unordered_map<std::string, AsyncLoad*>  _asyncLoads;      //everything in flight by path, cocos thread only
+    bool                                         _asyncScheduled;
+
+    friend class Sprite3D;
 };
 
 extern std::string CC_DLL s_attributeNames[];//attribute names array
@@ -44,6 +44,7 @@ Configuration::Configuration()
 , _supportsBGRA8888(false)
 , _supportsDiscardFramebuffer(false)
 , _supportsShareableVAO(false)
+, _supportsInstancedArrays(false)
 , _maxSamplesAllowed(0)
 , _maxTextureUnits(0)
 , _glExtensions(nullptr)
@@ -142,6 +143,9 @@ void Configuration::gatherGPUInfo()
     _supportsShareableVAO = checkForGLExtension("vertex_array_object");
 	_valueDict["gl.supports_vertex_array_object"] = Value(_supportsShareableVAO);
 
+    _supportsInstancedArrays = checkForGLExtension("GL_ARB_instanced_arrays") && checkForGLExtension("GL_ARB_draw_instanced");
+    _valueDict["gl.supports_instanced_arrays"] = Value(_supportsInstancedArrays);
+
     CHECK_GL_ERROR_DEBUG();
 }
 
@@ -247,6 +251,15 @@ bool Configuration::supportsShareableVAO() const
 #endif
 }
 
+bool Configuration::supportsInstancedArrays() const
+{
+#if CC_USE_INSTANCED_MESHES
+    return _supportsInstancedArrays;
+#else
+    return false;
+#endif
+}
+
 int Configuration::getMaxSupportDirLightInShader() const
 {
     return _maxDirLightInShader;
@@ -111,6 +111,11 @@ public:
      */
 	bool supportsShareableVAO() const;
     
+    /** Whether or not instanced draws (glDrawElementsInstanced + glVertexAttribDivisor) are supported.
+     @since v3.3
+     */
+    bool supportsInstancedArrays() const;
+    
     /** Max support directional light in shader, for Sprite3D
      @since v3.3
      */
@@ -162,6 +167,7 @@ protected:
     bool            _supportsBGRA8888;
     bool            _supportsDiscardFramebuffer;
     bool            _supportsShareableVAO;
+    bool            _supportsInstancedArrays;
     GLint           _maxSamplesAllowed;
     GLint           _maxTextureUnits;
     char *          _glExtensions;
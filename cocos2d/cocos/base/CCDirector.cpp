@@ -47,6 +47,7 @@ THE SOFTWARE.
 #include "renderer/CCTextureCache.h"
 #include "renderer/ccGLStateCache.h"
 #include "renderer/CCRenderer.h"
+#include "renderer/CCUploadScheduler.h"
 #include "2d/CCCamera.h"
 #include "base/CCUserDefault.h"
 #include "base/ccFPSImages.h"
@@ -116,9 +117,10 @@ bool Director::init(void)
     // FPS
     _accumDt = 0.0f;
     _frameRate = 0.0f;
-    _FPSLabel = _drawnBatchesLabel = _drawnVerticesLabel = nullptr;
+    _FPSLabel = _drawnBatchesLabel = _drawnVerticesLabel = _culledLabel = nullptr;
     _totalFrames = 0;
     _lastUpdate = new struct timeval;
+    _fixedDeltaTime = 0.0f;
 
     // paused ?
     _paused = false;
@@ -149,9 +151,13 @@ bool Director::init(void)
     _eventProjectionChanged->setUserData(this);
 
 
+    // uploads queued by the TextureCache loading threads
+    _uploadScheduler = new (std::nothrow) UploadScheduler();
+
     //init TextureCache
     initTextureCache();
     initMatrixStack();
+    _legacyMatrixStack = true;
 
     _renderer = new (std::nothrow) Renderer;
 
@@ -167,6 +173,7 @@ Director::~Director(void)
     CC_SAFE_RELEASE(_FPSLabel);
     CC_SAFE_RELEASE(_drawnVerticesLabel);
     CC_SAFE_RELEASE(_drawnBatchesLabel);
+    CC_SAFE_RELEASE(_culledLabel);
 
     CC_SAFE_RELEASE(_runningScene);
     CC_SAFE_RELEASE(_notificationNode);
@@ -180,6 +187,8 @@ Director::~Director(void)
 
     delete _renderer;
 
+    CC_SAFE_RELEASE(_uploadScheduler);
+
     delete _console;
 
 
@@ -268,6 +277,9 @@ void Director::drawScene()
         _eventDispatcher->dispatchEvent(_eventAfterUpdate);
     }
 
+    // before the visit, so nodes the upload callbacks add are drawn this frame
+    _uploadScheduler->update();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     /* to avoid flickr, nextScene MUST be here: after tick and before draw.
@@ -301,6 +313,7 @@ void Director::drawScene()
     {
         showStats();
     }
+
     _renderer->render();
 
     _eventDispatcher->dispatchEvent(_eventAfterDraw);
@@ -338,6 +351,10 @@ void Director::calculateDeltaTime()
         _deltaTime = 0;
         _nextDeltaTimeZero = false;
     }
+    else if (_fixedDeltaTime > 0)
+    {
+        _deltaTime = _fixedDeltaTime;
+    }
     else
     {
         _deltaTime = (now.tv_sec - _lastUpdate->tv_sec) + (now.tv_usec - _lastUpdate->tv_usec) / 1000000.0f;
@@ -564,6 +581,23 @@ void Director::pushMatrix(MATRIX_STACK_TYPE type)
     }
 }
 
+bool Director::isLegacyMatrixStackEnabled() const
+{
+    return _legacyMatrixStack && !Renderer::isRecording();
+}
+
+LegacyMatrixScope::LegacyMatrixScope(const Mat4& transform)
+{
+    auto director = Director::getInstance();
+    director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+    director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, transform);
+}
+
+LegacyMatrixScope::~LegacyMatrixScope()
+{
+    Director::getInstance()->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+}
+
 const Mat4& Director::getMatrix(MATRIX_STACK_TYPE type)
 {
     if(type == MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW)
@@ -957,6 +991,7 @@ void Director::purgeDirector()
     CC_SAFE_RELEASE_NULL(_FPSLabel);
     CC_SAFE_RELEASE_NULL(_drawnBatchesLabel);
     CC_SAFE_RELEASE_NULL(_drawnVerticesLabel);
+    CC_SAFE_RELEASE_NULL(_culledLabel);
 
     // purge bitmap cache
     FontFNT::purgeCachedData();
@@ -1075,12 +1110,14 @@ void Director::showStats()
 {
     static unsigned long prevCalls = 0;
     static unsigned long prevVerts = 0;
+    static unsigned long prevCulled = 0;
+    static unsigned long prevTested = 0;
     static float prevDeltaTime  = 0.016; // 60FPS
     static const float FPS_FILTER = 0.10;
 
     _accumDt += _deltaTime;
     
-    if (_displayStats && _FPSLabel && _drawnBatchesLabel && _drawnVerticesLabel)
+    if (_displayStats && _FPSLabel && _drawnBatchesLabel && _drawnVerticesLabel && _culledLabel)
     {
         char buffer[30];
 
@@ -1112,7 +1149,18 @@ void Director::showStats()
             prevVerts = currentVerts;
         }
 
+        // culled out of tested, the draws of the scene just rendered
+        auto currentCulled = (unsigned long)_renderer->getCulledObjects();
+        auto currentTested = currentCulled + (unsigned long)_renderer->getVisibleObjects();
+        if( currentCulled != prevCulled || currentTested != prevTested ) {
+            sprintf(buffer, "Culled:%5lu/%5lu", currentCulled, currentTested);
+            _culledLabel->setString(buffer);
+            prevCulled = currentCulled;
+            prevTested = currentTested;
+        }
+
         Mat4 identity = Mat4::IDENTITY;
+        _culledLabel->visit(_renderer, identity, 0);
         _drawnVerticesLabel->visit(_renderer, identity, 0);
         _drawnBatchesLabel->visit(_renderer, identity, 0);
         _FPSLabel->visit(_renderer, identity, 0);
@@ -1147,15 +1195,18 @@ void Director::createStatsLabel()
     std::string fpsString = "00.0";
     std::string drawBatchString = "000";
     std::string drawVerticesString = "00000";
+    std::string culledString = "00000/00000";
     if (_FPSLabel)
     {
         fpsString = _FPSLabel->getString();
         drawBatchString = _drawnBatchesLabel->getString();
         drawVerticesString = _drawnVerticesLabel->getString();
+        culledString = _culledLabel->getString();
         
         CC_SAFE_RELEASE_NULL(_FPSLabel);
         CC_SAFE_RELEASE_NULL(_drawnBatchesLabel);
         CC_SAFE_RELEASE_NULL(_drawnVerticesLabel);
+        CC_SAFE_RELEASE_NULL(_culledLabel);
         _textureCache->removeTextureForKey("/cc_fps_images");
         FileUtils::getInstance()->purgeCachedEntries();
     }
@@ -1204,10 +1255,17 @@ void Director::createStatsLabel()
     _drawnVerticesLabel->initWithString(drawVerticesString, texture, 12, 32, '.');
     _drawnVerticesLabel->setScale(scaleFactor);
 
+    _culledLabel = LabelAtlas::create();
+    _culledLabel->retain();
+    _culledLabel->setIgnoreContentScaleFactor(true);
+    _culledLabel->initWithString(culledString, texture, 12, 32, '.');
+    _culledLabel->setScale(scaleFactor);
+
 
     Texture2D::setDefaultAlphaPixelFormat(currentFormat);
 
     const int height_spacing = 22 / CC_CONTENT_SCALE_FACTOR();
+    _culledLabel->setPosition(Vec2(0, height_spacing*3) + CC_DIRECTOR_STATS_POSITION);
     _drawnVerticesLabel->setPosition(Vec2(0, height_spacing*2) + CC_DIRECTOR_STATS_POSITION);
     _drawnBatchesLabel->setPosition(Vec2(0, height_spacing*1) + CC_DIRECTOR_STATS_POSITION);
     _FPSLabel->setPosition(Vec2(0, height_spacing*0)+CC_DIRECTOR_STATS_POSITION);
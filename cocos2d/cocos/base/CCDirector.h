@@ -57,6 +57,7 @@ class EventCustom;
 class EventListenerCustom;
 class TextureCache;
 class Renderer;
+class UploadScheduler;
 class Camera;
 
 class Console;
@@ -160,6 +161,12 @@ public:
     inline bool isNextDeltaTimeZero() { return _nextDeltaTimeZero; }
     void setNextDeltaTimeZero(bool nextDeltaTimeZero);
 
+    /** Makes every frame advance by the given delta time instead of the measured wall clock time.
+     Useful to replay identical frames in benchmarks and tests. 0 restores the measured delta time.
+     */
+    inline float getFixedDeltaTime() const { return _fixedDeltaTime; }
+    inline void setFixedDeltaTime(float fixedDeltaTime) { _fixedDeltaTime = fixedDeltaTime; }
+
     /** Whether or not the Director is paused */
     inline bool isPaused() { return _paused; }
 
@@ -371,6 +378,9 @@ public:
      */
     Renderer* getRenderer() const { return _renderer; }
 
+    /** Returns the UploadScheduler, it runs the queued GL uploads every frame before the scene is rendered */
+    UploadScheduler* getUploadScheduler() const { return _uploadScheduler; }
+
     /** Returns the Console 
      @since v3.0
      */
@@ -392,6 +402,15 @@ public:
     const Mat4& getMatrix(MATRIX_STACK_TYPE type);
     void resetMatrixStack();
 
+    /** Whether the visits keep every node's transform loaded on the deprecated modelview stack.
+     It is only there for v2 code that reads the stack from draw(), turning it off saves a Mat4 copy in and out of the stack
+     per node per camera. Without it transforms only reach draw() as arguments, code that still reads the stack
+     wraps itself in a LegacyMatrixScope. Enabled by default.
+     */
+    void setLegacyMatrixStackEnabled(bool enabled) { _legacyMatrixStack = enabled; }
+    /** also false on threads recording a parallel visit, the stack is not thread safe */
+    bool isLegacyMatrixStackEnabled() const;
+
 protected:
     void purgeDirector();
     bool _purgeDirectorInNextLoop; // this flag will be set to true in end()
@@ -415,6 +434,7 @@ protected:
     std::stack<Mat4> _modelViewMatrixStack;
     std::stack<Mat4> _projectionMatrixStack;
     std::stack<Mat4> _textureMatrixStack;
+    bool _legacyMatrixStack;
 
     /** Scheduler associated with this director
      @since v2.0
@@ -434,6 +454,9 @@ protected:
         
     /* delta time since last tick to main loop */
 	float _deltaTime;
+
+    /* when greater than 0 it is used as the delta time of every frame */
+    float _fixedDeltaTime;
     
     /* The _openGLView, where everything is rendered, GLView is a abstract class,cocos2d-x provide GLViewImpl
      which inherit from it as default renderer context,you can have your own by inherit from it*/
@@ -455,6 +478,7 @@ protected:
     LabelAtlas *_FPSLabel;
     LabelAtlas *_drawnBatchesLabel;
     LabelAtlas *_drawnVerticesLabel;
+    LabelAtlas *_culledLabel;
     
     /** Whether or not the Director is paused */
     bool _paused;
@@ -497,6 +521,9 @@ protected:
     /* Renderer for the Director */
     Renderer *_renderer;
 
+    /* GL uploads spread over frames */
+    UploadScheduler *_uploadScheduler;
+
     /* Console for the director */
     Console *_console;
 
@@ -533,6 +560,25 @@ protected:
     bool _invalid;
 };
 
+/**
+ @brief Loads a transform on top of the modelview stack for as long as it lives.
+ The compatibility shim for code that reads the stack, like DrawPrimitives or v2 style draw(), when
+ Director::isLegacyMatrixStackEnabled() is off:
+ @code
+ LegacyMatrixScope scope(transform);
+ DrawPrimitives::drawLine(from, to);
+ @endcode
+ */
+class CC_DLL LegacyMatrixScope
+{
+public:
+    explicit LegacyMatrixScope(const Mat4& transform);
+    ~LegacyMatrixScope();
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(LegacyMatrixScope);
+};
+
 // end of base_node group
 /// @}
 
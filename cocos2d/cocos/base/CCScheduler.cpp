@@ -32,6 +32,8 @@ THE SOFTWARE.
 #include "base/ccCArray.h"
 #include "base/CCScriptSupport.h"
 
+#include <algorithm>
+
 NS_CC_BEGIN
 
 // data structures
@@ -61,9 +63,6 @@ typedef struct _hashSelectorEntry
 {
     ccArray             *timers;
     void                *target;
-    int                 timerIndex;
-    Timer               *currentTimer;
-    bool                currentTimerSalvaged;
     bool                paused;
     UT_hash_handle      hh;
 } tHashTimerEntry;
@@ -79,7 +78,22 @@ Timer::Timer()
 , _repeat(0)
 , _delay(0.0f)
 , _interval(0.0f)
+, _start(0)
+, _due(0)
+, _heapIndex(-1)
+, _order(0)
+, _paused(false)
+, _unscheduled(false)
+{
+}
+
+void Timer::setInterval(float interval)
 {
+    _interval = interval;
+    if (_scheduler)
+    {
+        _scheduler->timerChanged(this);
+    }
 }
 
 void Timer::setupTimerWithInterval(float seconds, unsigned int repeat, float delay)
@@ -145,6 +159,29 @@ void Timer::update(float dt)
     }
 }
 
+float Timer::fire(double now)
+{
+    // the steps of update() once _elapsed reached the delay or the interval
+    _elapsed = (float)(now - _start);
+    float elapsed = 0;
+    trigger();
+    if (! (_runForever && !_useDelay))
+    {
+        if (_useDelay)
+        {
+            elapsed = _elapsed - _delay;
+            _useDelay = false;
+        }
+        _timesExecuted += 1;
+
+        if (!_runForever && _timesExecuted > _repeat)
+        {    //unschedule timer
+            cancel();
+        }
+    }
+    return elapsed;
+}
+
 
 // TimerTargetSelector
 
@@ -237,6 +274,155 @@ void TimerScriptHandler::cancel()
 
 #endif
 
+// PerformQueue
+
+PerformQueue::PerformQueue()
+: _slots(new Slot[CAPACITY])
+, _pushPosition(0)
+, _performPosition(0)
+, _overflowing(false)
+, _overflowCount(0)
+, _latencySum(0)
+{
+    for (size_t i = 0; i < CAPACITY; ++i)
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+PerformQueue::~PerformQueue()
+{
+    // functions nobody performed are destroyed without running
+    for (size_t position = _performPosition; ; ++position)
+    {
+        Slot& slot = _slots[position % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+            break;
+        slot.perform(&slot.storage, false);
+    }
+    delete [] _slots;
+}
+
+PerformQueue::Slot* PerformQueue::claim()
+{
+    if (_overflowing.load(std::memory_order_acquire))
+        return nullptr;
+
+    size_t position = _pushPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Slot* slot = &_slots[position % CAPACITY];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            if (_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return slot;
+        }
+        else if (sequence < position)
+        {
+            // the slot still holds the function of the previous lap, the ring is full
+            return nullptr;
+        }
+        else
+        {
+            // another thread took this position
+            position = _pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void PerformQueue::publish(Slot* slot, Perform perform)
+{
+    slot->perform = perform;
+    slot->pushed = Clock::now();
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void PerformQueue::pushOverflow(std::function<void()>&& function)
+{
+    std::lock_guard<std::mutex> lock(_overflowMutex);
+    Overflowed overflowed = { std::move(function), Clock::now() };
+    _overflow.push_back(std::move(overflowed));
+    _overflowing.store(true, std::memory_order_release);
+    _overflowCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformQueue::countLatency(Clock::time_point pushed, Clock::time_point now)
+{
+    float latency = std::max(0.0f, std::chrono::duration<float>(now - pushed).count());
+    _latencySum += latency;
+    _stats.maxLatency = std::max(_stats.maxLatency, latency);
+    ++_stats.performed;
+}
+
+void PerformQueue::perform(float budget)
+{
+    _stats.performed = 0;
+    _stats.averageLatency = _stats.maxLatency = 0;
+    _stats.overflowed = _overflowCount.load(std::memory_order_relaxed);
+    _latencySum = 0;
+
+    // functions pushed by the ones performed here are past `end` and wait for the next call
+    size_t end = _pushPosition.load(std::memory_order_acquire);
+    if (_backlog.empty() && _performPosition == end && !_overflowing.load(std::memory_order_acquire))
+    {
+        _stats.pending = 0;
+        return;
+    }
+
+    auto now = Clock::now();
+    auto deadline = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(budget));
+    bool spent = false;
+
+    // the backlog was pushed after everything the ring held when it was taken, so it goes first
+    for (size_t count = _backlog.size(); count > 0 && !spent; --count)
+    {
+        Overflowed overflowed = std::move(_backlog.front());
+        _backlog.pop_front();
+        countLatency(overflowed.pushed, now);
+        overflowed.function();
+        now = Clock::now();
+        spent = now >= deadline;
+    }
+
+    while (_backlog.empty() && !spent && _performPosition != end)
+    {
+        Slot& slot = _slots[_performPosition % CAPACITY];
+        // claimed but not filled in yet
+        if (slot.sequence.load(std::memory_order_acquire) != _performPosition + 1)
+            break;
+        countLatency(slot.pushed, now);
+        slot.perform(&slot.storage, true);
+        slot.sequence.store(_performPosition + CAPACITY, std::memory_order_release);
+        ++_performPosition;
+        now = Clock::now();
+        spent = now >= deadline;
+    }
+
+    // once the ring ran empty the overflow can follow it, pushes go back to the ring after this
+    if (_overflowing.load(std::memory_order_acquire) && _performPosition == _pushPosition.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(_overflowMutex);
+        _backlog.insert(_backlog.end(), std::make_move_iterator(_overflow.begin()), std::make_move_iterator(_overflow.end()));
+        _overflow.clear();
+        _overflowing.store(false, std::memory_order_release);
+    }
+
+    if (_stats.performed > 0)
+        _stats.averageLatency = (float)(_latencySum / _stats.performed);
+    _stats.pending = (unsigned int)getPendingCount();
+}
+
+size_t PerformQueue::getPendingCount() const
+{
+    size_t pending = _backlog.size() + (_pushPosition.load(std::memory_order_acquire) - _performPosition);
+    if (_overflowing.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(_overflowMutex);
+        pending += _overflow.size();
+    }
+    return pending;
+}
+
 // implementation of Scheduler
 
 // Priority level reserved for system services.
@@ -252,20 +438,23 @@ Scheduler::Scheduler(void)
 , _updatesPosList(nullptr)
 , _hashForUpdates(nullptr)
 , _hashForTimers(nullptr)
-, _currentTarget(nullptr)
-, _currentTargetSalvaged(false)
+, _timerClock(0)
+, _timerOrder(0)
 , _updateHashLocked(false)
 #if CC_ENABLE_SCRIPT_BINDING
 , _scriptHandlerEntries(20)
 #endif
+, _performBudget(0.002f)
 {
-    // I don't expect to have more than 30 functions to all per frame
-    _functionsToPerform.reserve(30);
 }
 
 Scheduler::~Scheduler(void)
 {
     unscheduleAll();
+    for (auto timer : _timersToStart)
+    {
+        timer->release();
+    }
 }
 
 void Scheduler::removeHashElement(_hashSelectorEntry *element)
@@ -275,6 +464,173 @@ void Scheduler::removeHashElement(_hashSelectorEntry *element)
     free(element);
 }
 
+void Scheduler::addTimer(tHashTimerEntry *element, Timer *timer)
+{
+    timer->_order = _timerOrder++;
+    ccArrayAppendObject(element->timers, timer);
+    if (element->paused)
+    {
+        // _elapsed stays -1 until the target is resumed
+        timer->_paused = true;
+    }
+    else
+    {
+        timer->retain();
+        _timersToStart.push_back(timer);
+    }
+}
+
+void Scheduler::removeTimer(Timer *timer)
+{
+    // it may still be in _timersDue or _timersToStart, they hold a reference and skip it
+    timer->_unscheduled = true;
+    if (timer->_heapIndex >= 0)
+    {
+        heapRemove(timer);
+    }
+}
+
+void Scheduler::setTimersPaused(tHashTimerEntry *element, bool paused)
+{
+    if (element->paused == paused)
+    {
+        return;
+    }
+    element->paused = paused;
+
+    for (int i = 0; i < element->timers->num; ++i)
+    {
+        Timer *timer = static_cast<Timer*>(element->timers->arr[i]);
+        timer->_paused = paused;
+        if (paused)
+        {
+            // a paused timer does not count time, freeze what it counted so far
+            if (timer->_heapIndex >= 0)
+            {
+                heapRemove(timer);
+            }
+            if (timer->_elapsed != -1)
+            {
+                timer->_elapsed = (float)(_timerClock - timer->_start);
+            }
+        }
+        else if (timer->_elapsed == -1)
+        {
+            timer->retain();
+            _timersToStart.push_back(timer);
+        }
+        else
+        {
+            timer->_start = _timerClock - timer->_elapsed;
+            heapPush(timer);
+        }
+    }
+}
+
+void Scheduler::runTimer(Timer *timer)
+{
+    float elapsed = timer->fire(_timerClock);
+    if (timer->_unscheduled)
+    {
+        return;
+    }
+    if (timer->_paused)
+    {
+        // paused by its own callback, it resumes from the restarted count like update() did
+        timer->_elapsed = elapsed;
+        return;
+    }
+    if (timer->_heapIndex >= 0)
+    {
+        // paused and resumed by its own callback
+        heapRemove(timer);
+    }
+    timer->_start = _timerClock - elapsed;
+    heapPush(timer);
+}
+
+void Scheduler::timerChanged(Timer *timer)
+{
+    if (timer->_heapIndex >= 0)
+    {
+        heapRemove(timer);
+        heapPush(timer);
+    }
+}
+
+bool Scheduler::timerBefore(const Timer *a, const Timer *b) const
+{
+    return a->_due < b->_due || (a->_due == b->_due && a->_order < b->_order);
+}
+
+void Scheduler::heapPush(Timer *timer)
+{
+    timer->_due = timer->_start + timer->getNextFireDelay();
+    timer->_heapIndex = (int)_timerHeap.size();
+    _timerHeap.push_back(timer);
+    heapSiftUp(timer->_heapIndex);
+}
+
+void Scheduler::heapRemove(Timer *timer)
+{
+    int index = timer->_heapIndex;
+    Timer *last = _timerHeap.back();
+    _timerHeap.pop_back();
+    timer->_heapIndex = -1;
+    if (last != timer)
+    {
+        _timerHeap[index] = last;
+        last->_heapIndex = index;
+        heapSiftUp(index);
+        heapSiftDown(last->_heapIndex);
+    }
+}
+
+void Scheduler::heapSiftUp(int index)
+{
+    Timer *timer = _timerHeap[index];
+    while (index > 0)
+    {
+        int parent = (index - 1) / 2;
+        if (!timerBefore(timer, _timerHeap[parent]))
+        {
+            break;
+        }
+        _timerHeap[index] = _timerHeap[parent];
+        _timerHeap[index]->_heapIndex = index;
+        index = parent;
+    }
+    _timerHeap[index] = timer;
+    timer->_heapIndex = index;
+}
+
+void Scheduler::heapSiftDown(int index)
+{
+    Timer *timer = _timerHeap[index];
+    int count = (int)_timerHeap.size();
+    for (;;)
+    {
+        int child = index * 2 + 1;
+        if (child >= count)
+        {
+            break;
+        }
+        if (child + 1 < count && timerBefore(_timerHeap[child + 1], _timerHeap[child]))
+        {
+            child++;
+        }
+        if (!timerBefore(_timerHeap[child], timer))
+        {
+            break;
+        }
+        _timerHeap[index] = _timerHeap[child];
+        _timerHeap[index]->_heapIndex = index;
+        index = child;
+    }
+    _timerHeap[index] = timer;
+    timer->_heapIndex = index;
+}
+
 void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, bool paused, const std::string& key)
 {
     this->schedule(callback, target, interval, CC_REPEAT_FOREVER, 0.0f, paused, key);
@@ -325,7 +681,7 @@ void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float in
 
     TimerTargetCallback *timer = new (std::nothrow) TimerTargetCallback();
     timer->initWithCallback(this, callback, target, key, interval, repeat, delay);
-    ccArrayAppendObject(element->timers, timer);
+    addTimer(element, timer);
     timer->release();
 }
 
@@ -351,30 +707,13 @@ void Scheduler::unschedule(const std::string &key, void *target)
 
             if (key == timer->getKey())
             {
-                if (timer == element->currentTimer && (! element->currentTimerSalvaged))
-                {
-                    element->currentTimer->retain();
-                    element->currentTimerSalvaged = true;
-                }
-
+                // update() holds a reference to the timers it fires, so a timer can unschedule itself
+                removeTimer(timer);
                 ccArrayRemoveObjectAtIndex(element->timers, i, true);
 
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (element->timerIndex >= i)
-                {
-                    element->timerIndex--;
-                }
-
                 if (element->timers->num == 0)
                 {
-                    if (_currentTarget == element)
-                    {
-                        _currentTargetSalvaged = true;
-                    }
-                    else
-                    {
-                        removeHashElement(element);
-                    }
+                    removeHashElement(element);
                 }
 
                 return;
@@ -647,22 +986,12 @@ void Scheduler::unscheduleAllForTarget(void *target)
 
     if (element)
     {
-        if (ccArrayContainsObject(element->timers, element->currentTimer)
-            && (! element->currentTimerSalvaged))
+        for (int i = 0; i < element->timers->num; ++i)
         {
-            element->currentTimer->retain();
-            element->currentTimerSalvaged = true;
+            removeTimer(static_cast<Timer*>(element->timers->arr[i]));
         }
         ccArrayRemoveAllObjects(element->timers);
-
-        if (_currentTarget == element)
-        {
-            _currentTargetSalvaged = true;
-        }
-        else
-        {
-            removeHashElement(element);
-        }
+        removeHashElement(element);
     }
 
     // update selector
@@ -701,7 +1030,7 @@ void Scheduler::resumeTarget(void *target)
     HASH_FIND_PTR(_hashForTimers, &target, element);
     if (element)
     {
-        element->paused = false;
+        setTimersPaused(element, false);
     }
 
     // update selector
@@ -723,7 +1052,7 @@ void Scheduler::pauseTarget(void *target)
     HASH_FIND_PTR(_hashForTimers, &target, element);
     if (element)
     {
-        element->paused = true;
+        setTimersPaused(element, true);
     }
 
     // update selector
@@ -772,7 +1101,7 @@ std::set<void*> Scheduler::pauseAllTargetsWithMinPriority(int minPriority)
     for(tHashTimerEntry *element = _hashForTimers; element != nullptr;
         element = (tHashTimerEntry*)element->hh.next)
     {
-        element->paused = true;
+        setTimersPaused(element, true);
         idsWithSelectors.insert(element->target);
     }
 
@@ -820,11 +1149,7 @@ void Scheduler::resumeTargets(const std::set<void*>& targetsToResume)
 
 void Scheduler::performFunctionInCocosThread(const std::function<void ()> &function)
 {
-    _performMutex.lock();
-
-    _functionsToPerform.push_back(function);
-
-    _performMutex.unlock();
+    _performQueue.push(function);
 }
 
 // main loop
@@ -871,44 +1196,40 @@ void Scheduler::update(float dt)
         }
     }
 
-    // Iterate over all the custom selectors
-    for (tHashTimerEntry *elt = _hashForTimers; elt != nullptr; )
+    // Custom selectors, only the timers that are due are touched
+    _timerClock += dt;
+    while (!_timerHeap.empty() && _timerHeap[0]->_due <= _timerClock)
     {
-        _currentTarget = elt;
-        _currentTargetSalvaged = false;
+        Timer *timer = _timerHeap[0];
+        heapRemove(timer);
+        timer->retain();
+        _timersDue.push_back(timer);
+    }
 
-        if (! _currentTarget->paused)
+    // fire them in the order they were scheduled, callbacks may unschedule, pause or resume any of them
+    std::sort(_timersDue.begin(), _timersDue.end(), [](const Timer *a, const Timer *b) { return a->_order < b->_order; });
+    for (auto timer : _timersDue)
+    {
+        if (!timer->_unscheduled && !timer->_paused && timer->_heapIndex < 0)
         {
-            // The 'timers' array may change while inside this loop
-            for (elt->timerIndex = 0; elt->timerIndex < elt->timers->num; ++(elt->timerIndex))
-            {
-                elt->currentTimer = (Timer*)(elt->timers->arr[elt->timerIndex]);
-                elt->currentTimerSalvaged = false;
-
-                elt->currentTimer->update(dt);
-
-                if (elt->currentTimerSalvaged)
-                {
-                    // The currentTimer told the remove itself. To prevent the timer from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    elt->currentTimer->release();
-                }
-
-                elt->currentTimer = nullptr;
-            }
+            runTimer(timer);
         }
+        timer->release();
+    }
+    _timersDue.clear();
 
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashTimerEntry *)elt->hh.next;
-
-        // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
-        if (_currentTargetSalvaged && _currentTarget->timers->num == 0)
+    // timers scheduled since the last update count from here on, the frame they were scheduled in does not count
+    for (auto timer : _timersToStart)
+    {
+        if (!timer->_unscheduled && !timer->_paused && timer->_heapIndex < 0)
         {
-            removeHashElement(_currentTarget);
+            timer->_elapsed = 0;
+            timer->_start = _timerClock;
+            heapPush(timer);
         }
+        timer->release();
     }
+    _timersToStart.clear();
 
     // delete all updates that are marked for deletion
     // updates with priority < 0
@@ -939,7 +1260,6 @@ void Scheduler::update(float dt)
     }
 
     _updateHashLocked = false;
-    _currentTarget = nullptr;
 
 #if CC_ENABLE_SCRIPT_BINDING
     //
@@ -967,19 +1287,7 @@ void Scheduler::update(float dt)
     // Functions allocated from another thread
     //
 
-    // Testing size is faster than locking / unlocking.
-    // And almost never there will be functions scheduled to be called.
-    if( !_functionsToPerform.empty() ) {
-        _performMutex.lock();
-        // fixed #4123: Save the callback functions, they must be invoked after '_performMutex.unlock()', otherwise if new functions are added in callback, it will cause thread deadlock.
-        auto temp = _functionsToPerform;
-        _functionsToPerform.clear();
-        _performMutex.unlock();
-        for( const auto &function : temp ) {
-            function();
-        }
-        
-    }
+    _performQueue.perform(_performBudget);
 }
 
 void Scheduler::schedule(SEL_SCHEDULE selector, Ref *target, float interval, unsigned int repeat, float delay, bool paused)
@@ -1026,7 +1334,7 @@ void Scheduler::schedule(SEL_SCHEDULE selector, Ref *target, float interval, uns
     
     TimerTargetSelector *timer = new (std::nothrow) TimerTargetSelector();
     timer->initWithSelector(this, selector, target, interval, repeat, delay);
-    ccArrayAppendObject(element->timers, timer);
+    addTimer(element, timer);
     timer->release();
 }
 
@@ -1092,30 +1400,13 @@ void Scheduler::unschedule(SEL_SCHEDULE selector, Ref *target)
             
             if (selector == timer->getSelector())
             {
-                if (timer == element->currentTimer && (! element->currentTimerSalvaged))
-                {
-                    element->currentTimer->retain();
-                    element->currentTimerSalvaged = true;
-                }
-                
+                // update() holds a reference to the timers it fires, so a timer can unschedule itself
+                removeTimer(timer);
                 ccArrayRemoveObjectAtIndex(element->timers, i, true);
                 
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (element->timerIndex >= i)
-                {
-                    element->timerIndex--;
-                }
-                
                 if (element->timers->num == 0)
                 {
-                    if (_currentTarget == element)
-                    {
-                        _currentTargetSalvaged = true;
-                    }
-                    else
-                    {
-                        removeHashElement(element);
-                    }
+                    removeHashElement(element);
                 }
                 
                 return;
@@ -28,9 +28,14 @@ THE SOFTWARE.
 #ifndef __CCSCHEDULER_H__
 #define __CCSCHEDULER_H__
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <mutex>
 #include <set>
+#include <type_traits>
+#include <vector>
 
 #include "base/CCRef.h"
 #include "base/CCVector.h"
@@ -59,17 +64,23 @@ public:
     /** get interval in seconds */
     inline float getInterval() const { return _interval; };
     /** set interval in seconds */
-    inline void setInterval(float interval) { _interval = interval; };
+    void setInterval(float interval);
     
     void setupTimerWithInterval(float seconds, unsigned int repeat, float delay);
     
     virtual void trigger() = 0;
     virtual void cancel() = 0;
     
-    /** triggers the timer */
+    /** triggers the timer. The Scheduler only uses it for script timers, the others it fires from its timer heap */
     void update(float dt);
     
 protected:
+    friend class Scheduler;
+
+    /** called by the Scheduler when the timer is due, `now` is its timer clock. Returns the elapsed time to count on from */
+    float fire(double now);
+    /** seconds until the next trigger, counted from _start */
+    float getNextFireDelay() const { return _useDelay ? _delay : _interval; }
     
     Scheduler* _scheduler; // weak ref
     float _elapsed;
@@ -79,6 +90,14 @@ protected:
     unsigned int _repeat; //0 = once, 1 is 2 x executed
     float _delay;
     float _interval;
+
+    // timer heap state, see Scheduler::update
+    double _start;         // the scheduler clock when _elapsed was 0
+    double _due;           // _start + getNextFireDelay(), the heap key
+    int _heapIndex;        // -1 when not in the heap
+    unsigned int _order;   // schedule order, breaks ties between timers due at the same time
+    bool _paused;          // _elapsed is frozen, -1 if it never ran
+    bool _unscheduled;
 };
 
 
@@ -142,6 +161,140 @@ private:
 
 #endif
 
+//
+// PerformQueue
+//
+/** @brief Functions sent to the cocos2d thread by Scheduler::performFunctionInCocosThread.
+
+Any thread pushes, only the cocos2d thread performs. The first `CAPACITY` pending functions live in a
+lock free ring, callables up to `INLINE_SIZE` bytes are constructed right in their slot so a push does not
+allocate. When the ring is full the push falls back to a locked overflow list, nothing is ever dropped,
+and the functions of one thread still run in the order it pushed them.
+*/
+class CC_DLL PerformQueue
+{
+public:
+    static const size_t CAPACITY = 256;
+    static const size_t INLINE_SIZE = 48;
+
+    /** what the last perform() saw, latencies are in seconds from push to run */
+    struct Stats
+    {
+        unsigned int pending;   // left for the next frames, the queue depth
+        unsigned int performed;
+        unsigned int overflowed; // pushes that found the ring full, since the start
+        float averageLatency;
+        float maxLatency;
+    };
+
+    PerformQueue();
+    ~PerformQueue();
+
+    /** thread safe */
+    template <typename F>
+    void push(F&& function);
+
+    /** Runs the functions pushed before the call, oldest first, until `budget` seconds are spent.
+     At least one runs per call, so a slow function delays the rest instead of stalling them. Functions
+     pushed by the ones running wait for the next call. Only call it from the cocos2d thread.
+     */
+    void perform(float budget);
+
+    /** functions not performed yet, only call it from the cocos2d thread */
+    size_t getPendingCount() const;
+    const Stats& getStats() const { return _stats; }
+
+protected:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::aligned_storage<INLINE_SIZE>::type Storage;
+    // runs the stored function if asked and destroys it
+    typedef void (*Perform)(void* storage, bool run);
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence; // == position when free, position+1 when filled
+        Perform perform;
+        Clock::time_point pushed;
+        Storage storage;
+    };
+
+    struct Overflowed
+    {
+        std::function<void()> function;
+        Clock::time_point pushed;
+    };
+
+    template <typename F>
+    struct InlineFunction
+    {
+        static void perform(void* storage, bool run)
+        {
+            F* function = static_cast<F*>(storage);
+            if (run)
+                (*function)();
+            function->~F();
+        }
+        template <typename A>
+        static void store(void* storage, A&& function) { new (storage) F(std::forward<A>(function)); }
+    };
+
+    template <typename F>
+    struct HeapFunction
+    {
+        static void perform(void* storage, bool run)
+        {
+            F* function = *static_cast<F**>(storage);
+            if (run)
+                (*function)();
+            delete function;
+        }
+        template <typename A>
+        static void store(void* storage, A&& function) { *static_cast<F**>(storage) = new F(std::forward<A>(function)); }
+    };
+
+    Slot* claim(); // a slot reserved for the caller, nullptr when the ring is full or overflowing
+    void publish(Slot* slot, Perform perform);
+    void pushOverflow(std::function<void()>&& function);
+    void countLatency(Clock::time_point pushed, Clock::time_point now);
+
+    Slot* _slots;
+    std::atomic<size_t> _pushPosition;
+    char _pad[64]; // keeps the producers' counter off the consumer's cache line
+    size_t _performPosition;
+
+    // set while _overflow holds anything, pushes then skip the ring so one thread's functions stay in order
+    std::atomic<bool> _overflowing;
+    mutable std::mutex _overflowMutex;
+    std::atomic<unsigned int> _overflowCount;
+    std::vector<Overflowed> _overflow;
+    std::deque<Overflowed> _backlog; // taken from _overflow once the ring emptied, run before the ring
+
+    Stats _stats;
+    double _latencySum;
+};
+
+template <typename F>
+void PerformQueue::push(F&& function)
+{
+    typedef typename std::decay<F>::type Function;
+    Slot* slot = claim();
+    if (!slot)
+    {
+        pushOverflow(std::function<void()>(std::forward<F>(function)));
+        return;
+    }
+    if (sizeof(Function) <= sizeof(Storage) && std::alignment_of<Function>::value <= std::alignment_of<Storage>::value)
+    {
+        InlineFunction<Function>::store(&slot->storage, std::forward<F>(function));
+        publish(slot, &InlineFunction<Function>::perform);
+    }
+    else
+    {
+        HeapFunction<Function>::store(&slot->storage, std::forward<F>(function));
+        publish(slot, &HeapFunction<Function>::perform);
+    }
+}
+
 //
 // Scheduler
 //
@@ -363,6 +516,19 @@ public:
      @since v3.0
      */
     void performFunctionInCocosThread( const std::function<void()> &function);
+
+    /** same as above, but a small callable is stored in the queue as is instead of in a std::function */
+    template <typename F>
+    void performFunctionInCocosThread(F&& function) { _performQueue.push(std::forward<F>(function)); }
+
+    /** Seconds update() may spend on functions from other threads each frame, the rest wait for the next frames.
+     At least one runs per frame. Default is 0.002.
+     */
+    void setPerformFunctionBudget(float seconds) { _performBudget = seconds; }
+    float getPerformFunctionBudget() const { return _performBudget; }
+
+    /** queue depth and latency of the functions from other threads, as of the last update() */
+    const PerformQueue::Stats& getPerformFunctionStats() const { return _performQueue.getStats(); }
     
     /////////////////////////////////////
     
@@ -419,6 +585,7 @@ public:
     CC_DEPRECATED_ATTRIBUTE void unscheduleUpdateForTarget(Ref *target) { return unscheduleUpdate(target); };
     
 protected:
+    friend class Timer;
     
     /** Schedules the 'callback' function for a given target with a given priority.
      The 'callback' selector will be called every frame.
@@ -431,6 +598,19 @@ protected:
     void removeHashElement(struct _hashSelectorEntry *element);
     void removeUpdateFromHash(struct _listEntry *entry);
 
+    // timer specific
+
+    void addTimer(struct _hashSelectorEntry *element, Timer *timer);
+    void removeTimer(Timer *timer);
+    void setTimersPaused(struct _hashSelectorEntry *element, bool paused);
+    void runTimer(Timer *timer);
+    void timerChanged(Timer *timer);
+    bool timerBefore(const Timer *a, const Timer *b) const;
+    void heapPush(Timer *timer);
+    void heapRemove(Timer *timer);
+    void heapSiftUp(int index);
+    void heapSiftDown(int index);
+
     // update specific
 
     void priorityIn(struct _listEntry **list, const ccSchedulerFunc& callback, void *target, int priority, bool paused);
@@ -449,8 +629,12 @@ protected:
 
     // Used for "selectors with interval"
     struct _hashSelectorEntry *_hashForTimers;
-    struct _hashSelectorEntry *_currentTarget;
-    bool _currentTargetSalvaged;
+    // the running timers of unpaused targets, a min heap on the time they are due next
+    std::vector<Timer*> _timerHeap;
+    std::vector<Timer*> _timersDue;      // popped by this update, retained until they fired
+    std::vector<Timer*> _timersToStart;  // scheduled or resumed since the last update, retained
+    double _timerClock;                  // scaled seconds of all updates so far
+    unsigned int _timerOrder;
     // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
     bool _updateHashLocked;
     
@@ -459,8 +643,8 @@ protected:
 #endif
     
     // Used for "perform Function"
-    std::vector<std::function<void()>> _functionsToPerform;
-    std::mutex _performMutex;
+    PerformQueue _performQueue;
+    float _performBudget;
 };
 
 // end of global group
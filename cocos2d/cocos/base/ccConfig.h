@@ -180,6 +180,46 @@ Only valid for cocos2d-mac. Not supported on cocos2d-ios.
     #endif
 #endif
 
+/** @def CC_USE_INSTANCED_MESHES
+ If enabled, runs of MeshCommands that share vertex buffer, index buffer, program and texture are drawn
+ with one instanced draw call when the driver exposes GL_ARB_instanced_arrays and GL_ARB_draw_instanced.
+ Only desktop GL exposes those entry points, other platforms always use the per command loop.
+ 
+ To disable it set it to 0. Enabled by default on desktop.
+ */
+#ifndef CC_USE_INSTANCED_MESHES
+    #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+        #define CC_USE_INSTANCED_MESHES 1
+    #else
+        #define CC_USE_INSTANCED_MESHES 0
+    #endif
+#endif
+
+/** @def CC_USE_PARALLEL_VISIT
+ If enabled, nodes marked with Node::setParallelVisit() visit their children on the renderer's visit threads.
+ Each thread records its commands and the renderer merges them in child order, so the result is the same as a serial visit.
+ It needs C++11 thread_local, which the mobile toolchains don't support yet.
+ 
+ To disable it set it to 0. Enabled by default on desktop.
+ */
+#ifndef CC_USE_PARALLEL_VISIT
+    #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+        #define CC_USE_PARALLEL_VISIT 1
+    #else
+        #define CC_USE_PARALLEL_VISIT 0
+    #endif
+#endif
+
+/** @def CC_USE_ACTION_POOL
+ If enabled, Action and its subclasses are allocated from free lists of recycled blocks instead of the heap.
+ Games that build many short lived action trees, one Sequence of eases per explosion or score bump, save most of their allocations.
+ 
+ To disable it set it to 0. Enabled by default.
+ */
+#ifndef CC_USE_ACTION_POOL
+#define CC_USE_ACTION_POOL 1
+#endif
+
 
 /** @def CC_USE_LA88_LABELS
  If enabled, it will use LA88 (Luminance Alpha 16-bit textures) for LabelTTF objects.
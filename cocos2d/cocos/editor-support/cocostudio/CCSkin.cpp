@@ -221,10 +221,8 @@ Mat4 Skin::getNodeToWorldTransformAR() const
 
 void Skin::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
-    auto mv = Director::getInstance()->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
-
     //TODO: implement z order
-    _quadCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc, &_quad, 1, mv);
+    _quadCommand.init(_globalZOrder, _texture->getName(), getGLProgramState(), _blendFunc, &_quad, 1, transform);
     renderer->addCommand(&_quadCommand);
 }
 
@@ -91,6 +91,11 @@ public:
         VERTEX_ATTRIB_BLEND_INDEX,
         VERTEX_ATTRIB_MAX,
 
+        // per instance attributes of the instanced 3d program, past the predefined ones so the
+        // vertex attrib state cache never toggles them. the modelview is a mat4 and takes 4 locations
+        VERTEX_ATTRIB_INSTANCE_MV = VERTEX_ATTRIB_MAX,
+        VERTEX_ATTRIB_INSTANCE_COLOR = VERTEX_ATTRIB_INSTANCE_MV + 4,
+
         // backward compatibility
         VERTEX_ATTRIB_TEX_COORDS = VERTEX_ATTRIB_TEX_COORD,
     };
@@ -135,6 +140,7 @@ public:
     //3D
     static const char* SHADER_3D_POSITION;
     static const char* SHADER_3D_POSITION_TEXTURE;
+    static const char* SHADER_3D_POSITION_TEXTURE_INSTANCED;
     static const char* SHADER_3D_SKINPOSITION_TEXTURE;
     static const char* SHADER_3D_POSITION_NORMAL;
     static const char* SHADER_3D_POSITION_NORMAL_TEXTURE;
@@ -166,6 +172,9 @@ public:
     static const char* ATTRIBUTE_NAME_NORMAL;
     static const char* ATTRIBUTE_NAME_BLEND_WEIGHT;
     static const char* ATTRIBUTE_NAME_BLEND_INDEX;
+    // per instance attributes
+    static const char* ATTRIBUTE_NAME_INSTANCE_MV;
+    static const char* ATTRIBUTE_NAME_INSTANCE_COLOR;
 
     GLProgram();
     virtual ~GLProgram();
@@ -52,6 +52,7 @@ enum {
     kShaderType_LabelOutline,
     kShaderType_3DPosition,
     kShaderType_3DPositionTex,
+    kShaderType_3DPositionTexInstanced,
     kShaderType_3DSkinPositionTex,
     kShaderType_3DPositionNormal,
     kShaderType_3DPositionNormalTex,
@@ -207,6 +208,10 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_3DPositionTex);
     _programs.insert( std::make_pair(GLProgram::SHADER_3D_POSITION_TEXTURE, p) );
     
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_3DPositionTexInstanced);
+    _programs.insert( std::make_pair(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED, p) );
+    
     p = new (std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_3DSkinPositionTex);
     _programs.insert(std::make_pair(GLProgram::SHADER_3D_SKINPOSITION_TEXTURE, p));
@@ -321,6 +326,10 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DPositionTex);
     
+    p = getGLProgram(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_3DPositionTexInstanced);
+    
     p = getGLProgram(GLProgram::SHADER_3D_SKINPOSITION_TEXTURE);
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DSkinPositionTex);
@@ -396,6 +405,11 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_3DPositionTex:
             p->initWithByteArrays(cc3D_PositionTex_vert, cc3D_ColorTex_frag);
             break;
+        case kShaderType_3DPositionTexInstanced:
+            p->initWithByteArrays(cc3D_PositionTexInstanced_vert, cc3D_ColorTexInstanced_frag);
+            p->bindAttribLocation(GLProgram::ATTRIBUTE_NAME_INSTANCE_MV, GLProgram::VERTEX_ATTRIB_INSTANCE_MV);
+            p->bindAttribLocation(GLProgram::ATTRIBUTE_NAME_INSTANCE_COLOR, GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR);
+            break;
         case kShaderType_3DSkinPositionTex:
             p->initWithByteArrays(cc3D_SkinPositionTex_vert, cc3D_ColorTex_frag);
             break;
@@ -34,6 +34,7 @@
 #include "2d/CCLight.h"
 #include "renderer/ccGLStateCache.h"
 #include "renderer/CCGLProgramState.h"
+#include "renderer/CCGLProgramCache.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCTextureAtlas.h"
 #include "renderer/CCTexture2D.h"
@@ -84,6 +85,7 @@ MeshCommand::MeshCommand()
 , _matrixPalette(nullptr)
 , _matrixPaletteSize(0)
 , _materialID(0)
+, _instanceable(false)
 , _vao(0)
 , _cullFaceEnabled(false)
 , _cullFace(GL_BACK)
@@ -213,6 +215,10 @@ void MeshCommand::genMaterialID(GLuint texID, void* glProgramState, GLuint verte
     intArray[5] = (int) blend.src;
     intArray[6] = (int) blend.dst;
     _materialID = XXH32((const void*)intArray, sizeof(intArray), 0);
+    
+    auto glProgram = static_cast<GLProgramState*>(glProgramState)->getGLProgram();
+    _instanceable = Configuration::getInstance()->supportsInstancedArrays()
+        && glProgram == GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_TEXTURE);
 }
 
 void MeshCommand::MatrixPalleteCallBack( GLProgram* glProgram, Uniform* uniform)
@@ -278,6 +284,72 @@ void MeshCommand::postBatchDraw()
     }
 }
 
+void MeshCommand::batchDrawInstanced(const std::vector<MeshCommand*>& commands, GLuint instanceBuffer, std::vector<GLfloat>& instanceData)
+{
+#if CC_USE_INSTANCED_MESHES
+    // column major modelview followed by the display color
+    static const int FLOATS_PER_INSTANCE = 16 + 4;
+    static const GLsizei INSTANCE_STRIDE = FLOATS_PER_INSTANCE * sizeof(GLfloat);
+    
+    auto first = commands.front();
+    GLsizei count = (GLsizei)commands.size();
+    instanceData.resize(count * FLOATS_PER_INSTANCE);
+    GLfloat* out = instanceData.data();
+    for (const auto cmd : commands)
+    {
+        memcpy(out, cmd->_mv.m, 16 * sizeof(GLfloat));
+        out[16] = cmd->_displayColor.x;
+        out[17] = cmd->_displayColor.y;
+        out[18] = cmd->_displayColor.z;
+        out[19] = cmd->_displayColor.w;
+        out += FLOATS_PER_INSTANCE;
+    }
+    
+    // the instanced program binds the predefined attributes to the same locations, so the
+    // vertex layout the regular program state sets up is reused as is
+    first->preBatchDraw();
+    first->applyRenderState();
+    
+    auto glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_3D_POSITION_TEXTURE_INSTANCED);
+    glProgram->use();
+    glProgram->setUniformsForBuiltins(Mat4::IDENTITY);
+    const GLuint mvLocation = GLProgram::VERTEX_ATTRIB_INSTANCE_MV;
+    const GLuint colorLocation = GLProgram::VERTEX_ATTRIB_INSTANCE_COLOR;
+    
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * INSTANCE_STRIDE, instanceData.data(), GL_STREAM_DRAW);
+    for (int i = 0; i < 4; i++)
+    {
+        glEnableVertexAttribArray(mvLocation + i);
+        glVertexAttribPointer(mvLocation + i, 4, GL_FLOAT, GL_FALSE, INSTANCE_STRIDE, (GLvoid*)(i * 4 * sizeof(GLfloat)));
+        glVertexAttribDivisorARB(mvLocation + i, 1);
+    }
+    glEnableVertexAttribArray(colorLocation);
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, INSTANCE_STRIDE, (GLvoid*)(16 * sizeof(GLfloat)));
+    glVertexAttribDivisorARB(colorLocation, 1);
+    
+    glDrawElementsInstancedARB(first->_primitive, (GLsizei)first->_indexCount, first->_indexFormat, 0, count);
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, first->_indexCount * count);
+    
+    // leave no divisors behind, a VAO would keep them for the next non instanced draw
+    for (int i = 0; i < 4; i++)
+    {
+        glVertexAttribDivisorARB(mvLocation + i, 0);
+        glDisableVertexAttribArray(mvLocation + i);
+    }
+    glVertexAttribDivisorARB(colorLocation, 0);
+    glDisableVertexAttribArray(colorLocation);
+    
+    first->postBatchDraw();
+#else
+    // no instancing on this platform, same as the regular batch loop
+    commands.front()->preBatchDraw();
+    for (const auto cmd : commands)
+        cmd->batchDraw();
+    commands.front()->postBatchDraw();
+#endif
+}
+
 void MeshCommand::execute()
 {
     // set render state
@@ -26,6 +26,7 @@
 #define _CC_MESHCOMMAND_H_
 
 #include <unordered_map>
+#include <vector>
 #include "renderer/CCRenderCommand.h"
 #include "renderer/CCGLProgram.h"
 #include "math/CCMath.h"
@@ -71,6 +72,11 @@ public:
     void batchDraw();
     void postBatchDraw();
     
+    //whether the renderer may fold this command into an instanced draw with the commands of the same material next to it
+    bool isInstanceable() const { return _instanceable && !(_matrixPaletteSize && _matrixPalette); }
+    //draws a run of commands sharing one material with a single call, per command transform and color go into instanceBuffer
+    static void batchDrawInstanced(const std::vector<MeshCommand*>& commands, GLuint instanceBuffer, std::vector<GLfloat>& instanceData);
+    
     void genMaterialID(GLuint texID, void* glProgramState, GLuint vertexBuffer, GLuint indexBuffer, const BlendFunc& blend);
     
     uint32_t getMaterialID() const { return _materialID; }
@@ -109,6 +115,7 @@ protected:
     int   _matrixPaletteSize;
     
     uint32_t _materialID; //material ID
+    bool _instanceable; //the program has an instanced twin, decided with the material ID
     
     GLuint   _vao; //use vao if possible
     
@@ -25,6 +25,12 @@
 #include "renderer/CCRenderer.h"
 
 #include <algorithm>
+#if CC_USE_PARALLEL_VISIT
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 #include "renderer/CCTrianglesCommand.h"
 #include "renderer/CCQuadCommand.h"
@@ -35,6 +41,7 @@
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/ccGLStateCache.h"
 #include "renderer/CCMeshCommand.h"
+#include "renderer/CCUploadScheduler.h"
 #include "base/CCConfiguration.h"
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
@@ -42,13 +49,94 @@
 #include "base/CCEventType.h"
 #include "2d/CCCamera.h"
 #include "2d/CCScene.h"
+#include "3d/CCAABB.h"
+#include "base/CCProfiling.h"
 
 NS_CC_BEGIN
 
 // helper
-static bool compareRenderCommand(RenderCommand* a, RenderCommand* b)
+// below this many commands an insertion sort beats clearing and walking the histograms
+static const size_t RADIX_SORT_MIN_SIZE = 64;
+
+// maps a float to an unsigned int with the same order
+static inline uint32_t orderedFloatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static inline uint32_t commandMaterialID(RenderCommand* command)
+{
+    switch(command->getType())
+    {
+        case RenderCommand::Type::QUAD_COMMAND:
+            return static_cast<QuadCommand*>(command)->getMaterialID();
+        case RenderCommand::Type::TRIANGLES_COMMAND:
+            return static_cast<TrianglesCommand*>(command)->getMaterialID();
+        case RenderCommand::Type::MESH_COMMAND:
+            return static_cast<MeshCommand*>(command)->getMaterialID();
+        default:
+            return 0;
+    }
+}
+
+static inline RenderQueueEntry makeQueueEntry(RenderCommand* command, uint32_t depth)
 {
-    return a->getGlobalOrder() < b->getGlobalOrder();
+    RenderQueueEntry entry;
+    entry.key = (uint64_t)depth << 32
+              | (uint64_t)(commandMaterialID(command) & 0x0FFFFFFF) << 4
+              | ((uint64_t)command->getType() & 0xF);
+    entry.command = command;
+    return entry;
+}
+
+// stable sort by key, one counting pass per byte that is not the same in every key
+static void sortQueueEntries(std::vector<RenderQueueEntry>& entries, std::vector<RenderQueueEntry>& buffer)
+{
+    const size_t count = entries.size();
+    if(count < RADIX_SORT_MIN_SIZE)
+    {
+        for(size_t i = 1; i < count; i++)
+        {
+            RenderQueueEntry entry = entries[i];
+            size_t j = i;
+            for(; j > 0 && entries[j-1].key > entry.key; j--)
+                entries[j] = entries[j-1];
+            entries[j] = entry;
+        }
+        return;
+    }
+
+    size_t histograms[8][256] = {};
+    for(const auto& entry : entries)
+    {
+        for(int pass = 0; pass < 8; pass++)
+            histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+    }
+
+    buffer.resize(count);
+    RenderQueueEntry* from = entries.data();
+    RenderQueueEntry* to = buffer.data();
+    for(int pass = 0; pass < 8; pass++)
+    {
+        size_t* histogram = histograms[pass];
+        const int shift = pass * 8;
+        if(histogram[(from[0].key >> shift) & 0xFF] == count)
+            continue;
+        size_t offset = 0;
+        for(int digit = 0; digit < 256; digit++)
+        {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for(size_t i = 0; i < count; i++)
+            to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+        std::swap(from, to);
+    }
+    if(from != entries.data())
+        entries.swap(buffer);
 }
 
 // queue
@@ -57,9 +145,9 @@ void RenderQueue::push_back(RenderCommand* command)
 {
     float z = command->getGlobalOrder();
     if(z < 0)
-        _queueNegZ.push_back(command);
+        _queueNegZ.push_back(makeQueueEntry(command, orderedFloatBits(z)));
     else if(z > 0)
-        _queuePosZ.push_back(command);
+        _queuePosZ.push_back(makeQueueEntry(command, orderedFloatBits(z)));
     else
         _queue0.push_back(command);
 }
@@ -72,14 +160,14 @@ ssize_t RenderQueue::size() const
 void RenderQueue::sort()
 {
     // Don't sort _queue0, it already comes sorted
-    std::sort(std::begin(_queueNegZ), std::end(_queueNegZ), compareRenderCommand);
-    std::sort(std::begin(_queuePosZ), std::end(_queuePosZ), compareRenderCommand);
+    sortQueueEntries(_queueNegZ, _sortBuffer);
+    sortQueueEntries(_queuePosZ, _sortBuffer);
 }
 
 RenderCommand* RenderQueue::operator[](ssize_t index) const
 {
     if(index < static_cast<ssize_t>(_queueNegZ.size()))
-        return _queueNegZ[index];
+        return _queueNegZ[index].command;
 
     index -= _queueNegZ.size();
 
@@ -89,7 +177,7 @@ RenderCommand* RenderQueue::operator[](ssize_t index) const
     index -= _queue0.size();
 
     if(index < static_cast<ssize_t>(_queuePosZ.size()))
-        return _queuePosZ[index];
+        return _queuePosZ[index].command;
 
     CCASSERT(false, "invalid index");
     return nullptr;
@@ -102,25 +190,20 @@ void RenderQueue::clear()
     _queuePosZ.clear();
 }
 
-// helper
-static bool compareTransparentRenderCommand(RenderCommand* a, RenderCommand* b)
-{
-    return a->getGlobalOrder() > b->getGlobalOrder();
-}
-
 void TransparentRenderQueue::push_back(RenderCommand* command)
 {
-    _queueCmd.push_back(command);
+    // back to front, the farthest command gets the smallest key
+    _queueCmd.push_back(makeQueueEntry(command, ~orderedFloatBits(command->getGlobalOrder())));
 }
 
 void TransparentRenderQueue::sort()
 {
-    std::sort(std::begin(_queueCmd), std::end(_queueCmd), compareTransparentRenderCommand);
+    sortQueueEntries(_queueCmd, _sortBuffer);
 }
 
 RenderCommand* TransparentRenderQueue::operator[](ssize_t index) const
 {
-    return _queueCmd[index];
+    return _queueCmd[index].command;
 }
 
 void TransparentRenderQueue::clear()
@@ -128,6 +211,116 @@ void TransparentRenderQueue::clear()
     _queueCmd.clear();
 }
 
+//
+// parallel visit
+//
+#if CC_USE_PARALLEL_VISIT
+static thread_local RenderCommandBuffer* s_recording = nullptr;
+
+// threads that sleep until Renderer::recordInParallel hands them jobs
+class VisitThreadPool
+{
+public:
+    explicit VisitThreadPool(int count)
+    : _job(nullptr)
+    , _jobCount(0)
+    , _next(0)
+    , _finished(0)
+    , _busy(0)
+    , _generation(0)
+    , _quit(false)
+    {
+        for (int i = 0; i < count; ++i)
+            _threads.push_back(std::thread(&VisitThreadPool::work, this));
+    }
+
+    ~VisitThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+        }
+        _wake.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    // the calling thread takes jobs too
+    void run(int count, const std::function<void(int)>& job)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        // a thread still leaving the last run could take a job of this one with the old function
+        _done.wait(lock, [this](){ return _busy == 0; });
+        _job = &job;
+        _jobCount = count;
+        _next = 0;
+        _finished = 0;
+        ++_generation;
+        lock.unlock();
+        _wake.notify_all();
+
+        int finished = take(job, count);
+
+        lock.lock();
+        _finished += finished;
+        _done.wait(lock, [this](){ return _finished == _jobCount && _busy == 0; });
+        _job = nullptr;
+    }
+
+private:
+    int take(const std::function<void(int)>& job, int count)
+    {
+        int finished = 0;
+        for (int i = _next++; i < count; i = _next++)
+        {
+            job(i);
+            ++finished;
+        }
+        return finished;
+    }
+
+    void work()
+    {
+        unsigned int generation = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _wake.wait(lock, [&](){ return _quit || _generation != generation; });
+            if (_quit)
+                return;
+            generation = _generation;
+            if (!_job)
+                continue;
+            auto job = _job;
+            int count = _jobCount;
+            ++_busy;
+            lock.unlock();
+
+            int finished = take(*job, count);
+
+            lock.lock();
+            --_busy;
+            _finished += finished;
+            _done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(int)>* _job;
+    int _jobCount;
+    std::atomic<int> _next;
+    int _finished;
+    int _busy;
+    unsigned int _generation;
+    bool _quit;
+};
+#else
+static RenderCommandBuffer* s_recording = nullptr;
+#endif
+
 //
 //
 //
@@ -139,11 +332,17 @@ static const int DEFAULT_RENDER_QUEUE = 0;
 Renderer::Renderer()
 :_lastMaterialID(0)
 ,_lastBatchedMeshCommand(nullptr)
+,_instanceVBO(0)
+,_instancingEnabled(true)
 ,_filledVertex(0)
 ,_filledIndex(0)
 ,_numberQuads(0)
 ,_glViewAssigned(false)
+,_culledObjects(0)
+,_visibleObjects(0)
 ,_isRendering(false)
+,_visitThreads(nullptr)
+,_visitThreadCount(0)
 #if CC_ENABLE_CACHE_TEXTURE_DATA
 ,_cacheTextureListener(nullptr)
 #endif
@@ -155,15 +354,23 @@ Renderer::Renderer()
     RenderQueue defaultRenderQueue;
     _renderGroups.push_back(defaultRenderQueue);
     _batchedCommands.reserve(BATCH_QUADCOMMAND_RESEVER_SIZE);
+    
+#if CC_USE_PARALLEL_VISIT
+    // the calling thread is one of the cores, more than 7 helpers hardly pays for the merge
+    _visitThreadCount = std::min(std::max((int)std::thread::hardware_concurrency() - 1, 0), 7);
+#endif
 }
 
 Renderer::~Renderer()
 {
+    setVisitThreads(0);
     _renderGroups.clear();
     _groupCommandManager->release();
     
     glDeleteBuffers(2, _buffersVBO);
     glDeleteBuffers(2, _quadbuffersVBO);
+    if (_instanceVBO)
+        glDeleteBuffers(1, &_instanceVBO);
     
     if (Configuration::getInstance()->supportsShareableVAO())
     {
@@ -312,12 +519,22 @@ void Renderer::mapBuffers()
 
 void Renderer::addCommand(RenderCommand* command)
 {
+    if (s_recording)
+    {
+        s_recording->entries.push_back({command, -1});
+        return;
+    }
     int renderQueue =_commandGroupStack.top();
     addCommand(command, renderQueue);
 }
 
 void Renderer::addCommand(RenderCommand* command, int renderQueue)
 {
+    if (s_recording)
+    {
+        s_recording->entries.push_back({command, renderQueue});
+        return;
+    }
     CCASSERT(!_isRendering, "Cannot add command while rendering");
     CCASSERT(renderQueue >=0, "Invalid render queue");
     CCASSERT(command->getType() != RenderCommand::Type::UNKNOWN_COMMAND, "Invalid Command Type");
@@ -330,22 +547,113 @@ void Renderer::addCommand(RenderCommand* command, int renderQueue)
 void Renderer::pushGroup(int renderQueueID)
 {
     CCASSERT(!_isRendering, "Cannot change render queue while rendering");
+    CCASSERT(!s_recording, "Cannot change render queue in a parallel visit");
     _commandGroupStack.push(renderQueueID);
 }
 
 void Renderer::popGroup()
 {
     CCASSERT(!_isRendering, "Cannot change render queue while rendering");
+    CCASSERT(!s_recording, "Cannot change render queue in a parallel visit");
     _commandGroupStack.pop();
 }
 
 int Renderer::createRenderQueue()
 {
+    CCASSERT(!s_recording, "Cannot create render queue in a parallel visit");
     RenderQueue newRenderQueue;
     _renderGroups.push_back(newRenderQueue);
     return (int)_renderGroups.size() - 1;
 }
 
+void Renderer::recordInParallel(int count, const std::function<void(int)>& job)
+{
+    if (s_recording)
+    {
+        for (int i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+    if ((int)_recorded.size() < count)
+        _recorded.resize(count);
+    for (int i = 0; i < count; ++i)
+        _recorded[i].clear();
+    
+    auto record = [this, &job](int i){
+        s_recording = &_recorded[i];
+        job(i);
+        s_recording = nullptr;
+    };
+#if CC_USE_PARALLEL_VISIT
+    if (count > 1 && _visitThreadCount > 0)
+    {
+        if (!_visitThreads)
+            _visitThreads = new (std::nothrow) VisitThreadPool(_visitThreadCount);
+        _visitThreads->run(count, record);
+        return;
+    }
+#endif
+    for (int i = 0; i < count; ++i)
+        record(i);
+}
+
+void Renderer::replayRecorded(int job)
+{
+    CCASSERT(!s_recording, "Cannot replay in a parallel visit");
+    auto& buffer = _recorded[job];
+    size_t call = 0;
+    for (const auto& entry : buffer.entries)
+    {
+        if (!entry.command)
+            buffer.calls[call++]();
+        else if (entry.renderQueue < 0)
+            addCommand(entry.command);
+        else
+            addCommand(entry.command, entry.renderQueue);
+    }
+    _culledObjects += buffer.culled;
+    _visibleObjects += buffer.visible;
+}
+
+void Renderer::runInVisitOrder(const std::function<void()>& call)
+{
+    if (s_recording)
+    {
+        s_recording->entries.push_back({nullptr, -1});
+        s_recording->calls.push_back(call);
+    }
+    else
+    {
+        call();
+    }
+}
+
+void Renderer::addCullResult(bool visible)
+{
+    if (s_recording)
+        (visible ? s_recording->visible : s_recording->culled)++;
+    else
+        (visible ? _visibleObjects : _culledObjects)++;
+}
+
+bool Renderer::isRecording()
+{
+    return s_recording != nullptr;
+}
+
+void Renderer::setVisitThreads(int count)
+{
+#if CC_USE_PARALLEL_VISIT
+    CCASSERT(!s_recording, "Cannot change the visit threads in a parallel visit");
+    count = std::max(count, 0);
+    if (count == _visitThreadCount)
+        return;
+    delete _visitThreads;
+    _visitThreads = nullptr;
+    _visitThreadCount = count;
+#endif
+}
+
 void Renderer::visitRenderQueue(const RenderQueue& queue)
 {
     ssize_t size = queue.size();
@@ -431,10 +739,22 @@ void Renderer::visitRenderQueue(const RenderQueue& queue)
             if (_lastBatchedMeshCommand == nullptr || _lastBatchedMeshCommand->getMaterialID() != cmd->getMaterialID())
             {
                 flush3D();
-                cmd->preBatchDraw();
-                cmd->batchDraw();
+                if (_instancingEnabled && cmd->isInstanceable())
+                {
+                    //drawn by flush3D once the run of commands with this material ends
+                    _instancedMeshCommands.push_back(cmd);
+                }
+                else
+                {
+                    cmd->preBatchDraw();
+                    cmd->batchDraw();
+                }
                 _lastBatchedMeshCommand = cmd;
             }
+            else if (!_instancedMeshCommands.empty())
+            {
+                _instancedMeshCommands.push_back(cmd);
+            }
             else
             {
                 cmd->batchDraw();
@@ -513,9 +833,13 @@ void Renderer::render()
 
     //TODO: setup camera or MVP
     _isRendering = true;
+    CC_PROFILER_START("Renderer - render");
     
     if (_glViewAssigned)
     {
+        // glyphs the labels added to their atlases while they were visited
+        Director::getInstance()->getUploadScheduler()->flush(UploadScheduler::Type::FONT_ATLAS);
+
         //Process render commands
         //1. Sort render commands based on ID
         for (auto &renderqueue : _renderGroups)
@@ -536,6 +860,7 @@ void Renderer::render()
         }
     }
     clean();
+    CC_PROFILER_STOP("Renderer - render");
     _isRendering = false;
 }
 
@@ -560,6 +885,7 @@ void Renderer::clean()
     _numberQuads = 0;
     _lastMaterialID = 0;
     _lastBatchedMeshCommand = nullptr;
+    _instancedMeshCommands.clear();
     
     _transparentRenderGroups.clear();
 }
@@ -834,46 +1160,43 @@ void Renderer::flush3D()
 {
     if (_lastBatchedMeshCommand)
     {
-        _lastBatchedMeshCommand->postBatchDraw();
+        if (!_instancedMeshCommands.empty())
+            drawInstancedMeshes();
+        else
+            _lastBatchedMeshCommand->postBatchDraw();
         _lastBatchedMeshCommand = nullptr;
     }
 }
 
+void Renderer::drawInstancedMeshes()
+{
+    if (_instancedMeshCommands.size() == 1)
+    {
+        auto cmd = _instancedMeshCommands.front();
+        cmd->preBatchDraw();
+        cmd->batchDraw();
+        cmd->postBatchDraw();
+    }
+    else
+    {
+        if (!_instanceVBO)
+            glGenBuffers(1, &_instanceVBO);
+        MeshCommand::batchDrawInstanced(_instancedMeshCommands, _instanceVBO, _instanceData);
+    }
+    _instancedMeshCommands.clear();
+}
+
 // helpers
 
 bool Renderer::checkVisibility(const Mat4 &transform, const Size &size)
 {
-    auto scene = Director::getInstance()->getRunningScene();
-    // only cull the default camera. The culling algorithm is valid for default camera.
-    if (scene && scene->_defaultCamera != Camera::getVisitingCamera())
+    auto camera = Camera::getVisitingCamera();
+    if (!camera)
         return true;
-    
-    // half size of the screen
-    Size screen_half = Director::getInstance()->getWinSize();
-    screen_half.width /= 2;
-    screen_half.height /= 2;
-
-    float hSizeX = size.width/2;
-    float hSizeY = size.height/2;
-
-    Vec4 v4world, v4local;
-    v4local.set(hSizeX, hSizeY, 0, 1);
-    transform.transformVector(v4local, &v4world);
-
-    // center of screen is (0,0)
-    v4world.x -= screen_half.width;
-    v4world.y -= screen_half.height;
-
-    // convert content size to world coordinates
-    float wshw = std::max(fabsf(hSizeX * transform.m[0] + hSizeY * transform.m[4]), fabsf(hSizeX * transform.m[0] - hSizeY * transform.m[4]));
-    float wshh = std::max(fabsf(hSizeX * transform.m[1] + hSizeY * transform.m[5]), fabsf(hSizeX * transform.m[1] - hSizeY * transform.m[5]));
-
-    // compare if it in the positive quadrant of the screen
-    float tmpx = (fabsf(v4world.x)-wshw);
-    float tmpy = (fabsf(v4world.y)-wshh);
-    bool ret = (tmpx < screen_half.width && tmpy < screen_half.height);
 
-    return ret;
+    // the quad as a flat box in node space, tested against the camera frustum
+    AABB box(Vec3::ZERO, Vec3(size.width, size.height, 0));
+    return camera->isVisibleInFrustum(box, transform);
 }
 
 NS_CC_END
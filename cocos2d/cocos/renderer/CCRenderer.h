@@ -28,6 +28,7 @@
 
 #include <vector>
 #include <stack>
+#include <functional>
 
 #include "platform/CCPlatformMacros.h"
 #include "renderer/CCRenderCommand.h"
@@ -41,10 +42,22 @@ class QuadCommand;
 class TrianglesCommand;
 class MeshCommand;
 
+/** A `RenderCommand` together with the key it is sorted by.
+ The key is built when the command is queued: the global order in the high 32 bits,
+ then the low 28 bits of the material ID and the command type in the low 4 bits,
+ so commands with the same z end up grouped by material and can be batched.
+ */
+struct RenderQueueEntry
+{
+    uint64_t key;
+    RenderCommand* command;
+};
+
 /** Class that knows how to sort `RenderCommand` objects.
  Since the commands that have `z == 0` are "pushed back" in
  the correct order, the only `RenderCommand` objects that need to be sorted,
  are the ones that have `z < 0` and `z > 0`.
+ They are sorted by their `RenderQueueEntry` key with a stable LSD radix sort.
 */
 class RenderQueue {
 
@@ -56,9 +69,10 @@ public:
     void clear();
 
 protected:
-    std::vector<RenderCommand*> _queueNegZ;
+    std::vector<RenderQueueEntry> _queueNegZ;
     std::vector<RenderCommand*> _queue0;
-    std::vector<RenderCommand*> _queuePosZ;
+    std::vector<RenderQueueEntry> _queuePosZ;
+    std::vector<RenderQueueEntry> _sortBuffer;
 };
 
 //render queue for transparency object, NOTE that the _globalOrder of RenderCommand is the distance to the camera when added to the transparent queue
@@ -74,7 +88,8 @@ public:
     void clear();
     
 protected:
-    std::vector<RenderCommand*> _queueCmd;
+    std::vector<RenderQueueEntry> _queueCmd;
+    std::vector<RenderQueueEntry> _sortBuffer;
 };
 
 struct RenderStackElement
@@ -84,6 +99,23 @@ struct RenderStackElement
 };
 
 class GroupCommandManager;
+class VisitThreadPool;
+
+/** Commands and calls recorded by one job of a parallel visit, see Renderer::recordInParallel */
+struct RenderCommandBuffer
+{
+    struct Entry
+    {
+        RenderCommand* command; //nullptr for the next deferred call
+        int renderQueue; //-1 is the group on top when replayed
+    };
+    std::vector<Entry> entries;
+    std::vector<std::function<void()>> calls;
+    ssize_t culled;
+    ssize_t visible;
+    RenderCommandBuffer() : culled(0), visible(0) {}
+    void clear() { entries.clear(); calls.clear(); culled = visible = 0; }
+};
 
 /* Class responsible for the rendering in.
 
@@ -133,14 +165,43 @@ public:
     ssize_t getDrawnVertices() const { return _drawnVertices; }
     /* RenderCommands (except) QuadCommand should update this value */
     void addDrawnVertices(ssize_t number) { _drawnVertices += number; };
+    /* returns the number of objects culled by checkVisibility in the last frame */
+    ssize_t getCulledObjects() const { return _culledObjects; }
+    /* returns the number of objects that passed the culling test in the last frame */
+    ssize_t getVisibleObjects() const { return _visibleObjects; }
+    /* counts a culling result, draw() methods that cull on their own should report here. Safe from the visit threads */
+    void addCullResult(bool visible);
     /* clear draw stats */
-    void clearDrawStats() { _drawnBatches = _drawnVertices = 0; }
+    void clearDrawStats() { _drawnBatches = _drawnVertices = _culledObjects = _visibleObjects = 0; }
 
     inline GroupCommandManager* getGroupCommandManager() const { return _groupCommandManager; };
 
-    /** returns whether or not a rectangle is visible or not */
+    /** returns whether or not a rectangle is visible by the visiting camera. Only tests, does not count the result */
     bool checkVisibility(const Mat4& transform, const Size& size);
 
+    /** Runs job(0) to job(count-1) on the visit threads and the calling thread, and returns when all are done.
+     The commands a job adds are recorded into its own buffer instead of the render queues, replayRecorded(job) queues them.
+     Jobs must not push groups or create render queues. Nested calls from a job run serially.
+     */
+    void recordInParallel(int count, const std::function<void(int)>& job);
+
+    /** Queues what the job recorded, in the order it was recorded */
+    void replayRecorded(int job);
+
+    /** Runs `call` now, or when the recording it is called from is replayed. Lets draw() feed shared state, like a batch, in visit order */
+    void runInVisitOrder(const std::function<void()>& call);
+
+    /** returns whether the calling thread is recording a job of recordInParallel */
+    static bool isRecording();
+
+    /** Sets the number of threads helping the calling thread in recordInParallel, 0 runs the jobs serially */
+    void setVisitThreads(int count);
+    int getVisitThreads() const { return _visitThreadCount; }
+
+    /** Sets whether runs of instanceable MeshCommands are drawn with one instanced call. On by default, off draws them one by one */
+    void setInstancingEnabled(bool enabled) { _instancingEnabled = enabled; }
+    bool isInstancingEnabled() const { return _instancingEnabled; }
+
 protected:
 
     //Setup VBO or VAO based on OpenGL extensions
@@ -158,6 +219,8 @@ protected:
     
     void flush3D();
     
+    void drawInstancedMeshes();
+    
     void visitRenderQueue(const RenderQueue& queue);
     
     void visitTransparentRenderQueue(const TransparentRenderQueue& queue);
@@ -173,6 +236,10 @@ protected:
     uint32_t _lastMaterialID;
 
     MeshCommand*              _lastBatchedMeshCommand;
+    std::vector<MeshCommand*> _instancedMeshCommands; //run of instanceable commands sharing a material, drawn by flush3D
+    std::vector<GLfloat>      _instanceData;
+    GLuint                    _instanceVBO;
+    bool                      _instancingEnabled;
     std::vector<TrianglesCommand*> _batchedCommands;
     std::vector<QuadCommand*> _batchQuadCommands;
     
@@ -198,11 +265,17 @@ protected:
     // stats
     ssize_t _drawnBatches;
     ssize_t _drawnVertices;
+    ssize_t _culledObjects;
+    ssize_t _visibleObjects;
     //the flag for checking whether renderer is rendering
     bool _isRendering;
     
     GroupCommandManager* _groupCommandManager;
     
+    std::vector<RenderCommandBuffer> _recorded; //one per job of the last recordInParallel
+    VisitThreadPool* _visitThreads;
+    int _visitThreadCount;
+    
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     EventListenerCustom* _cacheTextureListener;
 #endif
@@ -31,8 +31,10 @@ THE SOFTWARE.
 #include <stack>
 #include <cctype>
 #include <list>
+#include <algorithm>
 
 #include "renderer/CCTexture2D.h"
+#include "renderer/CCUploadScheduler.h"
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
 #include "base/CCScheduler.h"
@@ -59,12 +61,12 @@ TextureCache * TextureCache::getInstance()
 }
 
 TextureCache::TextureCache()
-: _loadingThread(nullptr)
-, _asyncStructQueue(nullptr)
-, _imageInfoQueue(nullptr)
-, _needQuit(false)
-, _asyncRefCount(0)
+: _needQuit(false)
+, _asyncSequence(0)
 {
+    // the cocos thread keeps a core
+    _asyncThreadCount = (int)std::thread::hardware_concurrency() - 1;
+    _asyncThreadCount = std::max(1, std::min(_asyncThreadCount, 4));
 }
 
 TextureCache::~TextureCache()
@@ -74,7 +76,12 @@ TextureCache::~TextureCache()
     for( auto it=_textures.begin(); it!=_textures.end(); ++it)
         (it->second)->release();
 
-    CC_SAFE_DELETE(_loadingThread);
+    waitForQuit();
+    for (auto& load : _asyncLoads)
+    {
+        CC_SAFE_RELEASE(load.second->image);
+        delete load.second;
+    }
 }
 
 void TextureCache::destroyInstance()
@@ -96,6 +103,11 @@ std::string TextureCache::getDescription() const
 }
 
 void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback)
+{
+    addImageAsync(path, callback, 0);
+}
+
+void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, int priority)
 {
     Texture2D *texture = nullptr;
 
@@ -111,205 +123,146 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
         return;
     }
 
-    // lazy init
-    if (_asyncStructQueue == nullptr)
-    {             
-        _asyncStructQueue = new queue<AsyncStruct*>();
-        _imageInfoQueue   = new deque<ImageInfo*>();        
-
-        // create a new thread to load images
-        _loadingThread = new std::thread(&TextureCache::loadImage, this);
+    auto found = _asyncLoads.find(fullpath);
+    if (found != _asyncLoads.end())
+    {
+        auto load = found->second;
+        load->callbacks.push_back(callback);
 
-        _needQuit = false;
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        if (load->queued && priority > load->priority)
+        {
+            load->priority = priority;
+            std::make_heap(_asyncQueue.begin(), _asyncQueue.end(), asyncLess);
+        }
+        return;
     }
 
-    if (0 == _asyncRefCount)
+    if (_loadingThreads.empty())
     {
-        Director::getInstance()->getScheduler()->schedule(CC_SCHEDULE_SELECTOR(TextureCache::addImageAsyncCallBack), this, 0, false);
+        _needQuit = false;
+        auto uploads = Director::getInstance()->getUploadScheduler();
+        for (int i = 0; i < _asyncThreadCount; ++i)
+        {
+            _loadingThreads.push_back(std::thread(&TextureCache::loadImage, this, uploads));
+        }
     }
 
-    ++_asyncRefCount;
+    AsyncStruct *data = new (std::nothrow) AsyncStruct(fullpath, priority, _asyncSequence++);
+    data->callbacks.push_back(callback);
+    _asyncLoads[fullpath] = data;
 
-    // generate async struct
-    AsyncStruct *data = new (std::nothrow) AsyncStruct(fullpath, callback);
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        _asyncQueue.push_back(data);
+        std::push_heap(_asyncQueue.begin(), _asyncQueue.end(), asyncLess);
+    }
+    _asyncSleep.notify_one();
+}
 
-    // add async struct into queue
-    _asyncStructQueueMutex.lock();
-    _asyncStructQueue->push(data);
-    _asyncStructQueueMutex.unlock();
+void TextureCache::setAsyncThreadCount(int count)
+{
+    CCASSERT(_loadingThreads.empty(), "the loading threads have already started");
+    _asyncThreadCount = std::max(1, count);
+}
 
-    _sleepCondition.notify_one();
+bool TextureCache::asyncLess(const AsyncStruct* a, const AsyncStruct* b)
+{
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+    return a->sequence > b->sequence;
 }
 
 void TextureCache::unbindImageAsync(const std::string& filename)
 {
-    _imageInfoMutex.lock();
-    if (_imageInfoQueue && !_imageInfoQueue->empty())
+    std::string fullpath = FileUtils::getInstance()->fullPathForFilename(filename);
+    auto found = _asyncLoads.find(fullpath);
+    if (found != _asyncLoads.end())
     {
-        std::string fullpath = FileUtils::getInstance()->fullPathForFilename(filename);
-        auto found = std::find_if(_imageInfoQueue->begin(), _imageInfoQueue->end(), [&fullpath](ImageInfo* ptr)->bool{ return ptr->asyncStruct->filename == fullpath; });
-        if (found != _imageInfoQueue->end())
-        {
-            (*found)->asyncStruct->callback = nullptr;
-        }
+        found->second->callbacks.clear();
     }
-    _imageInfoMutex.unlock();
 }
 
 void TextureCache::unbindAllImageAsync()
 {
-    _imageInfoMutex.lock();
-    if (_imageInfoQueue && !_imageInfoQueue->empty())
+    for (auto& load : _asyncLoads)
     {
-        std::for_each(_imageInfoQueue->begin(), _imageInfoQueue->end(), [](ImageInfo* ptr) { ptr->asyncStruct->callback = nullptr; });
+        load.second->callbacks.clear();
     }
-    _imageInfoMutex.unlock();
 }
 
-void TextureCache::loadImage()
+void TextureCache::loadImage(UploadScheduler* uploads)
 {
-    AsyncStruct *asyncStruct = nullptr;
-
-    while (true)
+    for (;;)
     {
-        std::queue<AsyncStruct*> *pQueue = _asyncStructQueue;
-        _asyncStructQueueMutex.lock();
-        if (pQueue->empty())
+        AsyncStruct *asyncStruct = nullptr;
         {
-            _asyncStructQueueMutex.unlock();
-            if (_needQuit) {
-                break;
-            }
-            else {
-                std::unique_lock<std::mutex> lk(_sleepMutex);
-                _sleepCondition.wait(lk);
-                continue;
-            }
+            std::unique_lock<std::mutex> lock(_asyncMutex);
+            _asyncSleep.wait(lock, [this]{ return _needQuit || !_asyncQueue.empty(); });
+            if (_needQuit)
+                return;
+            std::pop_heap(_asyncQueue.begin(), _asyncQueue.end(), asyncLess);
+            asyncStruct = _asyncQueue.back();
+            _asyncQueue.pop_back();
+            asyncStruct->queued = false;
         }
-        else
-        {
-            asyncStruct = pQueue->front();
-            pQueue->pop();
-            _asyncStructQueueMutex.unlock();
-        }        
 
-        Image *image = nullptr;
-        bool generateImage = false;
-
-        auto it = _textures.find(asyncStruct->filename);
-        if( it == _textures.end() )
+        const std::string& filename = asyncStruct->filename;
+        Image *image = new (std::nothrow) Image();
+        if (image && !image->initWithImageFileThreadSafe(filename))
         {
-           _imageInfoMutex.lock();
-           ImageInfo *imageInfo;
-           size_t pos = 0;
-           size_t infoSize = _imageInfoQueue->size();
-           for (; pos < infoSize; pos++)
-           {
-               imageInfo = (*_imageInfoQueue)[pos];
-               if(imageInfo->asyncStruct->filename.compare(asyncStruct->filename) == 0)
-                   break;
-           }
-           _imageInfoMutex.unlock();
-           if(infoSize == 0 || pos == infoSize)
-               generateImage = true;
+            CC_SAFE_RELEASE_NULL(image);
+            CCLOG("can not load %s", filename.c_str());
         }
+        asyncStruct->image = image;
 
-        if (generateImage)
-        {
-            const std::string& filename = asyncStruct->filename;
-            // generate image      
-            image = new (std::nothrow) Image();
-            if (image && !image->initWithImageFileThreadSafe(filename))
-            {
-                CC_SAFE_RELEASE(image);
-                CCLOG("can not load %s", filename.c_str());
-                continue;
-            }
-        }    
-
-        // generate image info
-        ImageInfo *imageInfo = new (std::nothrow) ImageInfo();
-        imageInfo->asyncStruct = asyncStruct;
-        imageInfo->image = image;
-
-        // put the image info into the queue
-        _imageInfoMutex.lock();
-        _imageInfoQueue->push_back(imageInfo);
-        _imageInfoMutex.unlock();
-    }
-    
-	if(_asyncStructQueue != nullptr)
-    {
-        delete _asyncStructQueue;
-	    _asyncStructQueue = nullptr;
-        delete _imageInfoQueue;
-	    _imageInfoQueue = nullptr;
+        uploads->schedule(UploadScheduler::Type::TEXTURE, image ? image->getDataLen() : 0, this, [this, asyncStruct](){
+            uploadImageAsync(asyncStruct);
+        });
     }
 }
 
-void TextureCache::addImageAsyncCallBack(float dt)
+void TextureCache::uploadImageAsync(AsyncStruct* asyncStruct)
 {
-    // the image is generated in loading thread
-    std::deque<ImageInfo*> *imagesQueue = _imageInfoQueue;
+    _asyncLoads.erase(asyncStruct->filename);
+
+    Image *image = asyncStruct->image;
+    const std::string& filename = asyncStruct->filename;
 
-    _imageInfoMutex.lock();
-    if (imagesQueue->empty())
+    // addImage may have loaded it in the meantime
+    Texture2D *texture = nullptr;
+    auto it = _textures.find(filename);
+    if (it != _textures.end())
     {
-        _imageInfoMutex.unlock();
+        texture = it->second;
     }
-    else
+    else if (image)
     {
-        ImageInfo *imageInfo = imagesQueue->front();
-        imagesQueue->pop_front();
-        _imageInfoMutex.unlock();
-
-        AsyncStruct *asyncStruct = imageInfo->asyncStruct;
-        Image *image = imageInfo->image;
-
-        const std::string& filename = asyncStruct->filename;
-
-        Texture2D *texture = nullptr;
-        if (image)
-        {
-            // generate texture in render thread
-            texture = new (std::nothrow) Texture2D();
+        // generate texture in render thread
+        texture = new (std::nothrow) Texture2D();
 
-            texture->initWithImage(image);
+        texture->initWithImage(image);
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-            // cache the texture file name
-            VolatileTextureMgr::addImageTexture(texture, filename);
+        // cache the texture file name
+        VolatileTextureMgr::addImageTexture(texture, filename);
 #endif
-            // cache the texture. retain it, since it is added in the map
-            _textures.insert( std::make_pair(filename, texture) );
-            texture->retain();
+        // cache the texture. retain it, since it is added in the map
+        _textures.insert( std::make_pair(filename, texture) );
+        texture->retain();
 
-            texture->autorelease();
-        }
-        else
-        {
-            auto it = _textures.find(asyncStruct->filename);
-            if(it != _textures.end())
-                texture = it->second;
-        }
-        
-        if (asyncStruct->callback)
-        {
-            asyncStruct->callback(texture);
-        }
-        
-        if(image)
-        {
-            image->release();
-        }       
-        delete asyncStruct;
-        delete imageInfo;
+        texture->autorelease();
+    }
 
-        --_asyncRefCount;
-        if (0 == _asyncRefCount)
-        {
-            Director::getInstance()->getScheduler()->unschedule(CC_SCHEDULE_SELECTOR(TextureCache::addImageAsyncCallBack), this);
-        }
+    // a callback may unbind or add images, so they are moved out of the load first
+    auto callbacks = std::move(asyncStruct->callbacks);
+    CC_SAFE_RELEASE(image);
+    delete asyncStruct;
+
+    for (const auto& callback : callbacks)
+    {
+        if (callback)
+            callback(texture);
     }
 }
 
@@ -526,10 +479,23 @@ void TextureCache::reloadAllTextures()
 
 void TextureCache::waitForQuit()
 {
-    // notify sub thread to quick
-    _needQuit = true;
-    _sleepCondition.notify_one();
-    if (_loadingThread) _loadingThread->join();
+    // notify the loading threads to quit
+    {
+        std::lock_guard<std::mutex> lock(_asyncMutex);
+        _needQuit = true;
+    }
+    _asyncSleep.notify_all();
+    for (auto& thread : _loadingThreads)
+    {
+        thread.join();
+    }
+
+    // the decoded images waiting for their upload stay in _asyncLoads for the destructor
+    if (!_loadingThreads.empty())
+    {
+        Director::getInstance()->getUploadScheduler()->cancel(this);
+        _loadingThreads.clear();
+    }
 }
 
 std::string TextureCache::getCachedTextureInfo() const
@@ -32,9 +32,9 @@ THE SOFTWARE.
 #include <mutex>
 #include <thread>
 #include <condition_variable>
-#include <queue>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <functional>
 
 #include "base/CCRef.h"
@@ -48,6 +48,8 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+class UploadScheduler;
+
 /**
  * @addtogroup textures
  * @{
@@ -114,10 +116,24 @@ public:
     * If the file image was not previously loaded, it will create a new Texture2D object and it will return it.
     * Otherwise it will load a texture in a new thread, and when the image is loaded, the callback will be called with the Texture2D as a parameter.
     * The callback will be called from the main thread, so it is safe to create any cocos2d object from the callback.
+    * The decoded image is uploaded by the Director's UploadScheduler, within its per frame budget.
     * Supported image extensions: .png, .jpg
     * @since v0.8
     */
     virtual void addImageAsync(const std::string &filepath, const std::function<void(Texture2D*)>& callback);
+
+    /* Same as addImageAsync, images with a higher priority are decoded first, equal priorities in the order they were added.
+    * Requests for an image that is already loading share its decode, their callbacks are called in order once it is uploaded,
+    * and a higher priority moves the image forward if no worker has taken it yet.
+    * If the image can not be loaded the callbacks get nullptr.
+    */
+    void addImageAsync(const std::string &filepath, const std::function<void(Texture2D*)>& callback, int priority);
+
+    /** number of threads decoding images for addImageAsync, defaults to one less than the number of cores, between 1 and 4.
+    * The threads start with the first addImageAsync, so it has to be set before that
+    */
+    void setAsyncThreadCount(int count);
+    int getAsyncThreadCount() const { return _asyncThreadCount; }
     
     /* Unbind a specified bound image asynchronous callback
      * In the case an object who was bound to an image asynchronous callback was destroyed before the callback is invoked,
@@ -189,41 +205,38 @@ public:
     //called by director, please do not called outside
     void waitForQuit();
 
-private:
-    void addImageAsyncCallBack(float dt);
-    void loadImage();
-
 public:
     struct AsyncStruct
     {
     public:
-        AsyncStruct(const std::string& fn, std::function<void(Texture2D*)> f) : filename(fn), callback(f) {}
+        AsyncStruct(const std::string& fn, int p, unsigned int s) : filename(fn), priority(p), sequence(s), queued(true), image(nullptr) {}
 
         std::string filename;
-        std::function<void(Texture2D*)> callback;
+        std::vector<std::function<void(Texture2D*)>> callbacks;  //every request for filename, cocos thread only
+        int priority;           //guarded by _asyncMutex while queued
+        unsigned int sequence;
+        bool queued;            //waiting for a worker, guarded by _asyncMutex
+        Image* image;           //decoded image, nullptr if it failed to load
     };
 
 protected:
-    typedef struct _ImageInfo
-    {
-        AsyncStruct *asyncStruct;
-        Image        *image;
-    } ImageInfo;
-    
-    std::thread* _loadingThread;
-
-    std::queue<AsyncStruct*>* _asyncStructQueue;
-    std::deque<ImageInfo*>* _imageInfoQueue;
-
-    std::mutex _asyncStructQueueMutex;
-    std::mutex _imageInfoMutex;
-
-    std::mutex _sleepMutex;
-    std::condition_variable _sleepCondition;
-
-    bool _needQuit;
-
-    int _asyncRefCount;
+    /**heap order of _asyncQueue, the top is the highest priority, then the oldest*/
+    static bool asyncLess(const AsyncStruct* a, const AsyncStruct* b);
+    /**loading thread loop, decodes images and schedules their upload on uploads*/
+    void loadImage(UploadScheduler* uploads);
+    /**upload job of a decoded image, creates the texture and calls back*/
+    void uploadImageAsync(AsyncStruct* asyncStruct);
+
+    std::vector<std::thread> _loadingThreads;
+
+    std::mutex _asyncMutex;
+    std::condition_variable _asyncSleep;
+    std::vector<AsyncStruct*> _asyncQueue;      //heap of loads waiting for a worker, guarded by _asyncMutex
+    bool _needQuit;                             //guarded by _asyncMutex
+
+    std::unordered_map<std::string, AsyncStruct*> _asyncLoads;  //everything in flight by full path, cocos thread only
+    unsigned int _asyncSequence;
+    int _asyncThreadCount;
 
     std::unordered_map<std::string, Texture2D*> _textures;
 };
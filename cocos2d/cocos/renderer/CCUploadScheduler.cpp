@@ -0,0 +1,143 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "renderer/CCUploadScheduler.h"
+
+#include <algorithm>
+
+NS_CC_BEGIN
+
+UploadScheduler::UploadScheduler()
+: _timeBudget(4)
+, _byteBudget(4 * 1024 * 1024)
+, _frameBytes(0)
+, _frameTime(0)
+{
+}
+
+UploadScheduler::~UploadScheduler()
+{
+}
+
+void UploadScheduler::schedule(Type type, ssize_t bytes, void* owner, const std::function<void()>& job)
+{
+    Job entry;
+    entry.type = type;
+    entry.bytes = bytes;
+    entry.owner = owner;
+    entry.scheduled = std::chrono::steady_clock::now();
+    entry.run = job;
+
+    std::lock_guard<std::mutex> lock(_incomingMutex);
+    _incoming.push_back(std::move(entry));
+}
+
+void UploadScheduler::cancel(void* owner)
+{
+    auto owned = [owner](const Job& job){ return job.owner == owner; };
+    _jobs.erase(std::remove_if(_jobs.begin(), _jobs.end(), owned), _jobs.end());
+
+    std::lock_guard<std::mutex> lock(_incomingMutex);
+    _incoming.erase(std::remove_if(_incoming.begin(), _incoming.end(), owned), _incoming.end());
+}
+
+void UploadScheduler::update()
+{
+    auto start = std::chrono::steady_clock::now();
+    _frameBytes = 0;
+
+    flush(Type::FONT_ATLAS);
+
+    bool first = true;
+    while (!_jobs.empty())
+    {
+        if (!first)
+        {
+            std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= _timeBudget || _frameBytes + _jobs.front().bytes > _byteBudget)
+                break;
+        }
+        first = false;
+
+        // a job can cancel others, so it leaves the queue before it runs
+        Job job = std::move(_jobs.front());
+        _jobs.pop_front();
+        runJob(job);
+    }
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    _frameTime = elapsed.count();
+}
+
+void UploadScheduler::flush(Type type)
+{
+    takeIncoming();
+
+    auto ofType = [type](const Job& job){ return job.type == type; };
+    for (auto it = std::find_if(_jobs.begin(), _jobs.end(), ofType); it != _jobs.end(); it = std::find_if(_jobs.begin(), _jobs.end(), ofType))
+    {
+        Job job = std::move(*it);
+        _jobs.erase(it);
+        runJob(job);
+    }
+}
+
+void UploadScheduler::takeIncoming()
+{
+    std::lock_guard<std::mutex> lock(_incomingMutex);
+    for (auto& job : _incoming)
+    {
+        _jobs.push_back(std::move(job));
+    }
+    _incoming.clear();
+}
+
+void UploadScheduler::runJob(const Job& job)
+{
+    std::chrono::duration<float> latency = std::chrono::steady_clock::now() - job.scheduled;
+    auto& stats = _stats[(int)job.type];
+    stats.jobs++;
+    stats.bytes += job.bytes;
+    stats.totalLatency += latency.count();
+    stats.maxLatency = std::max(stats.maxLatency, latency.count());
+    _frameBytes += job.bytes;
+
+    job.run();
+}
+
+size_t UploadScheduler::getPendingJobs() const
+{
+    std::lock_guard<std::mutex> lock(_incomingMutex);
+    return _incoming.size() + _jobs.size();
+}
+
+void UploadScheduler::resetStats()
+{
+    for (auto& stats : _stats)
+    {
+        stats = Stats();
+    }
+}
+
+NS_CC_END
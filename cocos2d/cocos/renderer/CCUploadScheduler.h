@@ -0,0 +1,126 @@
+/****************************************************************************
+ Copyright (c) 2013-2014 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_UPLOAD_SCHEDULER_H_
+#define __CC_UPLOAD_SCHEDULER_H_
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "base/CCRef.h"
+
+NS_CC_BEGIN
+
+/** Runs GL uploads on the cocos thread within a per frame budget.
+ Loaders queue a job for each texture, vertex buffer or font atlas upload they would otherwise do right away,
+ the Director runs the queued jobs once a frame, before the scene is visited,
+ in the order they were scheduled, until the frame's milliseconds or bytes are used up.
+ At least one job runs every frame, so a job bigger than the budget still gets its frame to itself.
+ Font atlas jobs are not deferred, the labels visited this frame draw from them,
+ so the Renderer flushes them before it draws, they still count towards the frame's bytes.
+ */
+class CC_DLL UploadScheduler : public Ref
+{
+public:
+    enum class Type
+    {
+        TEXTURE,
+        VERTEX_BUFFER,
+        FONT_ATLAS,
+    };
+
+    /** what the jobs of a type cost since the last resetStats() */
+    struct Stats
+    {
+        Stats() : jobs(0), bytes(0), totalLatency(0), maxLatency(0) {}
+
+        unsigned int jobs;
+        ssize_t bytes;
+        float totalLatency;     //seconds from schedule to run, summed over the jobs
+        float maxLatency;
+
+        float getAverageLatency() const { return jobs ? totalLatency / jobs : 0; }
+    };
+
+    UploadScheduler();
+    virtual ~UploadScheduler();
+
+    /** queues job to run on the cocos thread, bytes is what it uploads, 0 if it is not known.
+     Can be called from any thread, the owner is only used to cancel the job.
+     */
+    void schedule(Type type, ssize_t bytes, void* owner, const std::function<void()>& job);
+    /** drops the jobs of owner that have not run yet, cocos thread only.
+     Threads that schedule jobs for owner have to be stopped first.
+     */
+    void cancel(void* owner);
+
+    /** runs the queued jobs within the budget, called by the Director every frame */
+    void update();
+    /** runs every queued job of type, whatever the budget */
+    void flush(Type type);
+
+    /** milliseconds the jobs of a frame may take, 4 by default */
+    void setTimeBudget(float milliseconds) { _timeBudget = milliseconds; }
+    float getTimeBudget() const { return _timeBudget; }
+    /** bytes the jobs of a frame may upload, 4 MB by default */
+    void setByteBudget(ssize_t bytes) { _byteBudget = bytes; }
+    ssize_t getByteBudget() const { return _byteBudget; }
+
+    /** jobs waiting for a frame, including the ones not yet picked up from other threads */
+    size_t getPendingJobs() const;
+    ssize_t getFrameBytes() const { return _frameBytes; }
+    float getFrameTime() const { return _frameTime; }
+    const Stats& getStats(Type type) const { return _stats[(int)type]; }
+    void resetStats();
+
+protected:
+    struct Job
+    {
+        Type type;
+        ssize_t bytes;
+        void* owner;
+        std::chrono::steady_clock::time_point scheduled;
+        std::function<void()> run;
+    };
+
+    void takeIncoming();
+    void runJob(const Job& job);
+
+    mutable std::mutex _incomingMutex;
+    std::vector<Job> _incoming;     //scheduled since the last update, guarded by _incomingMutex
+    std::deque<Job> _jobs;          //waiting for a frame, cocos thread only
+
+    float _timeBudget;
+    ssize_t _byteBudget;
+    ssize_t _frameBytes;
+    float _frameTime;
+    Stats _stats[3];
+};
+
+NS_CC_END
+
+#endif //__CC_UPLOAD_SCHEDULER_H_
@@ -13,3 +13,19 @@ void main(void)
     gl_FragColor = texture2D(CC_Texture0, TextureCoordOut) * u_color;
 }
 );
+
+const char* cc3D_ColorTexInstanced_frag = STRINGIFY(
+
+\n#ifdef GL_ES\n
+varying mediump vec2 TextureCoordOut;
+varying lowp vec4 ColorOut;
+\n#else\n
+varying vec2 TextureCoordOut;
+varying vec4 ColorOut;
+\n#endif\n
+
+void main(void)
+{
+    gl_FragColor = texture2D(CC_Texture0, TextureCoordOut) * ColorOut;
+}
+);
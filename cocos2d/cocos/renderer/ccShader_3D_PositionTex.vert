@@ -14,6 +14,25 @@ void main(void)
 }
 );
 
+const char* cc3D_PositionTexInstanced_vert = STRINGIFY(
+
+attribute vec4 a_position;
+attribute vec2 a_texCoord;
+attribute mat4 a_instanceMV;
+attribute vec4 a_instanceColor;
+
+varying vec2 TextureCoordOut;
+varying vec4 ColorOut;
+
+void main(void)
+{
+    gl_Position = CC_PMatrix * a_instanceMV * a_position;
+    TextureCoordOut = a_texCoord;
+    TextureCoordOut.y = 1.0 - TextureCoordOut.y;
+    ColorOut = a_instanceColor;
+}
+);
+
 const char* cc3D_SkinPositionTex_vert = STRINGIFY(
 attribute vec3 a_position;
 
@@ -0,0 +1,115 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "ActionBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace std::chrono;
+
+static void printTimes(std::vector<double>& times)
+{
+    double sum = 0;
+    for(auto t : times)
+        sum += t;
+    std::sort(times.begin(), times.end());
+    printf(", %.2f, %.2f, %.2f", sum/times.size(), times[times.size()/2], times[times.size()*99/100]);
+}
+
+int runActionBenchmark(int actions, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> length(0.2f, 2.0f);
+    std::uniform_real_distribution<float> coord(-400, 400);
+    auto manager = new ActionManager();
+    Vector<Node*> nodes;
+    long spawned = 0;
+
+    auto spawn = [&](Node* node){
+        FiniteTimeAction* action = nullptr;
+        float d = length(random);
+        switch(random() % 6)
+        {
+            case 0: //like the enemy fly ins
+                action = EaseSineOut::create(MoveTo::create(d, Vec2(coord(random), coord(random))));
+                break;
+            case 1: //like the score bump
+                action = Sequence::create(EaseBackOut::create(ScaleTo::create(d, 1.2f)), ScaleTo::create(0.1f, 1), nullptr);
+                break;
+            case 2:
+                action = RotateBy::create(d, 360);
+                break;
+            case 3:
+                action = EaseSineInOut::create(FadeOut::create(d));
+                break;
+            case 4: //like BigDude::die
+                action = Sequence::create(Spawn::create(EaseSineOut::create(MoveTo::create(d, Vec2(coord(random), coord(random)))),
+                                                        ScaleTo::create(d, 0.5f), nullptr),
+                                          FadeOut::create(0.2f), nullptr);
+                break;
+            default:
+                action = EaseQuadraticActionInOut::create(ScaleTo::create(d, 0.8f));
+                break;
+        }
+        manager->addAction(action, node, false);
+        spawned++;
+    };
+
+    for(int i = 0; i < actions; i++)
+    {
+        auto node = Node::create();
+        nodes.pushBack(node);
+        spawn(node);
+    }
+
+    const int frames = 3600;
+    std::vector<double> updateTimes, spawnTimes;
+    updateTimes.reserve(frames);
+    spawnTimes.reserve(frames);
+    for(int i = 0; i < frames; i++)
+    {
+        auto start = high_resolution_clock::now();
+        manager->update(1/60.0f);
+        auto updated = high_resolution_clock::now();
+        //every node that finished gets a new action, this is where the allocations happen
+        for(auto node : nodes)
+        {
+            if(manager->getNumberOfRunningActionsInTarget(node) == 0)
+                spawn(node);
+        }
+        PoolManager::getInstance()->getCurrentPool()->clear();
+        updateTimes.push_back(duration<double, std::micro>(updated-start).count());
+        spawnTimes.push_back(duration<double, std::micro>(high_resolution_clock::now()-updated).count());
+    }
+    manager->release();
+
+    printf("actions, frames, spawned, update mean us, update p50 us, update p99 us, spawn mean us, spawn p50 us, spawn p99 us\n");
+    printf("%d, %d, %ld", actions, frames, spawned);
+    printTimes(updateTimes);
+    printTimes(spawnTimes);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,400 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "Benchmark.h"
+#include "../Classes/HelloWorldScene.h"
+#include "../Classes/LoadingScene.h"
+#include "../Classes/GameLayer.h"
+#include "../Classes/GameOverLayer.h"
+#include "../Classes/GameControllers.h"
+#include "../Classes/WaveScheduler.h"
+#include "../Classes/Player.h"
+#include "../Classes/Bullets.h"
+#include "../Classes/consts.h"
+#include "../Classes/SoundManager.h"
+#include "../Classes/ObjectPool.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+const float InputTrack::IntroTime = 2.5f;
+const float InputTrack::MaxFingerStep = 30;
+
+void InputTrack::load(const std::string& file)
+{
+    _time.clear();
+    _pos.clear();
+    if(!file.empty())
+    {
+        auto root = FileUtils::getInstance()->getValueMapFromFile(file);
+        if(root.find("keys") != root.end())
+        {
+            for(auto& k : root["keys"].asValueVector())
+            {
+                auto& key = k.asValueMap();
+                _time.push_back(key["time"].asFloat());
+                _pos.push_back(Vec2(key["x"].asFloat(), key["y"].asFloat()));
+            }
+        }
+        if(_time.empty())
+            CCLOG("InputTrack: no keys in %s, using the built in sweep", file.c_str());
+    }
+    if(_time.empty())
+    {
+        //weave across the screen, dipping down and up so both fodder formations and the boss get hit
+        for(int i = 0; i <= 240; i++)
+        {
+            float t = i*0.5f;
+            _time.push_back(IntroTime+t);
+            _pos.push_back(Vec2(PLAYER_LIMIT_RIGHT*0.8f*sinf(t*0.7f), -200+150*sinf(t*0.45f)));
+        }
+    }
+}
+
+Vec2 InputTrack::at(float time) const
+{
+    auto it = std::upper_bound(_time.begin(), _time.end(), time);
+    if(it == _time.begin())
+        return _pos.front();
+    if(it == _time.end())
+        return _pos.back();
+    size_t i = it-_time.begin();
+    float alpha = (time-_time[i-1])/(_time[i]-_time[i-1]);
+    return _pos[i-1].lerp(_pos[i], alpha);
+}
+
+Vec2 InputTrack::delta(float time, float dt) const
+{
+    Vec2 delta = at(time)-at(time-dt);
+    if(delta.length() > MaxFingerStep)
+        delta = delta.getNormalized()*MaxFingerStep;
+    return delta;
+}
+
+Benchmark::Benchmark(const BenchmarkOptions& options)
+: _options(options)
+, _gameLayer(nullptr)
+, _hud(nullptr)
+{
+}
+
+bool Benchmark::applicationDidFinishLaunching()
+{
+    //the window is never shown, but the renderer still needs a context, on a CPU only box run it under Xvfb with Mesa
+    glfwInit();
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    auto director = Director::getInstance();
+    director->setOpenGLView(GLViewImpl::createWithRect("EarthWarrior3D benchmark", Rect(0, 0, 800*(640.0/960.0), 800)));
+    return AppDelegate::applicationDidFinishLaunching();
+}
+
+void Benchmark::sendTouch(int phase, const Vec2& glPoint)
+{
+    //go through GLView like a real touch, it expects frame coordinates
+    auto glview = Director::getInstance()->getOpenGLView();
+    Vec2 ui = Director::getInstance()->convertToUI(glPoint);
+    intptr_t id = 0;
+    float x = ui.x*glview->getScaleX()+glview->getViewPortRect().origin.x;
+    float y = ui.y*glview->getScaleY()+glview->getViewPortRect().origin.y;
+    switch(phase)
+    {
+        case 0:
+            glview->handleTouchesBegin(1, &id, &x, &y);
+            break;
+        case 1:
+            glview->handleTouchesMove(1, &id, &x, &y);
+            break;
+        default:
+            glview->handleTouchesEnd(1, &id, &x, &y);
+            break;
+    }
+}
+
+long Benchmark::timerTotal(const char* name)
+{
+#if CC_ENABLE_PROFILERS
+    auto timer = Profiler::getInstance()->_activeTimers.at(name);
+    return timer ? timer->totalTime : 0;
+#else
+    return 0;
+#endif
+}
+
+bool Benchmark::gameOver()
+{
+    if(GameLayer::isDie)
+        return true;
+    for(auto child : _hud->getChildren())
+    {
+        if(dynamic_cast<GameOverLayer*>(child))
+            return true;
+    }
+    return false;
+}
+
+unsigned int Benchmark::createdAfterWarmup()
+{
+    unsigned int created = 0;
+    for(size_t f = 0; f < _frames.size(); f++)
+    {
+        if(f*_options.frameTime >= _options.warmup)
+            created += _frames[f].created;
+    }
+    return created;
+}
+
+int Benchmark::run()
+{
+#if !CC_ENABLE_PROFILERS
+    CCLOG("Benchmark: built without CC_ENABLE_PROFILERS, only total and update times will be recorded");
+#endif
+    if(!applicationDidFinishLaunching())
+        return 1;
+    auto director = Director::getInstance();
+    director->setLegacyMatrixStackEnabled(_options.legacyMatrixStack);
+    director->getRenderer()->setInstancingEnabled(_options.instancing);
+    auto glview = director->getOpenGLView();
+    glview->retain();
+    director->setFixedDeltaTime(_options.frameTime);
+    auto listener = director->getEventDispatcher()->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom*){
+        _afterUpdate = high_resolution_clock::now();
+    });
+
+    //bring up the menu once so the start up path is the real one, then skip it and the loading screen
+    director->mainLoop();
+    LoadingScene::preloadAll();
+    _input.load(_options.input);
+    WaveScheduler::setSeedOverride(_options.seed);
+    auto scene = HelloWorld::createScene();
+    director->replaceScene(scene);
+    director->mainLoop();
+    _hud = scene->getChildByTag(100);
+    _gameLayer = static_cast<GameLayer*>(_hud->getChildByTag(123));
+    _gameLayer->getPlayer()->setInvincible(_options.invincible);
+
+    _frames.reserve(_options.frames);
+    bool touching = false;
+    for(int f = 0; f < _options.frames && !gameOver(); f++)
+    {
+        float time = f*_options.frameTime;
+        if(time >= InputTrack::IntroTime)
+        {
+            if(!touching)
+            {
+                _finger = Vec2(glview->getDesignResolutionSize())/2;
+                sendTouch(0, _finger);
+                touching = true;
+            }
+            //open loop, the finger replays the track's deltas and the player follows them
+            Vec2 delta = _input.delta(time, _options.frameTime);
+            if(delta != Vec2::ZERO)
+            {
+                _finger += delta;
+                sendTouch(1, _finger);
+            }
+        }
+
+        long visit = timerTotal("Scene - visit");
+        long render = timerTotal("Renderer - render");
+        long collision = timerTotal("GameController - collision");
+        long step = timerTotal("GameController - step");
+        unsigned int created = ObjectPoolBase::getTotalCreated();
+        auto start = high_resolution_clock::now();
+        _afterUpdate = start;
+        director->mainLoop();
+        auto end = high_resolution_clock::now();
+
+        BenchmarkFrame frame;
+        frame.total = duration_cast<microseconds>(end-start).count();
+        frame.update = duration_cast<microseconds>(_afterUpdate-start).count();
+        frame.visit = timerTotal("Scene - visit")-visit;
+        frame.render = timerTotal("Renderer - render")-render;
+        frame.collision = timerTotal("GameController - collision")-collision;
+        frame.step = timerTotal("GameController - step")-step;
+        frame.enemies = EnemyController::enemies.size();
+        frame.bullets = BulletController::getBulletSystem() ? BulletController::getBulletSystem()->size() : 0;
+        frame.batches = director->getRenderer()->getDrawnBatches();
+        frame.vertices = director->getRenderer()->getDrawnVertices();
+        frame.culled = director->getRenderer()->getCulledObjects();
+        frame.visible = director->getRenderer()->getVisibleObjects();
+        frame.created = ObjectPoolBase::getTotalCreated()-created;
+        _frames.push_back(frame);
+    }
+    if(touching)
+        sendTouch(2, _finger);
+    writeReport();
+
+    director->getEventDispatcher()->removeEventListener(listener);
+    director->end();
+    director->mainLoop();
+    glview->release();
+    //once the pools are warm gameplay must not create anything
+    unsigned int late = createdAfterWarmup();
+    if(late)
+    {
+        printf("Benchmark: the pools created %u objects after the first %.1f seconds\n", late, _options.warmup);
+        return 1;
+    }
+    return 0;
+}
+
+int Benchmark::runLoading()
+{
+    if(!applicationDidFinishLaunching())
+        return 1;
+    auto director = Director::getInstance();
+    //the worker threads start with the loading screen's first addImageAsync and createAsync
+    if(_options.loadThreads > 0)
+    {
+        director->getTextureCache()->setAsyncThreadCount(_options.loadThreads);
+        Sprite3DCache::getInstance()->setAsyncThreadCount(_options.loadThreads);
+    }
+    auto glview = director->getOpenGLView();
+    glview->retain();
+    director->setFixedDeltaTime(_options.frameTime);
+
+    //bring up the menu once like run() does, the loading screen starts its loads while it is created
+    director->mainLoop();
+    std::vector<long> frames;
+    int maxFrames = (int)(60/_options.frameTime);
+    bool loaded = true;
+    int threads = 0;
+    auto start = high_resolution_clock::now();
+    if(_options.loadSync)
+    {
+        //one frame that loads everything, no worker threads
+        LoadingScene::preloadAll();
+        frames.push_back(duration_cast<microseconds>(high_resolution_clock::now()-start).count());
+    }
+    else
+    {
+        auto scene = Scene::create();
+        auto loading = LoadingScene::create();
+        scene->addChild(loading);
+        director->replaceScene(scene);
+
+        //a load that never calls back would hang the run, give up after a minute of frames
+        while(!loading->isLoaded() && (int)frames.size() < maxFrames)
+        {
+            auto frameStart = high_resolution_clock::now();
+            director->mainLoop();
+            frames.push_back(duration_cast<microseconds>(high_resolution_clock::now()-frameStart).count());
+        }
+        loaded = loading->isLoaded();
+        threads = director->getTextureCache()->getAsyncThreadCount();
+    }
+    long total = duration_cast<microseconds>(high_resolution_clock::now()-start).count();
+
+    director->end();
+    director->mainLoop();
+    glview->release();
+    if(!loaded)
+    {
+        printf("Benchmark: the loading screen did not finish in %d frames\n", maxFrames);
+        return 1;
+    }
+    long sum = 0;
+    for(auto f : frames)
+        sum += f;
+    std::sort(frames.begin(), frames.end());
+    printf("threads, frames, load ms, mean frame ms, p95 frame ms, max frame ms\n");
+    printf("%d, %d, %.1f, %.2f, %.2f, %.2f\n", threads, (int)frames.size(), total/1000.0,
+           frames.empty() ? 0.0 : sum/1000.0/frames.size(),
+           frames.empty() ? 0.0 : frames[frames.size()*95/100]/1000.0,
+           frames.empty() ? 0.0 : frames.back()/1000.0);
+    return 0;
+}
+
+static void writeSummary(FILE* out, const char* name, std::vector<long> values, bool last)
+{
+    if(values.empty())
+        values.push_back(0);
+    long sum = 0;
+    for(auto v : values)
+        sum += v;
+    std::sort(values.begin(), values.end());
+    fprintf(out, "    \"%s\": {\"mean\": %.1f, \"p50\": %ld, \"p95\": %ld, \"p99\": %ld, \"max\": %ld}%s\n",
+            name, (double)sum/values.size(),
+            values[values.size()/2], values[values.size()*95/100], values[values.size()*99/100], values.back(),
+            last ? "" : ",");
+}
+
+void Benchmark::writeReport()
+{
+    FILE* out = fopen(_options.output.c_str(), "w");
+    if(!out)
+    {
+        CCLOG("Benchmark: could not write %s", _options.output.c_str());
+        return;
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"seed\": %u,\n", WaveScheduler::getSeed());
+    fprintf(out, "  \"frameTime\": %f,\n", _options.frameTime);
+    fprintf(out, "  \"legacyMatrixStack\": %s,\n", _options.legacyMatrixStack ? "true" : "false");
+    fprintf(out, "  \"instancing\": %s,\n", _options.instancing ? "true" : "false");
+    fprintf(out, "  \"frameCount\": %d,\n", (int)_frames.size());
+    fprintf(out, "  \"gameTime\": %f,\n", WaveScheduler::getTime());
+    fprintf(out, "  \"units\": \"microseconds\",\n");
+    unsigned int created = 0;
+    for(auto& f : _frames)
+        created += f.created;
+    fprintf(out, "  \"poolCreated\": {\"warmup\": %f, \"total\": %u, \"afterWarmup\": %u},\n", _options.warmup, created, createdAfterWarmup());
+    auto& sound = SoundManager::getStats();
+    fprintf(out, "  \"sound\": {\"requested\": %u, \"played\": %u, \"coalesced\": %u, \"dropped\": %u, \"stolen\": %u},\n",
+            sound.requested, sound.played, sound.coalesced, sound.dropped, sound.stolen);
+    fprintf(out, "  \"summary\": {\n");
+    std::vector<long> total, update, visit, render, collision, step, batches, vertices;
+    for(auto& f : _frames)
+    {
+        total.push_back(f.total);
+        update.push_back(f.update);
+        visit.push_back(f.visit);
+        render.push_back(f.render);
+        collision.push_back(f.collision);
+        step.push_back(f.step);
+        batches.push_back(f.batches);
+        vertices.push_back(f.vertices);
+    }
+    writeSummary(out, "total", total, false);
+    writeSummary(out, "update", update, false);
+    writeSummary(out, "visit", visit, false);
+    writeSummary(out, "render", render, false);
+    writeSummary(out, "collision", collision, false);
+    writeSummary(out, "step", step, false);
+    writeSummary(out, "batches", batches, false);
+    writeSummary(out, "vertices", vertices, true);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"frames\": [\n");
+    for(size_t i = 0; i < _frames.size(); i++)
+    {
+        auto& f = _frames[i];
+        fprintf(out, "    {\"total\": %ld, \"update\": %ld, \"visit\": %ld, \"render\": %ld, \"collision\": %ld, \"step\": %ld, \"enemies\": %d, \"bullets\": %d, \"batches\": %d, \"vertices\": %d, \"culled\": %d, \"visible\": %d, \"created\": %d}%s\n",
+                f.total, f.update, f.visit, f.render, f.collision, f.step, f.enemies, f.bullets, f.batches, f.vertices, f.culled, f.visible, f.created,
+                i+1 < _frames.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+    fclose(out);
+    CCLOG("Benchmark: %d frames written to %s", (int)_frames.size(), _options.output.c_str());
+}
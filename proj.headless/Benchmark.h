@@ -0,0 +1,125 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __Moon3d__Benchmark__
+#define __Moon3d__Benchmark__
+
+#include "cocos2d.h"
+#include "../Classes/AppDelegate.h"
+#include <chrono>
+USING_NS_CC;
+class GameLayer;
+
+//the scripted finger, keys of {time, x, y} from a plist "keys" array, or a built in sweep across the screen
+class InputTrack
+{
+public:
+    //the player flies in for this long before it takes input
+    static const float IntroTime;
+    //the finger never moves faster than this per frame, like a hand would not
+    static const float MaxFingerStep;
+    //an empty file, or one without keys, uses the built in sweep
+    void load(const std::string& file);
+    Vec2 at(float time) const;
+    //how far the finger moves from time-dt to time, capped at MaxFingerStep
+    Vec2 delta(float time, float dt) const;
+
+protected:
+    std::vector<float> _time;
+    std::vector<Vec2> _pos;
+};
+
+struct BenchmarkOptions
+{
+    BenchmarkOptions()
+    : frames(60*120)
+    , frameTime(1.0f/60)
+    , seed(1)
+    , warmup(2.5f)
+    , invincible(true)
+    , legacyMatrixStack(false)
+    , instancing(true)
+    , loadThreads(0)
+    , loadSync(false)
+    , output("benchmark.json")
+    {}
+    int frames;
+    float frameTime;
+    unsigned int seed;
+    float warmup; //seconds of play in which the pools may still grow, after that any object they create fails the run
+    bool invincible;
+    bool legacyMatrixStack; //turns the stack back on to measure what skipping it saves in visit
+    bool instancing; //off draws every mesh on its own, the batch count and render time against a run with it on are what instancing saves
+    int loadThreads; //image decode and model parse threads for runLoading, 0 keeps the caches' defaults
+    bool loadSync; //runLoading times LoadingScene::preloadAll instead, everything on the cocos thread like before the async loads
+    std::string output;
+    std::string input; //plist with a "keys" array of {time, x, y}, empty uses the built in sweep
+};
+
+//per frame timings in microseconds
+struct BenchmarkFrame
+{
+    long total;
+    long update;
+    long visit;
+    long render;
+    long collision;
+    long step;
+    int enemies;
+    int bullets;
+    int batches;
+    int vertices;
+    int culled;
+    int visible;
+    int created; //objects the pools created during the frame
+};
+
+//boots the game through AppDelegate in an invisible window, skips the menus and replays one level
+//with fixed frame times, a fixed seed and a scripted input track, then writes the timings as JSON
+class Benchmark : public AppDelegate
+{
+public:
+    Benchmark(const BenchmarkOptions& options);
+    virtual bool applicationDidFinishLaunching();
+    int run();
+    //times the loading screen from its creation until the pools are prewarmed, instead of playing
+    int runLoading();
+
+protected:
+    void sendTouch(int phase, const Vec2& glPoint);
+    long timerTotal(const char* name);
+    bool gameOver();
+    unsigned int createdAfterWarmup();
+    void writeReport();
+
+    BenchmarkOptions _options;
+    InputTrack _input;
+    Vec2 _finger;
+    GameLayer* _gameLayer;
+    Node* _hud;
+    std::chrono::high_resolution_clock::time_point _afterUpdate;
+    std::vector<BenchmarkFrame> _frames;
+};
+
+#endif /* defined(__Moon3d__Benchmark__) */
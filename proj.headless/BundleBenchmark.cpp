@@ -0,0 +1,101 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "BundleBenchmark.h"
+#include "3d/CCBundle3D.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+using namespace std::chrono;
+
+struct BundleLoad
+{
+    MeshDatas meshdatas;
+    MaterialDatas materialdatas;
+    NodeDatas nodedatas;
+
+    ~BundleLoad()
+    {
+        meshdatas.resetData();
+        nodedatas.resetData();
+    }
+};
+
+//resident heap and file pages in KB, mapped meshes show up as the latter
+static void readResident(long& anon, long& file)
+{
+    anon = file = 0;
+    FILE* status = fopen("/proc/self/status", "r");
+    if(!status)
+        return;
+    char line[256];
+    while(fgets(line, sizeof(line), status))
+    {
+        sscanf(line, "RssAnon: %ld", &anon);
+        sscanf(line, "RssFile: %ld", &file);
+    }
+    fclose(status);
+}
+
+int runBundleBenchmark(const std::string& file, int runs)
+{
+    auto fullPath = FileUtils::getInstance()->fullPathForFilename(file);
+    std::vector<BundleLoad*> loads;
+    std::vector<double> times;
+    long anonBefore, fileBefore, anonAfter, fileAfter;
+    readResident(anonBefore, fileBefore);
+
+    for(int i = 0; i < runs; i++)
+    {
+        auto load = new BundleLoad();
+        auto start = high_resolution_clock::now();
+        auto bundle = Bundle3D::createBundle();
+        bool loaded = bundle->load(fullPath)
+            && bundle->loadMeshDatas(load->meshdatas)
+            && bundle->loadMaterials(load->materialdatas)
+            && bundle->loadNodes(load->nodedatas);
+        Bundle3D::destroyBundle(bundle);
+        times.push_back(duration<double, std::milli>(high_resolution_clock::now()-start).count());
+        loads.push_back(load);
+        if(!loaded)
+        {
+            printf("could not load %s\n", file.c_str());
+            return 1;
+        }
+    }
+    readResident(anonAfter, fileAfter);
+    for(auto load : loads)
+        delete load;
+
+    double sum = 0;
+    for(auto t : times)
+        sum += t;
+    std::sort(times.begin(), times.end());
+    printf("file, runs, load mean ms, load p50 ms, heap KB per load, file pages KB\n");
+    printf("%s, %d, %.3f, %.3f, %.1f, %ld\n", file.c_str(), runs, sum/runs, times[runs/2],
+           (anonAfter-anonBefore)/(double)runs, fileAfter-fileBefore);
+    return 0;
+}
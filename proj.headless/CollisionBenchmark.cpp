@@ -0,0 +1,147 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "CollisionBenchmark.h"
+#include "../Classes/GameControllers.h"
+#include "../Classes/AirCraft.h"
+#include "../Classes/consts.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace std::chrono;
+
+namespace {
+    //an enemy without a model, the broadphase only reads its position, radius and alive flag
+    class CollisionTarget : public AirCraft
+    {
+    public:
+        static CollisionTarget* create(const Vec2& pos, float radius, bool alive)
+        {
+            auto target = new (std::nothrow) CollisionTarget();
+            if(target && target->init())
+            {
+                target->autorelease();
+                target->setPosition(pos);
+                target->_radius = radius;
+                target->_alive = alive;
+                target->_type = kEnemyFodder;
+                return target;
+            }
+            CC_SAFE_DELETE(target);
+            return nullptr;
+        }
+    };
+}
+
+//what GameController::update did before the grid, every bullet against every enemy,
+//walked backwards so the highest index wins like it does in CollisionGrid::hitTest
+static AirCraft* allPairsHit(const Vector<AirCraft*>& enemies, const Vec2& pos, float radius)
+{
+    for(ssize_t j = enemies.size()-1; j >= 0; j--)
+    {
+        auto e = enemies.at(j);
+        if(!e->alive())
+            continue;
+        float dx = pos.x - e->getPosition().x;
+        float dy = pos.y - e->getPosition().y;
+        float r = radius + e->getRadius();
+        if(dx*dx+dy*dy < r*r)
+            return e;
+    }
+    return nullptr;
+}
+
+template<typename F>
+static double bestOf(int runs, F f)
+{
+    double best = 0;
+    for(int i = 0; i < runs; i++)
+    {
+        auto start = high_resolution_clock::now();
+        f();
+        double us = duration<double, std::micro>(high_resolution_clock::now()-start).count();
+        if(i == 0 || us < best)
+            best = us;
+    }
+    return best;
+}
+
+int runCollisionBenchmark(unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    //the bullet radius BulletSystem::spawn gives every bullet
+    const float bulletRadius = 10;
+    printf("bullets, enemies, hits, all pairs us, grid us\n");
+    //a busy wave has a few dozen enemies on screen, the second count is there to see how both scale
+    for(int enemyCount : {50, 500})
+    {
+        Vector<AirCraft*> enemies;
+        for(int i = 0; i < enemyCount; i++)
+        {
+            Vec2 pos(ENEMY_BOUND_RECT.origin.x+ENEMY_BOUND_RECT.size.width*unit(random),
+                     ENEMY_BOUND_RECT.origin.y+ENEMY_BOUND_RECT.size.height*unit(random));
+            //fodder, leader and big dude radii, every tenth one is already dead and has to be skipped
+            enemies.pushBack(CollisionTarget::create(pos, 30+5*(random()%3), i%10 != 0));
+        }
+        for(int bulletCount : {100, 1000, 10000})
+        {
+            std::vector<Vec2> bullets(bulletCount);
+            for(auto& bullet : bullets)
+                bullet = Vec2(BOUND_RECT.origin.x+BOUND_RECT.size.width*unit(random),
+                              BOUND_RECT.origin.y+BOUND_RECT.size.height*unit(random));
+            int runs = std::max(5, 1000000/(bulletCount*enemyCount));
+
+            std::vector<AirCraft*> allPairs(bulletCount);
+            double allPairsTime = bestOf(runs, [&](){
+                for(int i = 0; i < bulletCount; i++)
+                    allPairs[i] = allPairsHit(enemies, bullets[i], bulletRadius);
+            });
+
+            std::vector<AirCraft*> grid(bulletCount);
+            double gridTime = bestOf(runs, [&](){
+                //the game rebuilds the grid every step, so the build is part of its time
+                CollisionGrid::build(enemies);
+                for(int i = 0; i < bulletCount; i++)
+                    grid[i] = CollisionGrid::hitTest(bullets[i], bulletRadius);
+            });
+
+            //both have to pick the same enemy, or none, for every bullet
+            int hits = 0;
+            for(int i = 0; i < bulletCount; i++)
+            {
+                if(allPairs[i] != grid[i])
+                {
+                    printf("grid hit differs from the all pairs loop at bullet %d\n", i);
+                    return 1;
+                }
+                if(grid[i])
+                    hits++;
+            }
+            printf("%d, %d, %d, %.1f, %.1f\n", bulletCount, enemyCount, hits, allPairsTime, gridTime);
+        }
+    }
+    return 0;
+}
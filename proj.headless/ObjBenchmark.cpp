@@ -0,0 +1,87 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "ObjBenchmark.h"
+#include "3d/CCBundle3D.h"
+#include "3d/CCObjLoader.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std::chrono;
+
+static double loadObj(const std::string& fullPath, size_t& vertices)
+{
+    MeshDatas meshdatas;
+    MaterialDatas materialdatas;
+    NodeDatas nodedatas;
+    auto start = high_resolution_clock::now();
+    bool loaded = Bundle3D::loadObj(meshdatas, materialdatas, nodedatas, fullPath);
+    double ms = duration<double, std::milli>(high_resolution_clock::now()-start).count();
+    vertices = 0;
+    for(auto meshdata : meshdatas.meshDatas)
+        vertices += meshdata->vertex.size() * sizeof(float) / meshdata->getPerVertexSize();
+    return loaded ? ms : -1;
+}
+
+static void printTimes(std::vector<double>& times)
+{
+    double sum = 0;
+    for(auto t : times)
+        sum += t;
+    std::sort(times.begin(), times.end());
+    printf(", %.2f, %.2f", sum/times.size(), times[times.size()/2]);
+}
+
+int runObjBenchmark(const std::string& file, int runs)
+{
+    auto fullPath = FileUtils::getInstance()->fullPathForFilename(file);
+    long bytes = FileUtils::getInstance()->getFileSize(fullPath);
+    size_t vertices = 0;
+    bool cacheEnabled = ObjLoader::isCacheEnabled();
+
+    std::vector<double> parseTimes, cachedTimes;
+    ObjLoader::setCacheEnabled(false);
+    for(int i = 0; i < runs; i++)
+        parseTimes.push_back(loadObj(fullPath, vertices));
+    //the first load with the cache on parses and writes it, the rest read it
+    ObjLoader::setCacheEnabled(true);
+    double writeTime = loadObj(fullPath, vertices);
+    for(int i = 0; i < runs; i++)
+        cachedTimes.push_back(loadObj(fullPath, vertices));
+    ObjLoader::setCacheEnabled(cacheEnabled);
+
+    if(parseTimes[0] < 0)
+    {
+        printf("could not load %s\n", file.c_str());
+        return 1;
+    }
+    printf("file, bytes, vertices, runs, parse mean ms, parse p50 ms, cache write ms, cached mean ms, cached p50 ms\n");
+    printf("%s, %ld, %zu, %d", file.c_str(), bytes, vertices, runs);
+    printTimes(parseTimes);
+    printf(", %.2f", writeTime);
+    printTimes(cachedTimes);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "RenderSortBenchmark.h"
+#include "renderer/CCRenderer.h"
+#include "renderer/CCCustomCommand.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace std::chrono;
+
+//what RenderQueue::sort did before it sorted by key
+static bool compareGlobalOrder(RenderCommand* a, RenderCommand* b)
+{
+    return a->getGlobalOrder() < b->getGlobalOrder();
+}
+
+template<typename F>
+static double bestOf(int runs, F f)
+{
+    double best = 0;
+    for(int i = 0; i < runs; i++)
+    {
+        auto start = high_resolution_clock::now();
+        f();
+        double us = duration<double, std::micro>(high_resolution_clock::now()-start).count();
+        if(i == 0 || us < best)
+            best = us;
+    }
+    return best;
+}
+
+int runRenderSortBenchmark(unsigned int seed)
+{
+    std::mt19937 random(seed);
+    printf("commands, std::sort us, radix sort us\n");
+    for(int count : {1000, 10000, 100000})
+    {
+        //z orders like a scene graph hands out, a few hundred distinct values on both sides of 0
+        std::vector<CustomCommand> commands(count);
+        std::uniform_int_distribution<int> z(-300, 300);
+        for(auto& command : commands)
+        {
+            int order = z(random);
+            command.init(order == 0 ? 1 : order);
+        }
+        int runs = std::max(5, 1000000/count);
+
+        std::vector<RenderCommand*> pointers;
+        pointers.reserve(count);
+        double comparator = bestOf(runs, [&](){
+            pointers.clear();
+            for(auto& command : commands)
+                pointers.push_back(&command);
+            std::sort(pointers.begin(), pointers.end(), compareGlobalOrder);
+        });
+
+        RenderQueue queue;
+        double radix = bestOf(runs, [&](){
+            queue.clear();
+            for(auto& command : commands)
+                queue.push_back(&command);
+            queue.sort();
+        });
+
+        //both have to agree on the order of the global z
+        for(int i = 0; i < count; i++)
+        {
+            if(queue[i]->getGlobalOrder() != pointers[i]->getGlobalOrder())
+            {
+                printf("radix sort order differs at %d\n", i);
+                return 1;
+            }
+        }
+        printf("%d, %.1f, %.1f\n", count, comparator, radix);
+    }
+    return 0;
+}
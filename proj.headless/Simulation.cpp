@@ -0,0 +1,143 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "Simulation.h"
+#include "../Classes/GameControllers.h"
+#include "../Classes/GameLayer.h"
+#include "../Classes/HelloWorldScene.h"
+#include "../Classes/WaveScheduler.h"
+#include "../Classes/AirCraft.h"
+#include "../Classes/Player.h"
+#include "../Classes/Bullets.h"
+#include "../Classes/Effects.h"
+#include "../Classes/consts.h"
+
+using namespace std::chrono;
+
+namespace {
+    //FNV-1a over the bits of everything that decides how the rest of the run goes
+    class StateHash
+    {
+    public:
+        StateHash() : _hash(2166136261u) {}
+        void add(const void* data, size_t size)
+        {
+            auto bytes = static_cast<const unsigned char*>(data);
+            for(size_t i = 0; i < size; i++)
+            {
+                _hash ^= bytes[i];
+                _hash *= 16777619u;
+            }
+        }
+        void add(int value){ add(&value, sizeof(value)); }
+        void add(float value){ add(&value, sizeof(value)); }
+        void add(const Vec2& value){ add(value.x); add(value.y); }
+        void add(AirCraft* enemy)
+        {
+            add(enemy->getType());
+            add(enemy->getPosition());
+            add(enemy->getRotation());
+            add((int)enemy->alive());
+        }
+        unsigned int get() const { return _hash; }
+
+    private:
+        unsigned int _hash;
+    };
+}
+
+static unsigned int stateHash(Player* player)
+{
+    StateHash hash;
+    hash.add(HelloWorld::getPendingScore());
+    hash.add(WaveScheduler::getTime());
+    hash.add(player->getPosition());
+    hash.add((int)player->alive());
+    for(auto enemy : EnemyController::enemies)
+        hash.add(enemy);
+    for(auto enemy : EnemyController::showCaseEnemies)
+        hash.add(enemy);
+    for(auto missile : BulletController::missiles)
+        hash.add(missile->getPosition());
+    auto bullets = BulletController::getBulletSystem();
+    hash.add(bullets->posX.data(), bullets->posX.size()*sizeof(float));
+    hash.add(bullets->posY.data(), bullets->posY.size()*sizeof(float));
+    hash.add(bullets->type.data(), bullets->type.size()*sizeof(int));
+    return hash.get();
+}
+
+int runSimulation(float seconds, const BenchmarkOptions& options)
+{
+    GameController::setSimulationOnly(true);
+    GameController::reset();
+    GameLayer::isDie = false;
+    //nothing is drawn, so instead of a GameLayer a bare node holds the bullets, enemies and the player
+    auto root = Node::create();
+    root->retain();
+    EffectManager::setLayer(nullptr);
+    BulletController::init(root);
+    auto enemyLayer = Node::create();
+    root->addChild(enemyLayer);
+    EnemyController::init(enemyLayer);
+    auto player = Player::create();
+    player->setInvincible(options.invincible);
+    //where the fly in ends
+    player->setPosition(Vec2(0,-200));
+    root->addChild(player,5);
+    //timers and actions are paused on nodes that are not running
+    root->onEnter();
+    root->onEnterTransitionDidFinish();
+    WaveScheduler::start(options.seed);
+    InputTrack input;
+    input.load(options.input);
+
+    int steps = seconds/GameController::FixedStep;
+    int step = 0;
+    auto start = high_resolution_clock::now();
+    for(; step < steps && !GameLayer::isDie; step++)
+    {
+        float time = step*GameController::FixedStep;
+        if(time >= InputTrack::IntroTime)
+        {
+            //the deltas the benchmark's finger sends, applied the way Player::onTouchMoved does
+            Vec2 pos = player->getPosition()+input.delta(time, GameController::FixedStep);
+            player->setPosition(pos.getClampPoint(Vec2(PLAYER_LIMIT_LEFT,PLAYER_LIMIT_BOT),Vec2(PLAYER_LIMIT_RIGHT,PLAYER_LIMIT_TOP)));
+        }
+        GameController::simulate(GameController::FixedStep, player);
+        //there is no Director loop to empty the autorelease pool
+        PoolManager::getInstance()->getCurrentPool()->clear();
+    }
+    double wall = duration<double>(high_resolution_clock::now()-start).count();
+    float gameTime = step*GameController::FixedStep;
+
+    printf("seed, steps, game seconds, wall seconds, game seconds per wall second, dead, score, enemies, bullets, state hash\n");
+    printf("%u, %d, %.2f, %.3f, %.0f, %s, %d, %d, %d, %08x\n",
+           WaveScheduler::getSeed(), step, gameTime, wall, wall > 0 ? gameTime/wall : 0,
+           GameLayer::isDie ? "true" : "false", HelloWorld::getPendingScore(),
+           (int)EnemyController::enemies.size(), (int)BulletController::getBulletSystem()->size(), stateHash(player));
+
+    root->onExit();
+    root->release();
+    return 0;
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "TimerBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace std::chrono;
+
+int runTimerBenchmark(int timers, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> interval(0.5f, 5.0f);
+    auto scheduler = new Scheduler();
+    std::vector<char> targets(timers);
+    long fired = 0;
+
+    //one shot that schedules the next one under the other key, like an explosion recycled and reused
+    std::function<void(void*, float, bool)> scheduleOnce;
+    scheduleOnce = [&](void* target, float delay, bool second){
+        scheduler->schedule([&, target, delay, second](float){
+            fired++;
+            scheduleOnce(target, delay, !second);
+        }, target, 0, 0, delay, false, second ? "recycle2" : "recycle");
+    };
+
+    for(int i = 0; i < timers; i++)
+    {
+        if(i % 2)
+            scheduler->schedule([&fired](float){ fired++; }, &targets[i], interval(random), false, "shoot"); //repeating, like FodderLeader::shoot
+        else
+            scheduleOnce(&targets[i], interval(random), false);
+    }
+
+    const int frames = 3600;
+    std::vector<double> times;
+    times.reserve(frames);
+    for(int i = 0; i < frames; i++)
+    {
+        auto start = high_resolution_clock::now();
+        scheduler->update(1/60.0f);
+        times.push_back(duration<double, std::micro>(high_resolution_clock::now()-start).count());
+    }
+    scheduler->release();
+
+    double sum = 0;
+    for(auto t : times)
+        sum += t;
+    std::sort(times.begin(), times.end());
+    printf("timers, frames, fired, mean us, p50 us, p99 us, max us\n");
+    printf("%d, %d, %ld, %.2f, %.2f, %.2f, %.2f\n", timers, frames, fired,
+           sum/frames, times[frames/2], times[frames*99/100], times.back());
+    return 0;
+}
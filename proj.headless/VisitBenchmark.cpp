@@ -0,0 +1,93 @@
+/****************************************************************************
+ Copyright (c) 2014 Chukong Technologies Inc.
+
+ http://github.com/chukong/EarthWarrior3D
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "VisitBenchmark.h"
+#include <chrono>
+
+using namespace std::chrono;
+
+static const int kWarmUpVisits = 10;
+static const int kTimedVisits = 100;
+
+int runVisitBenchmark(int layers, int sprites)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    auto director = Director::getInstance();
+    director->setOpenGLView(GLViewImpl::createWithRect("EarthWarrior3D visit benchmark", Rect(0, 0, 640, 960)));
+    auto renderer = director->getRenderer();
+    auto size = director->getWinSize();
+
+    auto root = Node::create();
+    root->retain();
+    root->setParallelVisit(true);
+    for(int l = 0; l < layers; l++)
+    {
+        //every layer is a top level subtree, its sprites hang off small groups like enemies with parts do
+        auto layer = Node::create();
+        root->addChild(layer);
+        for(int s = 0; s < sprites; s += 4)
+        {
+            auto group = Node::create();
+            group->setPosition(CCRANDOM_0_1()*size.width, CCRANDOM_0_1()*size.height);
+            group->setRotation(CCRANDOM_0_1()*360);
+            layer->addChild(group);
+            for(int p = s; p < std::min(s+4, sprites); p++)
+            {
+                auto sprite = Sprite::create();
+                sprite->setTextureRect(Rect(0, 0, 8, 8));
+                sprite->setPosition((p-s)*10, 0);
+                group->addChild(sprite);
+            }
+        }
+    }
+
+    printf("threads, visit us, speedup\n");
+    int helpers = renderer->getVisitThreads();
+    double serial = 0;
+    for(int threads = 1; threads <= 8; threads++)
+    {
+        renderer->setVisitThreads(threads-1);
+        double best = 0;
+        for(int i = 0; i < kWarmUpVisits+kTimedVisits; i++)
+        {
+            auto start = high_resolution_clock::now();
+            //a dirty transform flag makes every node recompute its model view, like a scene where everything moves
+            root->visit(renderer, Mat4::IDENTITY, Node::FLAGS_TRANSFORM_DIRTY);
+            double us = duration<double, std::micro>(high_resolution_clock::now()-start).count();
+            renderer->clean();
+            if(i >= kWarmUpVisits && (best == 0 || us < best))
+                best = us;
+        }
+        if(threads == 1)
+            serial = best;
+        printf("%d, %.1f, %.2f\n", threads, best, serial/best);
+    }
+    renderer->setVisitThreads(helpers);
+
+    root->release();
+    director->end();
+    director->mainLoop();
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "Benchmark.h"
+#include "RenderSortBenchmark.h"
+#include "VisitBenchmark.h"
+#include "TimerBenchmark.h"
+#include "ActionBenchmark.h"
+#include "ObjBenchmark.h"
+#include "BundleBenchmark.h"
+#include "CollisionBenchmark.h"
+#include "Simulation.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+USING_NS_CC;
+
+static void usage(const char* name)
+{
+    printf("usage: %s [--frames n] [--frame-time seconds] [--seed n] [--warmup seconds] [--input track.plist] [--output file.json] [--mortal] [--legacy-matrix-stack] [--no-instancing] [--sort] [--visit layers sprites] [--timers n] [--actions n] [--obj file.obj runs] [--c3b file.c3b runs] [--collision] [--simulate seconds] [--load] [--load-threads n] [--load-sync]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    bool sortOnly = false;
+    int visitLayers = 0;
+    int visitSprites = 0;
+    int timers = 0;
+    int actions = 0;
+    std::string objFile;
+    int objRuns = 0;
+    std::string c3bFile;
+    int c3bRuns = 0;
+    bool collision = false;
+    float simulateSeconds = 0;
+    bool loading = false;
+    for(int i = 1; i < argc; i++)
+    {
+        bool hasValue = i+1 < argc;
+        if(!strcmp(argv[i], "--frames") && hasValue)
+            options.frames = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--frame-time") && hasValue)
+            options.frameTime = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--seed") && hasValue)
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        else if(!strcmp(argv[i], "--warmup") && hasValue)
+            options.warmup = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--input") && hasValue)
+            options.input = argv[++i];
+        else if(!strcmp(argv[i], "--output") && hasValue)
+            options.output = argv[++i];
+        else if(!strcmp(argv[i], "--mortal"))
+            options.invincible = false;
+        else if(!strcmp(argv[i], "--legacy-matrix-stack"))
+            options.legacyMatrixStack = true;
+        else if(!strcmp(argv[i], "--no-instancing"))
+            options.instancing = false;
+        else if(!strcmp(argv[i], "--sort"))
+            sortOnly = true;
+        else if(!strcmp(argv[i], "--visit") && i+2 < argc)
+        {
+            visitLayers = atoi(argv[++i]);
+            visitSprites = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--timers") && hasValue)
+            timers = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--actions") && hasValue)
+            actions = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--obj") && i+2 < argc)
+        {
+            objFile = argv[++i];
+            objRuns = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--c3b") && i+2 < argc)
+        {
+            c3bFile = argv[++i];
+            c3bRuns = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--collision"))
+            collision = true;
+        else if(!strcmp(argv[i], "--simulate") && hasValue)
+            simulateSeconds = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--load"))
+            loading = true;
+        else if(!strcmp(argv[i], "--load-sync"))
+            loading = options.loadSync = true;
+        else if(!strcmp(argv[i], "--load-threads") && hasValue)
+            options.loadThreads = atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(sortOnly)
+        return runRenderSortBenchmark(options.seed);
+    if(visitLayers > 0)
+        return runVisitBenchmark(visitLayers, visitSprites);
+    if(timers > 0)
+        return runTimerBenchmark(timers, options.seed);
+    if(actions > 0)
+        return runActionBenchmark(actions, options.seed);
+    if(objRuns > 0)
+        return runObjBenchmark(objFile, objRuns);
+    if(c3bRuns > 0)
+        return runBundleBenchmark(c3bFile, c3bRuns);
+    if(collision)
+        return runCollisionBenchmark(options.seed);
+    if(simulateSeconds > 0)
+        return runSimulation(simulateSeconds, options);
+    // create the application instance
+    Benchmark app(options);
+    if(loading)
+        return app.runLoading();
+    return app.run();
+}